@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * LZSS stream format:
+ *
+ * The stream is a sequence of groups, each group starts with a flag byte followed by up to 8 items. Bit n of the flag
+ * byte (LSB first) describes item n: 1 for a literal byte, 0 for a match. A match is 2 bytes: the low byte of the
+ * distance - 1, followed by a byte with the upper 4 bits of the distance - 1 in the high nibble and the length -
+ * #LZSS_MATCH_LEN_MIN in the low nibble.
+ *
+ * A match may reach back into history: data that precedes the decoded block and is already present at the decoder,
+ * e.g. the flash pages of a firmware image that have already been written. This allows small blocks to be compressed
+ * against a large window without the decoder keeping a copy of that window in RAM.
+ */
+
+/** Bits used to encode the match distance. */
+#define LZSS_DISTANCE_BITS (12)
+/** Bits used to encode the match length. */
+#define LZSS_LENGTH_BITS (4)
+/** Largest distance of a match. */
+#define LZSS_WINDOW_SIZE (1 << LZSS_DISTANCE_BITS)
+/** Shortest match, shorter repetitions are encoded as literals. */
+#define LZSS_MATCH_LEN_MIN (3)
+/** Longest match. */
+#define LZSS_MATCH_LEN_MAX (LZSS_MATCH_LEN_MIN + (1 << LZSS_LENGTH_BITS) - 1)
+
+/** Largest compressed size of a block of n bytes, when none of the bytes can be matched. */
+#define LZSS_COMPRESSED_SIZE_MAX(n) ((n) + ((n) + 7) / 8)
+
+/**
+ * @brief Compress a block of data.
+ *
+ * The block is data[start] to data[start + len - 1]. The bytes before the block, up to #LZSS_WINDOW_SIZE of them, are
+ * history and must be present at the decoder when the block is decompressed.
+ *
+ * @param[in] data The history followed by the block to compress.
+ * @param[in] start The number of history bytes before the block.
+ * @param[in] len The size of the block.
+ * @param[out] dst The compressed block.
+ * @param[in] dst_size The size of the dst buffer.
+ *
+ * @return The size of the compressed block, 0 if it does not fit in dst.
+ */
+size_t lzss_compress(const uint8_t *data, size_t start, size_t len, uint8_t *dst, size_t dst_size);
+
+/**
+ * @brief Decompress a block of data.
+ *
+ * The history is the data that preceded the block when it was compressed, the last byte of the history is the byte
+ * right before the block. The history does not need to be in the same buffer as the block, e.g. it can be in flash
+ * while the block is decompressed in RAM.
+ *
+ * @param[in] src The compressed block.
+ * @param[in] src_size The size of the compressed block.
+ * @param[out] dst The decompressed block.
+ * @param[in] dst_size The size of the decompressed block.
+ * @param[in] history The data preceding the block, may be NULL if history_size is 0.
+ * @param[in] history_size The size of the history.
+ *
+ * @return true if exactly dst_size bytes were decompressed, false if the compressed block is invalid.
+ */
+bool lzss_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size, const uint8_t *history,
+                     size_t history_size);
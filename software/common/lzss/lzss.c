@@ -0,0 +1,140 @@
+#include "lzss.h"
+
+//======================================================================================================================
+//                                                  FUNCTION PROTOTYPES
+//======================================================================================================================
+
+static size_t lzss_match_find(const uint8_t *data, size_t pos, size_t end, size_t *distance);
+
+//======================================================================================================================
+//                                                   PUBLIC FUNCTIONS
+//======================================================================================================================
+
+size_t lzss_compress(const uint8_t *data, size_t start, size_t len, uint8_t *dst, size_t dst_size)
+{
+    const size_t end = start + len;
+    size_t out       = 0;
+    size_t flag_pos  = 0;
+    uint8_t item     = 8; /* Index of the next item in the current group, 8 to start a new group. */
+
+    for (size_t pos = start; pos < end;) {
+        /* Start a new group. */
+        if (item == 8) {
+            if (out >= dst_size) {
+                return 0;
+            }
+            flag_pos      = out++;
+            dst[flag_pos] = 0;
+            item          = 0;
+        }
+
+        size_t distance = 0;
+        size_t match    = lzss_match_find(data, pos, end, &distance);
+
+        if (match >= LZSS_MATCH_LEN_MIN) {
+            if (out + 2 > dst_size) {
+                return 0;
+            }
+            dst[out++] = (distance - 1) & 0xFF;
+            dst[out++] = ((distance - 1) >> 8) << LZSS_LENGTH_BITS | (match - LZSS_MATCH_LEN_MIN);
+            pos += match;
+        } else {
+            if (out + 1 > dst_size) {
+                return 0;
+            }
+            dst[flag_pos] |= 1 << item;
+            dst[out++] = data[pos++];
+        }
+        item++;
+    }
+
+    return out;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool lzss_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size, const uint8_t *history,
+                     size_t history_size)
+{
+    size_t in  = 0;
+    size_t out = 0;
+
+    while (out < dst_size) {
+        if (in >= src_size) {
+            return false; /* Truncated. */
+        }
+        uint8_t flags = src[in++];
+
+        for (uint8_t item = 0; item < 8 && out < dst_size; item++) {
+            if (flags & (1 << item)) {
+                if (in >= src_size) {
+                    return false;
+                }
+                dst[out++] = src[in++];
+                continue;
+            }
+
+            if (in + 2 > src_size) {
+                return false;
+            }
+            size_t distance = ((size_t)(src[in + 1] >> LZSS_LENGTH_BITS) << 8 | src[in]) + 1;
+            size_t match    = (src[in + 1] & ((1 << LZSS_LENGTH_BITS) - 1)) + LZSS_MATCH_LEN_MIN;
+            in += 2;
+
+            if (distance > out + history_size || out + match > dst_size) {
+                return false; /* Reaches before the history or past the end of the block. */
+            }
+
+            /* Copy byte by byte, a match may overlap with its own output. */
+            for (size_t i = 0; i < match; i++, out++) {
+                dst[out] = distance <= out ? dst[out - distance] : history[history_size - (distance - out)];
+            }
+        }
+    }
+
+    /* Trailing data means the block was not compressed with this size. */
+    return in == src_size;
+}
+
+//======================================================================================================================
+//                                                   PRIVATE FUNCTIONS
+//======================================================================================================================
+
+/**
+ * @brief Find the longest match for the data at a position.
+ *
+ * The window is searched from the nearest to the farthest position, so the nearest of equally long matches is used.
+ *
+ * @param[in] data The data.
+ * @param[in] pos The position to find a match for.
+ * @param[in] end The end of the block, matches don't extend beyond it.
+ * @param[out] distance The distance to the match.
+ *
+ * @return The length of the longest match.
+ */
+static size_t lzss_match_find(const uint8_t *data, size_t pos, size_t end, size_t *distance)
+{
+    size_t len_max  = end - pos < LZSS_MATCH_LEN_MAX ? end - pos : LZSS_MATCH_LEN_MAX;
+    size_t dist_max = pos < LZSS_WINDOW_SIZE ? pos : LZSS_WINDOW_SIZE;
+    size_t best     = 0;
+
+    for (size_t dist = 1; dist <= dist_max && best < len_max; dist++) {
+        const uint8_t *candidate = data + pos - dist;
+
+        /* Quickly reject candidates that can't be longer than the best match. */
+        if (candidate[best] != data[pos + best] || candidate[0] != data[pos]) {
+            continue;
+        }
+
+        size_t len = 1;
+        while (len < len_max && candidate[len] == data[pos + len]) {
+            len++;
+        }
+        if (len > best) {
+            best      = len;
+            *distance = dist;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,125 @@
+/**
+ * Compression ratio and speed of firmware images, compressed page by page the same way the module OTA does.
+ *
+ * Usage: lzss_benchmark <firmware.bin>...
+ */
+
+#include "lzss.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCHMARK_PAGE_SIZE      (128) /* Flash page size of the module. */
+#define BENCHMARK_DECOMPRESS_CNT (100) /* Decompress the image multiple times to get a measurable duration. */
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static double benchmark_time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static int benchmark_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    /* The last page is padded with the erased flash value, like the controller does. */
+    size_t page_cnt     = (file_size + BENCHMARK_PAGE_SIZE - 1) / BENCHMARK_PAGE_SIZE;
+    size_t image_size   = page_cnt * BENCHMARK_PAGE_SIZE;
+    uint8_t *image      = malloc(image_size);
+    uint8_t *decoded    = malloc(image_size);
+    uint8_t *compressed = malloc(page_cnt * BENCHMARK_PAGE_SIZE);
+    size_t *page_size   = calloc(page_cnt, sizeof(size_t));
+    int ret             = 1;
+    if (image == NULL || decoded == NULL || compressed == NULL || page_size == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        fclose(file);
+        goto exit;
+    }
+    memset(image, 0xFF, image_size);
+    size_t read_size = fread(image, 1, file_size, file);
+    fclose(file);
+    if (read_size != file_size) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        goto exit;
+    }
+
+    /* Pages that don't get smaller are sent uncompressed. */
+    size_t compressed_size = 0;
+    size_t raw_page_cnt    = 0;
+    double start           = benchmark_time_s();
+    for (size_t page = 0; page < page_cnt; page++) {
+        uint8_t *dst    = compressed + page * BENCHMARK_PAGE_SIZE;
+        page_size[page] = lzss_compress(image, page * BENCHMARK_PAGE_SIZE, BENCHMARK_PAGE_SIZE, dst,
+                                        BENCHMARK_PAGE_SIZE - 1);
+        if (page_size[page] == 0) {
+            raw_page_cnt++;
+        }
+        compressed_size += page_size[page] ? page_size[page] : BENCHMARK_PAGE_SIZE;
+    }
+    double compress_s = benchmark_time_s() - start;
+
+    /* Each page is decompressed against the pages before it, like the module does with its flash. */
+    start = benchmark_time_s();
+    for (int i = 0; i < BENCHMARK_DECOMPRESS_CNT; i++) {
+        for (size_t page = 0; page < page_cnt; page++) {
+            uint8_t *dst = decoded + page * BENCHMARK_PAGE_SIZE;
+            if (page_size[page] == 0) {
+                memcpy(dst, image + page * BENCHMARK_PAGE_SIZE, BENCHMARK_PAGE_SIZE);
+            } else if (!lzss_decompress(compressed + page * BENCHMARK_PAGE_SIZE, page_size[page], dst,
+                                        BENCHMARK_PAGE_SIZE, decoded, page * BENCHMARK_PAGE_SIZE)) {
+                fprintf(stderr, "Failed to decompress page %zu of %s\n", page, path);
+                goto exit;
+            }
+        }
+    }
+    double decompress_s = (benchmark_time_s() - start) / BENCHMARK_DECOMPRESS_CNT;
+
+    if (memcmp(image, decoded, image_size) != 0) {
+        fprintf(stderr, "Decompressed image differs from %s\n", path);
+        goto exit;
+    }
+
+    printf("%s, %zu, %zu, %zu, %.3f, %zu, %.2f, %.2f\n", path, image_size, page_cnt, compressed_size,
+           (double)compressed_size / image_size, raw_page_cnt, image_size / compress_s / 1e6,
+           image_size / decompress_s / 1e6);
+    ret = 0;
+
+exit:
+    free(image);
+    free(decoded);
+    free(compressed);
+    free(page_size);
+    return ret;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <firmware.bin>...\n", argv[0]);
+        return 1;
+    }
+
+    printf("file, size, pages, compressed_size, ratio, raw_pages, compress_MBps, decompress_MBps\n");
+    int ret = 0;
+    for (int i = 1; i < argc; i++) {
+        ret |= benchmark_file(argv[i]);
+    }
+
+    return ret;
+}
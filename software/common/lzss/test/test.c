@@ -0,0 +1,159 @@
+#include "lzss.h"
+
+#include "unity.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_PAGE_SIZE (128)
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void setUp(void)
+{
+    // This function is called before each test
+}
+
+void tearDown(void)
+{
+    // This function is called after each test
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/* Compress data[start..start+len) and check that it decompresses to the same data. Returns the compressed size. */
+static size_t round_trip(const uint8_t *data, size_t start, size_t len)
+{
+    uint8_t compressed[LZSS_COMPRESSED_SIZE_MAX(4 * TEST_PAGE_SIZE)];
+    uint8_t decompressed[4 * TEST_PAGE_SIZE];
+
+    size_t size = lzss_compress(data, start, len, compressed, sizeof(compressed));
+    TEST_ASSERT_NOT_EQUAL(0, size);
+    TEST_ASSERT_TRUE(lzss_decompress(compressed, size, decompressed, len, data, start));
+    TEST_ASSERT_EQUAL_MEMORY(data + start, decompressed, len);
+
+    return size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void test_lzss_literals(void)
+{
+    const uint8_t data[] = "abcdefgh01234567xyz";
+
+    /* Nothing repeats, every byte is a literal. */
+    TEST_ASSERT_EQUAL(LZSS_COMPRESSED_SIZE_MAX(sizeof(data)), round_trip(data, 0, sizeof(data)));
+}
+
+void test_lzss_run(void)
+{
+    uint8_t data[TEST_PAGE_SIZE];
+    memset(data, 0xFF, sizeof(data));
+
+    /* One literal, followed by overlapping matches of the maximum length. */
+    size_t size = round_trip(data, 0, sizeof(data));
+    TEST_ASSERT_LESS_THAN(TEST_PAGE_SIZE / 4, size);
+}
+
+void test_lzss_history(void)
+{
+    uint8_t data[2 * TEST_PAGE_SIZE];
+    for (size_t i = 0; i < TEST_PAGE_SIZE; i++) {
+        data[i]                  = rand();
+        data[i + TEST_PAGE_SIZE] = data[i];
+    }
+
+    /* The second page is a copy of the first, it is encoded as matches into the history. */
+    size_t with_history    = round_trip(data, TEST_PAGE_SIZE, TEST_PAGE_SIZE);
+    size_t without_history = round_trip(data + TEST_PAGE_SIZE, 0, TEST_PAGE_SIZE);
+    TEST_ASSERT_LESS_THAN(TEST_PAGE_SIZE / 4, with_history);
+    TEST_ASSERT_GREATER_THAN(TEST_PAGE_SIZE, without_history);
+}
+
+void test_lzss_history_in_other_buffer(void)
+{
+    uint8_t history[TEST_PAGE_SIZE];
+    uint8_t data[2 * TEST_PAGE_SIZE];
+    uint8_t compressed[LZSS_COMPRESSED_SIZE_MAX(TEST_PAGE_SIZE)];
+    uint8_t decompressed[TEST_PAGE_SIZE];
+
+    for (size_t i = 0; i < TEST_PAGE_SIZE; i++) {
+        history[i]               = rand();
+        data[i]                  = history[i];
+        data[i + TEST_PAGE_SIZE] = (i % 3) ? history[TEST_PAGE_SIZE - 1 - i] : i;
+    }
+
+    /* Matches are split between the history in one buffer and the block in another. */
+    size_t size = lzss_compress(data, TEST_PAGE_SIZE, TEST_PAGE_SIZE, compressed, sizeof(compressed));
+    TEST_ASSERT_NOT_EQUAL(0, size);
+    TEST_ASSERT_TRUE(lzss_decompress(compressed, size, decompressed, TEST_PAGE_SIZE, history, sizeof(history)));
+    TEST_ASSERT_EQUAL_MEMORY(data + TEST_PAGE_SIZE, decompressed, TEST_PAGE_SIZE);
+}
+
+void test_lzss_window(void)
+{
+    static uint8_t data[LZSS_WINDOW_SIZE + 2 * TEST_PAGE_SIZE];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+
+    /* A copy of the first page is out of reach when it is more than a window away. */
+    memcpy(data + LZSS_WINDOW_SIZE + TEST_PAGE_SIZE, data, TEST_PAGE_SIZE);
+    TEST_ASSERT_GREATER_THAN(TEST_PAGE_SIZE, round_trip(data, LZSS_WINDOW_SIZE + TEST_PAGE_SIZE, TEST_PAGE_SIZE));
+
+    /* A copy at exactly the window size is in reach. */
+    memcpy(data + LZSS_WINDOW_SIZE, data, TEST_PAGE_SIZE);
+    TEST_ASSERT_LESS_THAN(TEST_PAGE_SIZE / 4, round_trip(data, LZSS_WINDOW_SIZE, TEST_PAGE_SIZE));
+}
+
+void test_lzss_compress_dst_too_small(void)
+{
+    uint8_t data[TEST_PAGE_SIZE];
+    uint8_t compressed[TEST_PAGE_SIZE];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+
+    TEST_ASSERT_EQUAL(0, lzss_compress(data, 0, sizeof(data), compressed, sizeof(compressed)));
+}
+
+void test_lzss_decompress_invalid(void)
+{
+    uint8_t data[TEST_PAGE_SIZE];
+    uint8_t compressed[LZSS_COMPRESSED_SIZE_MAX(TEST_PAGE_SIZE)];
+    uint8_t decompressed[TEST_PAGE_SIZE];
+    memset(data, 0xA5, sizeof(data));
+
+    size_t size = lzss_compress(data, 0, sizeof(data), compressed, sizeof(compressed));
+
+    /* Truncated. */
+    TEST_ASSERT_FALSE(lzss_decompress(compressed, size - 1, decompressed, sizeof(decompressed), NULL, 0));
+
+    /* Trailing data. */
+    TEST_ASSERT_FALSE(lzss_decompress(compressed, size + 1, decompressed, sizeof(decompressed), NULL, 0));
+
+    /* Too short for the decompressed size. */
+    TEST_ASSERT_FALSE(lzss_decompress(compressed, size, decompressed, sizeof(decompressed) - 1, NULL, 0));
+
+    /* A match into history that is not there. */
+    const uint8_t match_only[] = {0x00, 0x0F, 0x00};
+    TEST_ASSERT_FALSE(lzss_decompress(match_only, sizeof(match_only), decompressed, 3, NULL, 0));
+    TEST_ASSERT_TRUE(lzss_decompress(match_only, sizeof(match_only), decompressed, 3, data, 16));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_lzss_literals);
+    RUN_TEST(test_lzss_run);
+    RUN_TEST(test_lzss_history);
+    RUN_TEST(test_lzss_history_in_other_buffer);
+    RUN_TEST(test_lzss_window);
+    RUN_TEST(test_lzss_compress_dst_too_small);
+    RUN_TEST(test_lzss_decompress_invalid);
+
+    return UNITY_END();
+}
@@ -4,21 +4,31 @@
 
 #define OF_MDL_PROP_UNDEFINED (mdl_prop_id_t)(-1) /**< Undefined property ID. */
 
-#define OF_MDL_PROP_FIRMWARE_VERSION (mdl_prop_id_t)(0)
-#define OF_MDL_PROP_FIRMWARE_UPDATE  (mdl_prop_id_t)(1)
-#define OF_MDL_PROP_COMMAND          (mdl_prop_id_t)(2)
-#define OF_MDL_PROP_MODULE_INFO      (mdl_prop_id_t)(3)
-#define OF_MDL_PROP_CHARACTER_SET    (mdl_prop_id_t)(4)
-#define OF_MDL_PROP_CHARACTER        (mdl_prop_id_t)(5)
-#define OF_MDL_PROP_OFFSET           (mdl_prop_id_t)(6)
-#define OF_MDL_PROP_COLOR            (mdl_prop_id_t)(7)
-#define OF_MDL_PROP_MOTION           (mdl_prop_id_t)(8)
-#define OF_MDL_PROP_MINIMUM_ROTATION (mdl_prop_id_t)(9)
-#define OF_MDL_PROP_IR_THRESHOLD     (mdl_prop_id_t)(10)
-
-#define OF_MDL_PROP_CNT (11) /** Total number of properties. */
-
-#define OF_FIRMWARE_UPDATE_PAGE_SIZE 128 /**< Size of a firmware update page in bytes. */
+#define OF_MDL_PROP_FIRMWARE_VERSION  (mdl_prop_id_t)(0)
+#define OF_MDL_PROP_FIRMWARE_UPDATE   (mdl_prop_id_t)(1)
+#define OF_MDL_PROP_COMMAND           (mdl_prop_id_t)(2)
+#define OF_MDL_PROP_MODULE_INFO       (mdl_prop_id_t)(3)
+#define OF_MDL_PROP_CHARACTER_SET     (mdl_prop_id_t)(4)
+#define OF_MDL_PROP_CHARACTER         (mdl_prop_id_t)(5)
+#define OF_MDL_PROP_OFFSET            (mdl_prop_id_t)(6)
+#define OF_MDL_PROP_COLOR             (mdl_prop_id_t)(7)
+#define OF_MDL_PROP_MOTION            (mdl_prop_id_t)(8)
+#define OF_MDL_PROP_MINIMUM_ROTATION  (mdl_prop_id_t)(9)
+#define OF_MDL_PROP_IR_THRESHOLD      (mdl_prop_id_t)(10)
+#define OF_MDL_PROP_BAUD_RATE         (mdl_prop_id_t)(11)
+#define OF_MDL_PROP_FIRMWARE_PAGE_CRC (mdl_prop_id_t)(12)
+#define OF_MDL_PROP_FIRMWARE_LZ_PAGE  (mdl_prop_id_t)(13)
+#define OF_MDL_PROP_FIRMWARE_BURST    (mdl_prop_id_t)(14)
+
+#define OF_MDL_PROP_CNT (15) /** Total number of properties. */
+
+#define OF_FIRMWARE_UPDATE_PAGE_SIZE  128 /**< Size of a firmware update page in bytes. */
+#define OF_FIRMWARE_PAGE_CRC_CNT      16  /**< Number of page CRCs returned by a firmware page CRC read. */
+#define OF_FIRMWARE_REGION_MAIN_APP   0   /**< Firmware region of the running application. */
+#define OF_FIRMWARE_REGION_NEW_APP    1   /**< Firmware region which receives firmware updates. */
+#define OF_FIRMWARE_BURST_HEADER_SIZE 2   /**< Size of the first page index in a firmware burst. */
+
+#define OF_BAUD_RATE_DEFAULT 115200 /**< Baud rate of the chain after boot and after a fallback. */
 
 // clang-format off
 #define OF_PROP_CMD_GENERATOR(GENERATOR)                                                                               \
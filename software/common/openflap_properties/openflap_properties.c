@@ -3,17 +3,21 @@
 #include <string.h>
 
 mdl_prop_t mdl_prop_list[OF_MDL_PROP_CNT] = {
-    [OF_MDL_PROP_FIRMWARE_VERSION] = {.attribute = {.name = "firmware_version"}},
-    [OF_MDL_PROP_FIRMWARE_UPDATE]  = {.attribute = {.name = "firmware_update"}},
-    [OF_MDL_PROP_COMMAND]          = {.attribute = {.name = "command"}},
-    [OF_MDL_PROP_MODULE_INFO]      = {.attribute = {.name = "module_info"}},
-    [OF_MDL_PROP_CHARACTER_SET]    = {.attribute = {.name = "character_set"}},
-    [OF_MDL_PROP_CHARACTER]        = {.attribute = {.name = "character"}},
-    [OF_MDL_PROP_OFFSET]           = {.attribute = {.name = "offset"}},
-    [OF_MDL_PROP_COLOR]            = {.attribute = {.name = "color"}},
-    [OF_MDL_PROP_MOTION]           = {.attribute = {.name = "motion"}},
-    [OF_MDL_PROP_MINIMUM_ROTATION] = {.attribute = {.name = "minimum_rotation"}},
-    [OF_MDL_PROP_IR_THRESHOLD]     = {.attribute = {.name = "ir_threshold"}},
+    [OF_MDL_PROP_FIRMWARE_VERSION]  = {.attribute = {.name = "firmware_version"}},
+    [OF_MDL_PROP_FIRMWARE_UPDATE]   = {.attribute = {.name = "firmware_update"}},
+    [OF_MDL_PROP_COMMAND]           = {.attribute = {.name = "command"}},
+    [OF_MDL_PROP_MODULE_INFO]       = {.attribute = {.name = "module_info"}},
+    [OF_MDL_PROP_CHARACTER_SET]     = {.attribute = {.name = "character_set"}},
+    [OF_MDL_PROP_CHARACTER]         = {.attribute = {.name = "character"}},
+    [OF_MDL_PROP_OFFSET]            = {.attribute = {.name = "offset"}},
+    [OF_MDL_PROP_COLOR]             = {.attribute = {.name = "color"}},
+    [OF_MDL_PROP_MOTION]            = {.attribute = {.name = "motion"}},
+    [OF_MDL_PROP_MINIMUM_ROTATION]  = {.attribute = {.name = "minimum_rotation"}},
+    [OF_MDL_PROP_IR_THRESHOLD]      = {.attribute = {.name = "ir_threshold"}},
+    [OF_MDL_PROP_BAUD_RATE]         = {.attribute = {.name = "baud_rate"}},
+    [OF_MDL_PROP_FIRMWARE_PAGE_CRC] = {.attribute = {.name = "firmware_page_crc"}},
+    [OF_MDL_PROP_FIRMWARE_LZ_PAGE]  = {.attribute = {.name = "firmware_lz_page"}},
+    [OF_MDL_PROP_FIRMWARE_BURST]    = {.attribute = {.name = "firmware_burst"}},
 };
 
 static const char *of_cmd_prop_cmd_names[CMD_MAX] = {OF_PROP_CMD_GENERATOR(GENERATE_2ND_FIELD)};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#include <stdbool.h>
+
+/** Content type of the binary module API. */
+#define MODULE_API_BIN_CONTENT_TYPE "application/octet-stream"
+
+/**
+ * \brief Check if a request uses the binary module API.
+ *
+ * \param[in] req The HTTP request.
+ * \param[in] header The header which selects the content type, "Accept" for a GET and "Content-Type" for a POST.
+ *
+ * \return true if the header contains #MODULE_API_BIN_CONTENT_TYPE.
+ */
+bool module_api_bin_requested(httpd_req_t *req, const char *header);
+
+/**
+ * \brief Send the properties of all modules in the binary format.
+ *
+ * The caller refreshes the display first, like for the JSON format.
+ *
+ * \param[in] req The HTTP request.
+ */
+esp_err_t module_api_bin_get_handler(httpd_req_t *req);
+
+/**
+ * \brief Update the properties of modules from a request in the binary format.
+ *
+ * \param[in] req The HTTP request.
+ */
+esp_err_t module_api_bin_post_handler(httpd_req_t *req);
\ No newline at end of file
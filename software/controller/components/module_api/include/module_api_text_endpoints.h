@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+esp_err_t module_api_text_post_handler(httpd_req_t *req);
\ No newline at end of file
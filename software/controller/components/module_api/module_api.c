@@ -3,11 +3,13 @@
 #include "esp_log.h"
 #include "module_api_endpoints.h"
 #include "module_api_firmware_endpoints.h"
+#include "module_api_text_endpoints.h"
 
 #define TAG "module_api"
 
 #define MODULE_API_URI          "/module"              /**< module endpoint. */
 #define MODULE_FIRMWARE_API_URI "/module/firmware.bin" /**< module firmware endpoint. */
+#define MODULE_TEXT_API_URI     "/text"                /**< text endpoint. */
 
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -32,5 +34,13 @@ esp_err_t module_api_init(webserver_ctx_t *webserver_ctx, of_display_t *display)
                                                    &module_api_firmware_handlers, true, display),
                         TAG, "Failed to add endpoint for %s", MODULE_FIRMWARE_API_URI);
 
+    webserver_api_method_handlers_t module_api_text_handlers = {
+        .post_handler = module_api_text_post_handler,
+    };
+
+    ESP_RETURN_ON_ERROR(webserver_api_endpoint_add(webserver_ctx, MODULE_TEXT_API_URI, &module_api_text_handlers, true,
+                                                   display),
+                        TAG, "Failed to add endpoint for %s", MODULE_TEXT_API_URI);
+
     return ESP_OK;
 }
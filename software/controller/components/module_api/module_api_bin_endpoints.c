@@ -0,0 +1,291 @@
+#include "module_api_bin_endpoints.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "openflap_display.h"
+#include "openflap_module.h"
+#include "openflap_properties.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "MODULE_BIN_ENDPOINTS"
+
+/**
+ * Size of the header of a property entry:
+ * - module index: 2 bytes, little endian
+ * - property id: 1 byte, see openflap_properties.h
+ * - payload size: 2 bytes, little endian
+ *
+ * The payload has the same format as the property on the chain.
+ */
+#define MODULE_API_BIN_ENTRY_HEADER_SIZE (5)
+
+/** Size of the largest property entry. */
+#define MODULE_API_BIN_ENTRY_SIZE_MAX (MODULE_API_BIN_ENTRY_HEADER_SIZE + MDL_PAYLOAD_SIZE_MAX)
+
+/** Size of the chunks in which the response is sent. */
+#define MODULE_API_BIN_CHUNK_SIZE (4 * MODULE_API_BIN_ENTRY_SIZE_MAX)
+
+/** Length of the header values which select the content type. */
+#define MODULE_API_BIN_HEADER_LEN_MAX (128)
+
+static esp_err_t module_api_bin_recv(httpd_req_t *req, uint8_t *buf, size_t size);
+static void module_api_bin_entry_apply(of_display_t *display, uint16_t module_index, mdl_prop_id_t prop_id,
+                                       uint8_t *payload, size_t payload_size);
+static bool module_api_bin_payload_is_valid(const module_t *module, mdl_prop_id_t prop_id, const uint8_t *payload,
+                                            size_t payload_size);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool module_api_bin_requested(httpd_req_t *req, const char *header)
+{
+    char value[MODULE_API_BIN_HEADER_LEN_MAX];
+
+    /* A truncated Accept header still starts with the preferred content types. */
+    esp_err_t err = httpd_req_get_hdr_value_str(req, header, value, sizeof(value));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+
+    return strstr(value, MODULE_API_BIN_CONTENT_TYPE) != NULL;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t module_api_bin_get_handler(httpd_req_t *req)
+{
+    of_display_t *display = (of_display_t *)req->user_ctx;
+
+    uint8_t *chunk = malloc(MODULE_API_BIN_CHUNK_SIZE);
+    if (chunk == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the response");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+    size_t chunk_size = 0;
+
+    httpd_resp_set_type(req, MODULE_API_BIN_CONTENT_TYPE);
+
+    /* The same properties as in the JSON format, as far as they can be serialized to the chain format. */
+    esp_err_t err = ESP_OK;
+    for (uint16_t i = 0; i < display_size_get(display) && err == ESP_OK; i++) {
+        uint16_t node_idx;
+        of_display_chain_t *chain = display_module_chain_get(display, i, &node_idx);
+
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT && err == ESP_OK; prop_id++) {
+            if (mdl_prop_list[prop_id].handler.get_alt == NULL || mdl_prop_list[prop_id].handler.get == NULL) {
+                continue;
+            }
+
+            /* Send the chunk when the largest entry no longer fits. */
+            if (chunk_size + MODULE_API_BIN_ENTRY_SIZE_MAX > MODULE_API_BIN_CHUNK_SIZE) {
+                err        = httpd_resp_send_chunk(req, (const char *)chunk, chunk_size);
+                chunk_size = 0;
+            }
+
+            /* Serialization fails if the module has been removed since its chain was looked up. The model is serialized
+             * rather than a broadcast of the most common value which may be in progress. */
+            uint8_t *entry      = &chunk[chunk_size];
+            uint8_t *payload    = &entry[MODULE_API_BIN_ENTRY_HEADER_SIZE];
+            size_t payload_size = 0;
+            if (!display_chain_module_to_bin(chain, node_idx, prop_id, payload, &payload_size)) {
+                ESP_LOGE(TAG, "Property \"%s\" is invalid.", mdl_prop_list[prop_id].attribute.name);
+                continue;
+            }
+
+            entry[0] = i & 0xFF;
+            entry[1] = i >> 8;
+            entry[2] = prop_id;
+            entry[3] = payload_size & 0xFF;
+            entry[4] = payload_size >> 8;
+            chunk_size += MODULE_API_BIN_ENTRY_HEADER_SIZE + payload_size;
+        }
+    }
+
+    /* Send the last chunk and end the response. */
+    if (err == ESP_OK && chunk_size > 0) {
+        err = httpd_resp_send_chunk(req, (const char *)chunk, chunk_size);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    free(chunk);
+
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to send the response");
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t module_api_bin_post_handler(httpd_req_t *req)
+{
+    of_display_t *display = (of_display_t *)req->user_ctx;
+
+    ESP_LOGI(TAG, "POST data length: %zu", req->content_len);
+
+    uint8_t *entry = malloc(MODULE_API_BIN_ENTRY_SIZE_MAX);
+    if (entry == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for POST data");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    /* Apply the entries one by one, the body is never held in memory as a whole. */
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+        if (remaining < MODULE_API_BIN_ENTRY_HEADER_SIZE) {
+            ESP_LOGE(TAG, "Truncated entry");
+            free(entry);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Truncated entry");
+            return ESP_FAIL;
+        }
+        if (module_api_bin_recv(req, entry, MODULE_API_BIN_ENTRY_HEADER_SIZE) != ESP_OK) {
+            free(entry);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+            return ESP_FAIL;
+        }
+        remaining -= MODULE_API_BIN_ENTRY_HEADER_SIZE;
+
+        uint16_t module_index = entry[0] | (entry[1] << 8);
+        mdl_prop_id_t prop_id = entry[2];
+        size_t payload_size   = entry[3] | (entry[4] << 8);
+        if (payload_size > MDL_PAYLOAD_SIZE_MAX || payload_size > remaining) {
+            ESP_LOGE(TAG, "Invalid payload size %zu", payload_size);
+            free(entry);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid payload size");
+            return ESP_FAIL;
+        }
+
+        uint8_t *payload = &entry[MODULE_API_BIN_ENTRY_HEADER_SIZE];
+        if (module_api_bin_recv(req, payload, payload_size) != ESP_OK) {
+            free(entry);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+            return ESP_FAIL;
+        }
+        remaining -= payload_size;
+
+        display_lock(display);
+        module_api_bin_entry_apply(display, module_index, prop_id, payload, payload_size);
+        display_unlock(display);
+    }
+
+    /* Gracefully exit. */
+    free(entry);
+    httpd_resp_sendstr(req, "OK");
+
+    /* Notify that we have updated the display modules. */
+    of_display_synchronize(display, 0);
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Receive an exact number of bytes of the request body.
+ *
+ * \param[in] req The HTTP request.
+ * \param[out] buf The received bytes.
+ * \param[in] size The number of bytes to receive.
+ *
+ * \retval ESP_OK The bytes have been received.
+ * \retval ESP_FAIL The connection failed.
+ */
+static esp_err_t module_api_bin_recv(httpd_req_t *req, uint8_t *buf, size_t size)
+{
+    for (size_t total_len = 0, recv_len = 0; total_len < size; total_len += recv_len) {
+        int ret = httpd_req_recv(req, (char *)buf + total_len, size - total_len);
+        ESP_RETURN_ON_FALSE(ret > 0, ESP_FAIL, TAG, "Failed to receive POST data");
+        recv_len = ret;
+    }
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Update a property of a module from its chain format.
+ *
+ * Invalid entries are skipped, like invalid properties of the JSON format. The payload is validated here because the
+ * chain format handlers trust the size and the values reported by the modules.
+ *
+ * \param[in] display The display.
+ * \param[in] module_index The index of the module on the display.
+ * \param[in] prop_id The id of the property.
+ * \param[in] payload The property in the chain format.
+ * \param[in] payload_size The size of the payload.
+ */
+static void module_api_bin_entry_apply(of_display_t *display, uint16_t module_index, mdl_prop_id_t prop_id,
+                                       uint8_t *payload, size_t payload_size)
+{
+    /* Only the properties which can be written in the JSON format can be written. */
+    if (prop_id >= OF_MDL_PROP_CNT || mdl_prop_list[prop_id].handler.set_alt == NULL ||
+        mdl_prop_list[prop_id].handler.set == NULL) {
+        ESP_LOGE(TAG, "Property %d is not writable.", prop_id);
+        return;
+    }
+
+    uint16_t node_idx;
+    of_display_chain_t *chain = display_module_chain_get(display, module_index, &node_idx);
+    if (chain == NULL) {
+        ESP_LOGE(TAG, "Display does not contain module with index %d", module_index);
+        return;
+    }
+
+    module_t *module = display_chain_module_get(chain, node_idx);
+    if (!module_api_bin_payload_is_valid(module, prop_id, payload, payload_size) ||
+        !mdl_prop_list[prop_id].handler.set(chain, node_idx, payload, &payload_size)) {
+        ESP_LOGE(TAG, "Property \"%s\" is invalid.", mdl_prop_list[prop_id].attribute.name);
+        return;
+    }
+
+    /* Indicate that the property needs to be written to the actual module. */
+    module_property_indicate_desynchronized(module, prop_id);
+    display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_WRITE);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Check that a payload is a valid value for a property of a module.
+ *
+ * The payload must have the size of the property in the chain format, and is limited to the values that the JSON
+ * format accepts.
+ *
+ * \param[in] module The module to update.
+ * \param[in] prop_id The id of the property.
+ * \param[in] payload The property in the chain format.
+ * \param[in] payload_size The size of the payload.
+ *
+ * \return true if the payload is valid, false otherwise.
+ */
+static bool module_api_bin_payload_is_valid(const module_t *module, mdl_prop_id_t prop_id, const uint8_t *payload,
+                                            size_t payload_size)
+{
+    /* A module has no character set until it has been read, the JSON format rejects its characters as well. */
+    if ((prop_id == OF_MDL_PROP_CHARACTER_SET || prop_id == OF_MDL_PROP_CHARACTER) && module->character_set == NULL) {
+        return false;
+    }
+
+    switch (prop_id) {
+        case OF_MDL_PROP_CHARACTER_SET:
+            /* The size of the character set is reported by the module, 4 bytes per character. */
+            return payload_size == module->character_set->size * 4;
+        case OF_MDL_PROP_CHARACTER:
+            return payload_size == 1 && payload[0] < module->character_set->size;
+        case OF_MDL_PROP_OFFSET:
+        case OF_MDL_PROP_MINIMUM_ROTATION:
+            return payload_size == 1;
+        case OF_MDL_PROP_COLOR:
+            return payload_size == 6;
+        case OF_MDL_PROP_MOTION:
+            return payload_size == 4;
+        case OF_MDL_PROP_IR_THRESHOLD:
+            /* Big endian lower and upper threshold. */
+            return payload_size == 4 && (payload[2] << 8 | payload[3]) <= 1024 &&
+                   (payload[0] << 8 | payload[1]) < (payload[2] << 8 | payload[3]);
+        default:
+            return false;
+    }
+}
@@ -3,186 +3,440 @@
 #include "cJSON.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "module_api_bin_endpoints.h"
 #include "module_api_endpoints.h"
 #include "openflap_display.h"
 #include "openflap_module.h"
 #include "openflap_properties.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
 #define MODULE_INDEX_KEY_STR "module"
+#define MAX_AGE_QUERY_KEY_STR "max_age"
+
+#define QUERY_STR_LEN_MAX (64)
+#define MAX_AGE_STR_LEN_MAX (12)
+
+/** Size of the buffer in which each module is printed, most modules fit in a single chunk. */
+#define MODULE_JSON_CHUNK_SIZE (1024)
+
+/** Size of the socket reads of a POST request. */
+#define MODULE_JSON_RECV_SIZE (512)
+
+/** Size of the largest module object of a POST request, a full character set with escaped characters fits. */
+#define MODULE_JSON_OBJECT_SIZE_MAX (4096)
 
 #define TAG "MODULE_ENDPOINTS"
 
-esp_err_t module_api_get_handler(httpd_req_t *req)
+/**
+ * \brief State of the splitter of a POST request.
+ */
+typedef enum {
+    MODULE_JSON_SPLIT_START,  /**< Waiting for the opening bracket of the array. */
+    MODULE_JSON_SPLIT_ARRAY,  /**< Between the modules of the array. */
+    MODULE_JSON_SPLIT_MODULE, /**< Inside a module object. */
+    MODULE_JSON_SPLIT_END,    /**< After the closing bracket of the array. */
+} module_json_split_state_t;
+
+/**
+ * \brief Splitter of the array of a POST request into module objects.
+ *
+ * The body is received in chunks, each module object is parsed as soon as it is complete.
+ */
+typedef struct {
+    module_json_split_state_t state; /**< State of the splitter. */
+    uint16_t depth;                  /**< Nesting depth of objects and arrays inside the module object. */
+    bool in_string;                  /**< Inside a string of the module object. */
+    bool escape;                     /**< The previous character of the string is a backslash. */
+    char *object;                    /**< The module object, of #MODULE_JSON_OBJECT_SIZE_MAX bytes. */
+    size_t object_len;               /**< Length of the module object received so far. */
+} module_json_splitter_t;
+
+/**
+ * \brief Get the max_age query parameter of a request.
+ *
+ * \param[in] req The HTTP request.
+ *
+ * \return The maximum age in milliseconds the client accepts for cached properties. (0 if not provided)
+ */
+static uint32_t module_api_max_age_get(httpd_req_t *req)
 {
-    of_display_t *display = (of_display_t *)req->user_ctx;
-    esp_err_t err         = ESP_OK;
+    char query[QUERY_STR_LEN_MAX];
+    char max_age[MAX_AGE_STR_LEN_MAX];
 
-    /* Desynchronize all properties which can be read through json. to force them to be read. */
-    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
-        if (mdl_prop_list[prop_id].handler.get_alt != NULL) {
-            display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_READ);
-        }
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, MAX_AGE_QUERY_KEY_STR, max_age, sizeof(max_age)) != ESP_OK) {
+        return 0;
     }
-    ESP_LOGI(TAG, "Display desynchronized");
 
-    /* Synchronize */
-    err = of_display_synchronize(display, 5000);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to synchronize display");
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
-        return err;
-    }
-    ESP_LOGI(TAG, "Display synchronized");
-    /* Create a json object. */
-    cJSON *json = cJSON_CreateArray();
-    for (uint16_t i = 0; i < display_size_get(display); i++) {
-        module_t *module   = display_module_get(display, i);
-        cJSON *module_json = cJSON_CreateObject();
+    return strtoul(max_age, NULL, 10);
+}
 
-        cJSON_AddNumberToObject(module_json, MODULE_INDEX_KEY_STR, i);
+//---------------------------------------------------------------------------------------------------------------------
 
-        /* Get all properties from a module. */
-        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
-            /* Get the property handler. */
-            const char *property_name = mdl_prop_list[prop_id].attribute.name;
+/**
+ * \brief Get the json representation of a module.
+ *
+ * \param[in] module The module.
+ * \param[in] module_index The index of the module on the display.
+ *
+ * \return The json object of the module, NULL if no memory is available.
+ */
+static cJSON *module_api_module_json_get(module_t *module, uint16_t module_index)
+{
+    cJSON *module_json = cJSON_CreateObject();
+    if (module_json == NULL) {
+        return NULL;
+    }
 
-            /* Check if the property can be converted to a JSON. */
-            if (mdl_prop_list[prop_id].handler.get_alt == NULL) {
-                /* Property is not supported for reading. */
-                continue;
-            }
+    cJSON_AddNumberToObject(module_json, MODULE_INDEX_KEY_STR, module_index);
 
-            /* Call the property handler. */
-            cJSON *property_json = cJSON_CreateObject();
-            if (!mdl_prop_list[prop_id].handler.get_alt(module, i, &property_json)) {
-                ESP_LOGE(TAG, "Property \"%s\" is invalid.", property_name);
-                continue;
-            }
+    /* Get all properties from a module. */
+    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+        /* Get the property handler. */
+        const char *property_name = mdl_prop_list[prop_id].attribute.name;
+
+        /* Check if the property can be converted to a JSON. */
+        if (mdl_prop_list[prop_id].handler.get_alt == NULL) {
+            /* Property is not supported for reading. */
+            continue;
+        }
 
-            /* Add the property json to the module json. */
-            cJSON_AddItemToObject(module_json, property_name, property_json);
+        /* Call the property handler. */
+        cJSON *property_json = cJSON_CreateObject();
+        if (!mdl_prop_list[prop_id].handler.get_alt(module, module_index, &property_json)) {
+            ESP_LOGE(TAG, "Property \"%s\" is invalid.", property_name);
+            continue;
         }
 
-        /* Add the module json to the array. */
-        cJSON_AddItemToArray(json, module_json);
+        /* Add the property json to the module json. */
+        cJSON_AddItemToObject(module_json, property_name, property_json);
     }
-    char *json_str = cJSON_Print(json);
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    return module_json;
+}
 
-    cJSON_Delete(json);
-    free(json_str);
+//---------------------------------------------------------------------------------------------------------------------
 
-    return ESP_OK;
+/**
+ * \brief Print a module at the end of a chunk of the response.
+ *
+ * \param[in] module_json The json object of the module.
+ * \param[in] separator The character preceding the module.
+ * \param[inout] chunk The chunk of #MODULE_JSON_CHUNK_SIZE bytes.
+ * \param[inout] chunk_len The number of bytes in the chunk.
+ *
+ * \return true if the module has been printed, false if it does not fit in the chunk.
+ */
+static bool module_api_module_json_print(cJSON *module_json, char separator, char *chunk, size_t *chunk_len)
+{
+    if (*chunk_len + 1 >= MODULE_JSON_CHUNK_SIZE) {
+        return false;
+    }
+
+    chunk[*chunk_len] = separator;
+    if (!cJSON_PrintPreallocated(module_json, &chunk[*chunk_len + 1], MODULE_JSON_CHUNK_SIZE - *chunk_len - 1, false)) {
+        return false;
+    }
+    *chunk_len += 1 + strlen(&chunk[*chunk_len + 1]);
+
+    return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-esp_err_t module_api_post_handler(httpd_req_t *req)
+esp_err_t module_api_get_handler(httpd_req_t *req)
 {
     of_display_t *display = (of_display_t *)req->user_ctx;
+    esp_err_t err         = ESP_OK;
 
-    ESP_LOGI(TAG, "POST data length: %d", req->content_len);
+    /* Only read the properties which are older than the client accepts. Without max_age everything is read. */
+    uint32_t max_age_ms = module_api_max_age_get(req);
+    ESP_LOGI(TAG, "Refreshing properties older than %" PRIu32 " ms", max_age_ms);
 
-    /* Attempt to allocate memory for posted data. */
-    char *buf = malloc(req->content_len);
-    if (buf == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for POST data");
+    err = of_display_refresh(display, max_age_ms, 5000);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to synchronize display");
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
-        return ESP_FAIL;
+        return err;
     }
+    ESP_LOGI(TAG, "Display synchronized");
 
-    /* Read All data. */
-    for (int total_len = 0, recv_len = 0; total_len < req->content_len; total_len += recv_len) {
-        recv_len = httpd_req_recv(req, buf + total_len, req->content_len - total_len);
-        if (recv_len <= 0) {
-            ESP_LOGE(TAG, "Failed to receive POST data");
-            free(buf);
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
-            return ESP_FAIL;
-        }
+    /* Clients doing high rate updates can skip JSON. */
+    if (module_api_bin_requested(req, "Accept")) {
+        return module_api_bin_get_handler(req);
     }
 
-    /* Convert to json. */
-    cJSON *json = cJSON_ParseWithLength(buf, req->content_len);
-    if (json == NULL) {
-        ESP_LOGE(TAG, "Failed to parse POST data");
-        free(buf);
+    char *chunk = malloc(MODULE_JSON_CHUNK_SIZE);
+    if (chunk == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the response");
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
         return ESP_FAIL;
     }
 
-    /* Check that root element is an array. */
-    if (!cJSON_IsArray(json)) {
-        ESP_LOGE(TAG, "POST data is not an object");
-        cJSON_Delete(json);
-        free(buf);
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL);
-        return ESP_FAIL;
+    /* Send the modules one by one, only a single module is held as a json object at a time. */
+    httpd_resp_set_type(req, "application/json");
+    size_t chunk_len = 0;
+    uint16_t i       = 0;
+    for (; i < display_size_get(display) && err == ESP_OK; i++) {
+        /* The display is only locked while the module is read, not while the response is sent. */
+        display_lock(display);
+        module_t *module   = display_module_get(display, i);
+        cJSON *module_json = (module != NULL) ? module_api_module_json_get(module, i) : NULL;
+        display_unlock(display);
+        if (module == NULL) {
+            break; /* The display has shrunk since the loop condition was checked. */
+        }
+        if (module_json == NULL) {
+            err = ESP_ERR_NO_MEM;
+            break;
+        }
+
+        /* Each module is preceded by the opening bracket or a separator. */
+        char separator = (i == 0) ? '[' : ',';
+        bool printed   = module_api_module_json_print(module_json, separator, chunk, &chunk_len);
+        if (!printed && chunk_len > 0) {
+            err       = httpd_resp_send_chunk(req, chunk, chunk_len);
+            chunk_len = 0;
+            printed   = (err == ESP_OK) && module_api_module_json_print(module_json, separator, chunk, &chunk_len);
+        }
+
+        /* A module with a large character set does not fit in the chunk. */
+        if (!printed && err == ESP_OK) {
+            char *module_str = cJSON_PrintUnformatted(module_json);
+            err              = (module_str == NULL) ? ESP_ERR_NO_MEM : httpd_resp_send_chunk(req, &separator, 1);
+            if (err == ESP_OK) {
+                err = httpd_resp_send_chunk(req, module_str, HTTPD_RESP_USE_STRLEN);
+            }
+            free(module_str);
+        }
+        cJSON_Delete(module_json);
+    }
+
+    /* Close the array and end the response. */
+    if (err == ESP_OK && chunk_len + 2 > MODULE_JSON_CHUNK_SIZE) {
+        err       = httpd_resp_send_chunk(req, chunk, chunk_len);
+        chunk_len = 0;
+    }
+    if (err == ESP_OK) {
+        chunk_len += sprintf(&chunk[chunk_len], "%s", (i > 0) ? "]" : "[]");
+        err = httpd_resp_send_chunk(req, chunk, chunk_len);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    free(chunk);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to send the response");
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Update the properties of a module from its json representation.
+ *
+ * Invalid modules and properties are skipped.
+ *
+ * \param[in] display The display.
+ * \param[in] module_json The json object of the module.
+ */
+static void module_api_module_json_apply(of_display_t *display, cJSON *module_json)
+{
+    /* Check if module has valid index specified. */
+    cJSON *module_index_json = cJSON_GetObjectItem(module_json, MODULE_INDEX_KEY_STR);
+    if (!cJSON_IsNumber(module_index_json)) {
+        ESP_LOGE(TAG, "No module index specified");
+        return;
+    }
+
+    /* Update the module. */
+    module_t *module = display_module_get(display, module_index_json->valueint);
+    if (module == NULL) {
+        ESP_LOGE(TAG, "Display does not contain module with index %d", module_index_json->valueint);
+        return;
     }
 
-    /* Loop through array. */
-    cJSON *module_json = NULL;
-    cJSON_ArrayForEach(module_json, json)
+    /* Update all properties. */
+    cJSON *property_json = NULL;
+
+    /* Loop through all json object in the module_json object. */
+    cJSON_ArrayForEach(property_json, module_json)
     {
-        /* Check if module has valid index specified. */
-        cJSON *module_index_json = cJSON_GetObjectItem(module_json, MODULE_INDEX_KEY_STR);
-        if (!cJSON_IsNumber(module_index_json)) {
-            ESP_LOGE(TAG, "No module index specified");
+        /* Ignore the module index. */
+        if (strcmp(property_json->string, "module") == 0) {
             continue;
         }
 
-        /* Update the module. */
-        module_t *module = display_module_get(display, module_index_json->valueint);
-        if (module == NULL) {
-            ESP_LOGE(TAG, "Display does not contain module with index %d", module_index_json->valueint);
+        /* Get the property handler. */
+        mdl_prop_id_t prop_id = of_mdl_prop_id_by_name(property_json->string);
+        if (prop_id == -1) {
+            ESP_LOGE(TAG, "Property \"%s\" not supported by controller.", property_json->string);
+            continue;
+        }
+
+        /* Check if the property is writable. */
+        if (mdl_prop_list[prop_id].handler.set_alt == NULL) {
+            ESP_LOGE(TAG, "Property \"%s\" is not writable.", property_json->string);
             continue;
         }
 
-        /* Update all properties. */
-        cJSON *property_json = NULL;
+        /* Call the property handler. */
+        if (!mdl_prop_list[prop_id].handler.set_alt(module, module_index_json->valueint, property_json)) {
+            ESP_LOGE(TAG, "Property \"%s\" is invalid.", property_json->string);
+            continue;
+        }
 
-        /* Loop through all json object in the module_json object. */
-        cJSON_ArrayForEach(property_json, module_json)
-        {
-            /* Ignore the module index. */
-            if (strcmp(property_json->string, "module") == 0) {
+        /* Indicate that the property needs to be written to the actual module. */
+        module_property_indicate_desynchronized(module, prop_id);
+        display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_WRITE);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Feed a chunk of a POST request to the splitter and apply every module object which is completed by it.
+ *
+ * Only the brackets and strings are tracked, each complete module object is parsed by cJSON.
+ *
+ * \param[inout] splitter The splitter.
+ * \param[in] display The display.
+ * \param[in] data The chunk.
+ * \param[in] len The length of the chunk.
+ *
+ * \retval ESP_OK The chunk has been consumed.
+ * \retval ESP_ERR_INVALID_ARG The request is not an array of objects.
+ * \retval ESP_ERR_INVALID_SIZE A module object is larger than #MODULE_JSON_OBJECT_SIZE_MAX.
+ */
+static esp_err_t module_api_module_json_split(module_json_splitter_t *splitter, of_display_t *display,
+                                              const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+
+        if (splitter->state != MODULE_JSON_SPLIT_MODULE) {
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
                 continue;
             }
+            if (splitter->state == MODULE_JSON_SPLIT_START && c == '[') {
+                splitter->state = MODULE_JSON_SPLIT_ARRAY;
+            } else if (splitter->state == MODULE_JSON_SPLIT_ARRAY && c == ']') {
+                splitter->state = MODULE_JSON_SPLIT_END;
+            } else if (splitter->state == MODULE_JSON_SPLIT_ARRAY && c == '{') {
+                splitter->state      = MODULE_JSON_SPLIT_MODULE;
+                splitter->depth      = 0;
+                splitter->in_string  = false;
+                splitter->escape     = false;
+                splitter->object_len = 0;
+            } else if (!(splitter->state == MODULE_JSON_SPLIT_ARRAY && c == ',')) {
+                ESP_LOGE(TAG, "POST data is not an array of objects");
+                return ESP_ERR_INVALID_ARG;
+            }
 
-            /* Get the property handler. */
-            mdl_prop_id_t prop_id = of_mdl_prop_id_by_name(property_json->string);
-            if (prop_id == -1) {
-                ESP_LOGE(TAG, "Property \"%s\" not supported by controller.", property_json->string);
+            /* The opening brace is the start of the module object. */
+            if (splitter->state != MODULE_JSON_SPLIT_MODULE) {
                 continue;
             }
+        }
 
-            /* Check if the property is writable. */
-            if (mdl_prop_list[prop_id].handler.set_alt == NULL) {
-                ESP_LOGE(TAG, "Property \"%s\" is not writable.", property_json->string);
-                continue;
+        ESP_RETURN_ON_FALSE(splitter->object_len < MODULE_JSON_OBJECT_SIZE_MAX, ESP_ERR_INVALID_SIZE, TAG,
+                            "Module object exceeds %d bytes", MODULE_JSON_OBJECT_SIZE_MAX);
+        splitter->object[splitter->object_len++] = c;
+
+        /* Brackets inside strings are not part of the structure. */
+        if (splitter->in_string) {
+            if (splitter->escape) {
+                splitter->escape = false;
+            } else if (c == '\\') {
+                splitter->escape = true;
+            } else if (c == '"') {
+                splitter->in_string = false;
             }
+            continue;
+        }
 
-            /* Call the property handler. */
-            if (!mdl_prop_list[prop_id].handler.set_alt(module, module_index_json->valueint, property_json)) {
-                ESP_LOGE(TAG, "Property \"%s\" is invalid.", property_json->string);
-                continue;
+        if (c == '"') {
+            splitter->in_string = true;
+        } else if (c == '{' || c == '[') {
+            splitter->depth++;
+        } else if ((c == '}' || c == ']') && --splitter->depth == 0) {
+            /* The module object is complete. */
+            cJSON *module_json = cJSON_ParseWithLength(splitter->object, splitter->object_len);
+            if (!cJSON_IsObject(module_json)) {
+                ESP_LOGE(TAG, "Failed to parse module object");
+                cJSON_Delete(module_json);
+                return ESP_ERR_INVALID_ARG;
             }
+            display_lock(display);
+            module_api_module_json_apply(display, module_json);
+            display_unlock(display);
+            cJSON_Delete(module_json);
+            splitter->state = MODULE_JSON_SPLIT_ARRAY;
+        }
+    }
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t module_api_post_handler(httpd_req_t *req)
+{
+    of_display_t *display = (of_display_t *)req->user_ctx;
 
-            /* Indicate that the property needs to be written to the actual module. */
-            module_property_indicate_desynchronized(module, prop_id);
-            display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_WRITE);
+    /* Clients doing high rate updates can skip JSON. */
+    if (module_api_bin_requested(req, "Content-Type")) {
+        return module_api_bin_post_handler(req);
+    }
+
+    ESP_LOGI(TAG, "POST data length: %d", req->content_len);
+
+    /* Attempt to allocate memory for posted data, only a single read and a single module are held at a time. */
+    char *recv_buf                  = malloc(MODULE_JSON_RECV_SIZE);
+    module_json_splitter_t splitter = {.object = malloc(MODULE_JSON_OBJECT_SIZE_MAX)};
+    if (recv_buf == NULL || splitter.object == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for POST data");
+        free(recv_buf);
+        free(splitter.object);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    /* Apply each module as soon as it has been received. */
+    esp_err_t err = ESP_OK;
+    for (int total_len = 0, recv_len = 0; total_len < req->content_len && err == ESP_OK; total_len += recv_len) {
+        size_t recv_size = MIN(req->content_len - total_len, MODULE_JSON_RECV_SIZE);
+        recv_len         = httpd_req_recv(req, recv_buf, recv_size);
+        if (recv_len <= 0) {
+            ESP_LOGE(TAG, "Failed to receive POST data");
+            err = ESP_FAIL;
+            break;
         }
+        err = module_api_module_json_split(&splitter, display, recv_buf, recv_len);
     }
+    if (err == ESP_OK && splitter.state != MODULE_JSON_SPLIT_END) {
+        ESP_LOGE(TAG, "POST data is not a complete array");
+        err = ESP_ERR_INVALID_ARG;
+    }
+    free(recv_buf);
+    free(splitter.object);
 
-    /* Gracefully exit. */
-    cJSON_Delete(json);
-    free(buf);
-    httpd_resp_sendstr(req, "OK");
+    /* Modules received before an error have been updated. */
+    if (err == ESP_OK) {
+        httpd_resp_sendstr(req, "OK");
+    } else if (err == ESP_FAIL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    } else {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL);
+    }
 
     /* Notify that we have updated the display modules. */
     of_display_synchronize(display, 0);
 
-    return ESP_OK;
+    return (err == ESP_OK) ? ESP_OK : ESP_FAIL;
 }
\ No newline at end of file
@@ -1,27 +1,160 @@
 #include "module_api_firmware_endpoints.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "lzss.h"
 #include "openflap_display.h"
 #include "openflap_module.h"
 #include "openflap_properties.h"
 #include "webserver.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
 #define TAG "MODULE_FIRMWARE_ENDPOINTS"
 
+/** Number of firmware pages that can be buffered between the HTTP receiver and the chain. */
+#define MODULE_FIRMWARE_RING_PAGE_CNT (4)
+
+#define MODULE_FIRMWARE_STREAM_TASK_SIZE 3072
+#define MODULE_FIRMWARE_STREAM_TASK_PRIO 4
+
+/** Time to wait for the chain to accept a page. */
+#define MODULE_FIRMWARE_PAGE_TIMEOUT_MS (5000)
+
+/** Number of consecutive compressed pages the modules must reject before only uncompressed pages are sent. */
+#define MODULE_FIRMWARE_LZ_FAIL_LIMIT (3)
+
+/**
+ * \brief A firmware page passed from the HTTP receiver to the stream task.
+ */
+typedef struct {
+    uint8_t *data;  /**< The page data, NULL to end the stream. */
+    uint16_t index; /**< The index of the page in the firmware. */
+    bool complete;  /**< Indicates that the stream ended with the last page of the firmware. */
+} module_firmware_page_t;
+
+/**
+ * \brief Pipeline between the HTTP receiver and the chain.
+ *
+ * The HTTP receiver fills free pages while the stream task writes earlier pages to the modules.
+ */
+typedef struct {
+    of_display_t *display;     /**< The display to update. */
+    QueueHandle_t free_pages;  /**< Pages that can be filled by the HTTP receiver. */
+    QueueHandle_t full_pages;  /**< Pages that must be written to the modules, in order. */
+    SemaphoreHandle_t done;    /**< Given when the stream task has finished. */
+    volatile esp_err_t result; /**< The result of the stream, the first error ends the stream. */
+    volatile bool surveying;   /**< The modules are surveyed before the first page, which can take several syncs. */
+    bool ended;                /**< Indicates that the end of the stream has been queued. */
+    uint16_t page_cnt;         /**< Number of pages in the firmware. */
+    uint32_t *page_crc;        /**< CRC of each page in the new app region of the modules. */
+    bool *page_crc_valid;      /**< Indicates that all modules have the same CRC for a page. */
+    uint16_t page_skip_cnt;    /**< Number of pages that were already present on all modules. */
+    uint8_t *history;          /**< The pages before the current page, compressed pages refer back into them. */
+    size_t history_size;       /**< Number of bytes in the history, at most #LZSS_WINDOW_SIZE. */
+    bool lz_enabled;           /**< Indicates that the modules accept compressed pages. */
+    uint8_t lz_fail_cnt;       /**< Number of consecutive compressed pages the modules rejected. */
+    uint16_t lz_page_cnt;      /**< Number of pages that were sent compressed. */
+    uint16_t burst_size_max;   /**< Largest burst of pages accepted by all modules, 0 to write pages one by one. */
+    uint8_t *burst;            /**< Pages waiting to be written as one burst, each preceded by its size. */
+    uint16_t burst_size;       /**< Number of bytes in the burst. */
+    uint16_t burst_index;      /**< Index of the first page in the burst. */
+    uint16_t burst_page_cnt;   /**< Number of pages in the burst. */
+    uint16_t burst_cnt;        /**< Number of bursts that were written. */
+    /** Storage for the pages in the pipeline. */
+    uint8_t ring[MODULE_FIRMWARE_RING_PAGE_CNT][OF_FIRMWARE_UPDATE_PAGE_SIZE];
+} module_firmware_stream_t;
+
 static esp_err_t module_firmware_chunk_handler(void *user_ctx, char *data, size_t data_len, size_t data_offset,
                                                size_t total_data_len);
+static esp_err_t module_firmware_stream_end(module_firmware_stream_t *stream, bool complete);
+static void module_firmware_stream_task(void *arg);
+static esp_err_t module_firmware_page_write(of_display_t *display, const module_firmware_page_t *page);
+static esp_err_t module_firmware_lz_page_write(module_firmware_stream_t *stream, const module_firmware_page_t *page);
+static void module_firmware_history_append(module_firmware_stream_t *stream, const module_firmware_page_t *page);
+static size_t module_firmware_page_compress(module_firmware_stream_t *stream, const module_firmware_page_t *page,
+                                            uint8_t *lz_page);
+static void module_firmware_burst_survey(module_firmware_stream_t *stream);
+static esp_err_t module_firmware_burst_add(module_firmware_stream_t *stream, const module_firmware_page_t *page);
+static esp_err_t module_firmware_burst_flush(module_firmware_stream_t *stream);
+static esp_err_t module_firmware_reboot(of_display_t *display);
+static void module_firmware_page_crc_survey(module_firmware_stream_t *stream);
+static void module_firmware_properties_release(module_firmware_stream_t *stream);
+static bool module_firmware_page_is_present(const module_firmware_stream_t *stream, const module_firmware_page_t *page);
+static uint32_t module_firmware_page_crc_calculate(const uint8_t *data);
 
 //---------------------------------------------------------------------------------------------------------------------
 
 esp_err_t module_api_firmware_handler(httpd_req_t *req)
 {
     of_display_t *display = (of_display_t *)req->user_ctx;
+    esp_err_t ret         = ESP_OK;
+
+    /* Check display size. */
+    if (display_size_get(display) == 0) {
+        ESP_LOGE(TAG, "Display is empty");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
 
-    /* Get the chunk size. The chain comm message prefixes 2 bytes to send the address of the send flash chunk.  */
-    size_t chunk_size = OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    /* Set up the pipeline. */
+    module_firmware_stream_t *stream = calloc(1, sizeof(module_firmware_stream_t));
+    if (stream == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the firmware stream");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_ERR_NO_MEM;
+    }
+    stream->display    = display;
+    stream->result     = ESP_OK;
+    stream->surveying  = true;
+    stream->page_cnt   = (req->content_len + OF_FIRMWARE_UPDATE_PAGE_SIZE - 1) / OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    stream->free_pages = xQueueCreate(MODULE_FIRMWARE_RING_PAGE_CNT, sizeof(uint8_t *));
+    stream->full_pages = xQueueCreate(MODULE_FIRMWARE_RING_PAGE_CNT + 1, sizeof(module_firmware_page_t));
+    stream->done       = xSemaphoreCreateBinary();
+    stream->history    = malloc(LZSS_WINDOW_SIZE + OF_FIRMWARE_UPDATE_PAGE_SIZE);
+    stream->lz_enabled = stream->history != NULL;
+    ESP_GOTO_ON_FALSE(stream->free_pages && stream->full_pages && stream->done, ESP_ERR_NO_MEM, exit, TAG,
+                      "Failed to create the firmware stream");
+    for (uint8_t i = 0; i < MODULE_FIRMWARE_RING_PAGE_CNT; i++) {
+        uint8_t *page_data = stream->ring[i];
+        xQueueSend(stream->free_pages, &page_data, 0);
+    }
 
-    /* Use the webserver_api_util to read and handle the file in chunks.  */
-    return webserver_api_util_file_upload_to_chunk_cb(req, module_firmware_chunk_handler, display, chunk_size);
+    ESP_GOTO_ON_FALSE(xTaskCreate(module_firmware_stream_task, "module_fw_stream", MODULE_FIRMWARE_STREAM_TASK_SIZE,
+                                  stream, MODULE_FIRMWARE_STREAM_TASK_PRIO, NULL) == pdPASS,
+                      ESP_ERR_NO_MEM, exit, TAG, "Failed to create the firmware stream task");
+
+    /* Use the webserver_api_util to read and handle the file in chunks. The last chunk waits for the stream. */
+    ret = webserver_api_util_file_upload_to_chunk_cb(req, module_firmware_chunk_handler, stream,
+                                                     OF_FIRMWARE_UPDATE_PAGE_SIZE);
+
+    /* Stop the stream task when the upload was aborted. */
+    if (!stream->ended) {
+        module_firmware_stream_end(stream, false);
+    }
+
+exit:
+    if (ret != ESP_OK && !stream->ended) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+    }
+    if (stream->free_pages != NULL) {
+        vQueueDelete(stream->free_pages);
+    }
+    if (stream->full_pages != NULL) {
+        vQueueDelete(stream->full_pages);
+    }
+    if (stream->done != NULL) {
+        vSemaphoreDelete(stream->done);
+    }
+    free(stream->history);
+    free(stream);
+
+    return ret;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -29,41 +162,539 @@ esp_err_t module_api_firmware_handler(httpd_req_t *req)
 static esp_err_t module_firmware_chunk_handler(void *user_ctx, char *data, size_t data_len, size_t data_offset,
                                                size_t total_data_len)
 {
-    of_display_t *display = (of_display_t *)user_ctx;
+    module_firmware_stream_t *stream = (module_firmware_stream_t *)user_ctx;
 
-    ESP_LOGI(TAG, "writing %d %d/%d bytes", data_len, data_offset + data_len, total_data_len);
+    ESP_LOGI(TAG, "received %d %d/%d bytes", data_len, data_offset + data_len, total_data_len);
 
-    /* Check display size. */
-    uint16_t display_size = display_size_get(display);
-    ESP_RETURN_ON_FALSE(display_size > 0, ESP_FAIL, TAG, "Display is empty");
+    /* Stop receiving once the chain has failed. */
+    ESP_RETURN_ON_ERROR(stream->result, TAG, "Failed to write firmware to the modules");
+
+    /* Wait for a free page, this is where a slow chain throttles the HTTP receiver. The survey takes a sync per window
+     * of pages before the first page is written, so it is not bound by the timeout of a single page. */
+    module_firmware_page_t page = {.index = data_offset / OF_FIRMWARE_UPDATE_PAGE_SIZE};
+    while (!xQueueReceive(stream->free_pages, &page.data, pdMS_TO_TICKS(MODULE_FIRMWARE_PAGE_TIMEOUT_MS))) {
+        ESP_RETURN_ON_FALSE(stream->surveying, ESP_ERR_TIMEOUT, TAG, "Timeout waiting for a free firmware page");
+    }
+
+    /* The last page is padded with the erased flash value. */
+    memcpy(page.data, data, data_len);
+    memset(page.data + data_len, 0xFF, OF_FIRMWARE_UPDATE_PAGE_SIZE - data_len);
+    xQueueSend(stream->full_pages, &page, portMAX_DELAY);
+
+    if (data_offset + data_len < total_data_len) {
+        return ESP_OK;
+    }
+
+    /* Report the result of the module OTA, not just the upload. */
+    return module_firmware_stream_end(stream, true);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief End the firmware stream and wait for the stream task to finish.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] complete true if all pages of the firmware have been queued, false to abort the stream.
+ *
+ * \return The result of the stream.
+ */
+static esp_err_t module_firmware_stream_end(module_firmware_stream_t *stream, bool complete)
+{
+    module_firmware_page_t page = {.data = NULL, .complete = complete};
+
+    xQueueSend(stream->full_pages, &page, portMAX_DELAY);
+    stream->ended = true;
+    xSemaphoreTake(stream->done, portMAX_DELAY);
+
+    return stream->result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Write the queued firmware pages to the modules until the stream ends.
+ *
+ * \param[in] arg The firmware stream.
+ */
+static void module_firmware_stream_task(void *arg)
+{
+    module_firmware_stream_t *stream = (module_firmware_stream_t *)arg;
+    module_firmware_page_t page;
+
+    /* Find out which pages the modules already have while the first pages are being received. */
+    module_firmware_page_crc_survey(stream);
+    module_firmware_burst_survey(stream);
+    stream->surveying = false;
+
+    while (1) {
+        xQueueReceive(stream->full_pages, &page, portMAX_DELAY);
+        if (page.data == NULL) {
+            break;
+        }
+
+        /* Drain the remaining pages after an error, so the HTTP receiver does not block. */
+        if (stream->result == ESP_OK && module_firmware_page_is_present(stream, &page)) {
+            ESP_LOGD(TAG, "skipping page %d", page.index);
+            stream->page_skip_cnt++;
+        } else if (stream->result == ESP_OK && stream->burst != NULL) {
+            stream->result = module_firmware_burst_add(stream, &page);
+        } else if (stream->result == ESP_OK && module_firmware_lz_page_write(stream, &page) != ESP_OK) {
+            stream->result = module_firmware_page_write(stream->display, &page);
+        }
+        module_firmware_history_append(stream, &page);
+        xQueueSend(stream->free_pages, &page.data, portMAX_DELAY);
+    }
 
-    for (uint16_t i = 0; i < display_size; i++) {
+    if (page.complete && stream->result == ESP_OK) {
+        stream->result = module_firmware_burst_flush(stream);
+    }
+
+    if (page.complete && stream->result == ESP_OK) {
+        ESP_LOGI(TAG, "Module OTA complete, %d of %d pages skipped, %d compressed, %d bursts. Rebooting modules...",
+                 stream->page_skip_cnt, stream->page_cnt, stream->lz_page_cnt, stream->burst_cnt);
+        stream->result = module_firmware_reboot(stream->display);
+    }
+
+    module_firmware_properties_release(stream);
+    free(stream->page_crc);
+    free(stream->page_crc_valid);
+
+    xSemaphoreGive(stream->done);
+    vTaskDelete(NULL);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Write a single firmware page to all modules.
+ *
+ * \param[in] display The display to update.
+ * \param[in] page The firmware page.
+ *
+ * \return The result of the synchronization.
+ */
+static esp_err_t module_firmware_page_write(of_display_t *display, const module_firmware_page_t *page)
+{
+    ESP_LOGI(TAG, "writing page %d", page->index);
+
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display); i++) {
         module_t *module = display_module_get(display, i);
 
         /* Set the firmware page. */
-        of_module_firmware_update_property_set(module, data_offset / data_len, (uint8_t *)data);
+        of_module_firmware_update_property_set(module, page->index, page->data);
 
         /* Indicate that the firmware property has changed and needs to be written. */
         module_property_indicate_desynchronized(module, OF_MDL_PROP_FIRMWARE_UPDATE);
     }
     display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_UPDATE, PROPERTY_SYNC_METHOD_WRITE);
+    display_unlock(display);
 
     /* Synchronize. */
-    ESP_RETURN_ON_ERROR(of_display_synchronize(display, 5000), TAG, "Failed to synchronize display.");
+    ESP_RETURN_ON_ERROR(of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS), TAG,
+                        "Failed to synchronize display.");
 
-    if (data_offset + data_len == total_data_len) {
-        ESP_LOGI(TAG, "Module OTA complete. Rebooting modules...");
+    return ESP_OK;
+}
 
-        for (uint16_t i = 0; i < display_size; i++) {
-            module_t *module = display_module_get(display, i);
-            /* All data has been transmitted, reboot the modules. */
-            of_module_command_set(module, CMD_REBOOT);
-            module_property_indicate_desynchronized(module, OF_MDL_PROP_COMMAND);
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Write a single compressed firmware page to all modules.
+ *
+ * The page is compressed against the pages before it, which the modules already have in their new app region. When
+ * the page does not get smaller, or the modules don't accept compressed pages, the page must be written as is.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] page The firmware page.
+ *
+ * \return ESP_OK if the page was written, an error if it must be written uncompressed.
+ */
+static esp_err_t module_firmware_lz_page_write(module_firmware_stream_t *stream, const module_firmware_page_t *page)
+{
+    of_display_t *display = stream->display;
+    uint8_t lz_page[OF_FIRMWARE_UPDATE_PAGE_SIZE - 1];
+
+    size_t lz_size = module_firmware_page_compress(stream, page, lz_page);
+    if (lz_size == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ESP_LOGD(TAG, "writing page %d, compressed to %u bytes", page->index, lz_size);
+
+    esp_err_t err = ESP_OK;
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display) && err == ESP_OK; i++) {
+        module_t *module = display_module_get(display, i);
+        err              = of_module_firmware_lz_page_property_set(module, page->index, lz_page, lz_size);
+        module_property_indicate_desynchronized(module, OF_MDL_PROP_FIRMWARE_LZ_PAGE);
+    }
+    if (err == ESP_OK) {
+        display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_LZ_PAGE, PROPERTY_SYNC_METHOD_WRITE);
+    }
+    display_unlock(display);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to set compressed page");
+
+    /* A rejected page is sent uncompressed. Modules without support for compressed pages reject every page, only
+     * uncompressed pages are sent once several pages in a row have been rejected. */
+    if (of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "Modules did not accept compressed page %d, sending it uncompressed", page->index);
+        display_property_indicate_synchronized(display, OF_MDL_PROP_FIRMWARE_LZ_PAGE);
+        if (++stream->lz_fail_cnt >= MODULE_FIRMWARE_LZ_FAIL_LIMIT) {
+            ESP_LOGW(TAG, "Modules rejected %d compressed pages in a row, sending uncompressed pages",
+                     stream->lz_fail_cnt);
+            stream->lz_enabled = false;
         }
-        display_property_indicate_desynchronized(display, OF_MDL_PROP_COMMAND, PROPERTY_SYNC_METHOD_WRITE);
-        /* Synchronize. */
-        ESP_RETURN_ON_ERROR(of_display_synchronize(display, 5000), TAG, "Failed to synchronize display.");
+        return ESP_FAIL;
+    }
+
+    stream->lz_fail_cnt = 0;
+    stream->lz_page_cnt++;
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Compress a firmware page against the pages before it.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] page The firmware page, it must directly follow the history.
+ * \param[out] lz_page The compressed page, at least #OF_FIRMWARE_UPDATE_PAGE_SIZE - 1 bytes.
+ *
+ * \return The size of the compressed page, 0 if it must be sent as is.
+ */
+static size_t module_firmware_page_compress(module_firmware_stream_t *stream, const module_firmware_page_t *page,
+                                            uint8_t *lz_page)
+{
+    if (!stream->lz_enabled) {
+        return 0;
+    }
+
+    /* Pages arrive in order, so the page directly follows the history. */
+    memcpy(stream->history + stream->history_size, page->data, OF_FIRMWARE_UPDATE_PAGE_SIZE);
+    return lzss_compress(stream->history, stream->history_size, OF_FIRMWARE_UPDATE_PAGE_SIZE, lz_page,
+                         OF_FIRMWARE_UPDATE_PAGE_SIZE - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Find the largest burst of pages that all modules accept.
+ *
+ * When the modules don't support the firmware burst property, pages are written one by one.
+ *
+ * \param[in] stream The firmware stream.
+ */
+static void module_firmware_burst_survey(module_firmware_stream_t *stream)
+{
+    of_display_t *display = stream->display;
+
+    display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_BURST, PROPERTY_SYNC_METHOD_READ);
+    if (of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "Modules did not report a burst size, writing pages one by one");
+        display_property_indicate_synchronized(display, OF_MDL_PROP_FIRMWARE_BURST);
+        return;
+    }
+
+    /* The frame size is limited by the module with the smallest buffer and by the controller itself. */
+    uint16_t size_max = MDL_PAYLOAD_SIZE_MAX;
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display); i++) {
+        const firmware_burst_property_t *burst = display_module_get(display, i)->firmware_burst;
+        size_max                               = MIN(size_max, burst != NULL ? burst->size_max : 0);
+    }
+    display_unlock(display);
+
+    /* A burst is only worth it when it holds at least two uncompressed pages. */
+    if (size_max < OF_FIRMWARE_BURST_HEADER_SIZE + 2 * (1 + OF_FIRMWARE_UPDATE_PAGE_SIZE)) {
+        ESP_LOGI(TAG, "Burst size of %d bytes is too small, writing pages one by one", size_max);
+        return;
     }
 
+    stream->burst = malloc(size_max - OF_FIRMWARE_BURST_HEADER_SIZE);
+    if (stream->burst == NULL) {
+        ESP_LOGW(TAG, "Not enough memory for bursts, writing pages one by one");
+        return;
+    }
+    stream->burst_size_max = size_max - OF_FIRMWARE_BURST_HEADER_SIZE;
+    ESP_LOGI(TAG, "Writing pages in bursts of up to %d bytes", size_max);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Add a firmware page to the burst, the burst is written first when the page doesn't fit.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] page The firmware page.
+ *
+ * \return The result of writing the previous burst.
+ */
+static esp_err_t module_firmware_burst_add(module_firmware_stream_t *stream, const module_firmware_page_t *page)
+{
+    uint8_t lz_page[OF_FIRMWARE_UPDATE_PAGE_SIZE - 1];
+    size_t lz_size     = module_firmware_page_compress(stream, page, lz_page);
+    size_t page_size   = lz_size ? lz_size : OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    const uint8_t *src = lz_size ? lz_page : page->data;
+
+    /* A burst contains consecutive pages only, skipped pages end a burst. */
+    if (stream->burst_page_cnt > 0 && (stream->burst_index + stream->burst_page_cnt != page->index ||
+                                       stream->burst_size + 1 + page_size > stream->burst_size_max)) {
+        ESP_RETURN_ON_ERROR(module_firmware_burst_flush(stream), TAG, "Failed to write burst");
+    }
+
+    if (stream->burst_page_cnt == 0) {
+        stream->burst_index = page->index;
+    }
+    stream->burst[stream->burst_size++] = page_size;
+    memcpy(stream->burst + stream->burst_size, src, page_size);
+    stream->burst_size += page_size;
+    stream->burst_page_cnt++;
+    stream->lz_page_cnt += lz_size ? 1 : 0;
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Write the pages in the burst to all modules.
+ *
+ * \param[in] stream The firmware stream.
+ *
+ * \return The result of the synchronization.
+ */
+static esp_err_t module_firmware_burst_flush(module_firmware_stream_t *stream)
+{
+    of_display_t *display = stream->display;
+
+    if (stream->burst_page_cnt == 0) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "writing pages %d to %d in %d bytes", stream->burst_index,
+             stream->burst_index + stream->burst_page_cnt - 1, stream->burst_size);
+
+    /* All modules share the same burst buffer. */
+    esp_err_t err = ESP_OK;
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display) && err == ESP_OK; i++) {
+        module_t *module = display_module_get(display, i);
+        err = of_module_firmware_burst_set(module, stream->burst_index, stream->burst, stream->burst_size);
+        module_property_indicate_desynchronized(module, OF_MDL_PROP_FIRMWARE_BURST);
+    }
+    if (err == ESP_OK) {
+        display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_BURST, PROPERTY_SYNC_METHOD_WRITE);
+    }
+    display_unlock(display);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to set burst");
+
+    stream->burst_size     = 0;
+    stream->burst_page_cnt = 0;
+    stream->burst_cnt++;
+
+    ESP_RETURN_ON_ERROR(of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS), TAG,
+                        "Failed to synchronize display.");
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Keep the last #LZSS_WINDOW_SIZE bytes of the firmware that have been handled.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] page The firmware page that was written to, or is already present on, the modules.
+ */
+static void module_firmware_history_append(module_firmware_stream_t *stream, const module_firmware_page_t *page)
+{
+    if (stream->history == NULL) {
+        return;
+    }
+
+    if (stream->history_size == LZSS_WINDOW_SIZE) {
+        memmove(stream->history, stream->history + OF_FIRMWARE_UPDATE_PAGE_SIZE,
+                LZSS_WINDOW_SIZE - OF_FIRMWARE_UPDATE_PAGE_SIZE);
+        stream->history_size -= OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    }
+    memcpy(stream->history + stream->history_size, page->data, OF_FIRMWARE_UPDATE_PAGE_SIZE);
+    stream->history_size += OF_FIRMWARE_UPDATE_PAGE_SIZE;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Reboot all modules after the firmware has been transmitted.
+ *
+ * \param[in] display The display to reboot.
+ *
+ * \return The result of the synchronization.
+ */
+static esp_err_t module_firmware_reboot(of_display_t *display)
+{
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display); i++) {
+        module_t *module = display_module_get(display, i);
+        /* All data has been transmitted, reboot the modules. */
+        of_module_command_set(module, CMD_REBOOT);
+        module_property_indicate_desynchronized(module, OF_MDL_PROP_COMMAND);
+    }
+    display_property_indicate_desynchronized(display, OF_MDL_PROP_COMMAND, PROPERTY_SYNC_METHOD_WRITE);
+    display_unlock(display);
+
+    /* Synchronize. */
+    ESP_RETURN_ON_ERROR(of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS), TAG,
+                        "Failed to synchronize display.");
+
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Read the CRC of every page in the new app region of all modules.
+ *
+ * Pages of which all modules report the same CRC can be skipped when the new firmware contains the same page. When the
+ * modules don't support the firmware page CRC property, no page is skipped.
+ *
+ * \param[in] stream The firmware stream.
+ */
+static void module_firmware_page_crc_survey(module_firmware_stream_t *stream)
+{
+    of_display_t *display = stream->display;
+
+    stream->page_crc       = calloc(stream->page_cnt, sizeof(uint32_t));
+    stream->page_crc_valid = calloc(stream->page_cnt, sizeof(bool));
+    if (stream->page_crc == NULL || stream->page_crc_valid == NULL) {
+        ESP_LOGW(TAG, "Not enough memory to compare pages, sending all pages");
+        return;
+    }
+
+    for (uint16_t window = 0; window < stream->page_cnt; window += OF_FIRMWARE_PAGE_CRC_CNT) {
+        /* Select the window of pages. */
+        esp_err_t err = ESP_OK;
+        display_lock(display);
+        for (uint16_t i = 0; i < display_size_get(display) && err == ESP_OK; i++) {
+            module_t *module = display_module_get(display, i);
+            err = of_module_firmware_page_crc_window_set(module, OF_FIRMWARE_REGION_NEW_APP, window);
+            module_property_indicate_desynchronized(module, OF_MDL_PROP_FIRMWARE_PAGE_CRC);
+        }
+        if (err == ESP_OK) {
+            display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_PAGE_CRC,
+                                                     PROPERTY_SYNC_METHOD_WRITE);
+        }
+        display_unlock(display);
+        if (err != ESP_OK) {
+            return;
+        }
+        err = of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS);
+
+        /* Read the CRCs of the pages in the window. */
+        if (err == ESP_OK) {
+            display_property_indicate_desynchronized(display, OF_MDL_PROP_FIRMWARE_PAGE_CRC, PROPERTY_SYNC_METHOD_READ);
+            err = of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS);
+        }
+
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Modules did not report page CRCs, sending all remaining pages");
+            display_property_indicate_synchronized(display, OF_MDL_PROP_FIRMWARE_PAGE_CRC);
+            return;
+        }
+
+        /* A module which joined the chain since the window was selected has no page CRCs. */
+        display_lock(display);
+        for (uint16_t page = window; page < window + OF_FIRMWARE_PAGE_CRC_CNT && page < stream->page_cnt; page++) {
+            const firmware_page_crc_property_t *first = NULL;
+            bool valid                                = true;
+            for (uint16_t i = 0; valid && i < display_size_get(display); i++) {
+                const firmware_page_crc_property_t *page_crc = display_module_get(display, i)->firmware_page_crc;
+                first = (first == NULL) ? page_crc : first;
+                valid = page_crc != NULL && page_crc->region == OF_FIRMWARE_REGION_NEW_APP &&
+                        page_crc->index == window && page_crc->crc[page - window] == first->crc[page - window];
+            }
+            stream->page_crc[page]       = (first != NULL) ? first->crc[page - window] : 0;
+            stream->page_crc_valid[page] = valid && first != NULL;
+        }
+        display_unlock(display);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Release the page CRCs and the burst once the chain no longer uses them.
+ *
+ * A synchronization which timed out may still be running, and read the page CRCs of the modules or write their burst
+ * from the burst buffer of the stream. A pass that starts after the properties have been marked synchronized does not
+ * use them, so they are released once such a pass has completed.
+ *
+ * \param[in] stream The firmware stream.
+ */
+static void module_firmware_properties_release(module_firmware_stream_t *stream)
+{
+    of_display_t *display = stream->display;
+
+    display_property_indicate_synchronized(display, OF_MDL_PROP_FIRMWARE_PAGE_CRC);
+    display_property_indicate_synchronized(display, OF_MDL_PROP_FIRMWARE_BURST);
+    while (of_display_synchronize(display, MODULE_FIRMWARE_PAGE_TIMEOUT_MS) == ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "Waiting for the chain to finish the firmware update");
+    }
+
+    display_lock(display);
+    for (uint16_t i = 0; i < display_size_get(display); i++) {
+        of_module_firmware_page_crc_clear(display_module_get(display, i));
+        of_module_firmware_burst_clear(display_module_get(display, i));
+    }
+    display_unlock(display);
+    free(stream->burst);
+    stream->burst = NULL;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Check if all modules already contain a firmware page.
+ *
+ * \param[in] stream The firmware stream.
+ * \param[in] page The firmware page.
+ *
+ * \return true if the page does not need to be written, false otherwise.
+ */
+static bool module_firmware_page_is_present(const module_firmware_stream_t *stream, const module_firmware_page_t *page)
+{
+    if (stream->page_crc_valid == NULL || page->index >= stream->page_cnt || !stream->page_crc_valid[page->index]) {
+        return false;
+    }
+
+    return module_firmware_page_crc_calculate(page->data) == stream->page_crc[page->index];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Calculate the CRC of a firmware page the same way the CRC peripheral of a module does.
+ *
+ * The page is fed as little endian 32-bit words into a CRC-32/MPEG-2.
+ *
+ * \param[in] data The firmware page.
+ *
+ * \return The CRC of the page.
+ */
+static uint32_t module_firmware_page_crc_calculate(const uint8_t *data)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < OF_FIRMWARE_UPDATE_PAGE_SIZE; i += 4) {
+        uint32_t word = (uint32_t)data[i] | (uint32_t)data[i + 1] << 8 | (uint32_t)data[i + 2] << 16 |
+                        (uint32_t)data[i + 3] << 24;
+        crc ^= word;
+        for (uint8_t bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+
+    return crc;
+}
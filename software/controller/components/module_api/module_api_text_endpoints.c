@@ -0,0 +1,317 @@
+#include "module_api_text_endpoints.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "openflap_display.h"
+#include "openflap_module.h"
+#include "openflap_properties.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#define TAG "MODULE_TEXT_ENDPOINTS"
+
+#define ROWS_QUERY_KEY_STR    "rows"
+#define COLUMNS_QUERY_KEY_STR "columns"
+#define ALIGN_QUERY_KEY_STR   "align"
+
+#define QUERY_STR_LEN_MAX       (64)
+#define QUERY_VALUE_STR_LEN_MAX (12)
+
+/** The largest UTF-8 character, each module shows a single character. */
+#define TEXT_CHARACTER_SIZE_MAX (4)
+
+/** The character shown by modules without text. */
+#define TEXT_BLANK_STR " "
+
+/**
+ * \brief Horizontal alignment of the lines of text.
+ */
+typedef enum {
+    MODULE_TEXT_ALIGN_LEFT,
+    MODULE_TEXT_ALIGN_CENTER,
+    MODULE_TEXT_ALIGN_RIGHT,
+} module_text_align_t;
+
+/**
+ * \brief Layout of the modules of the display.
+ *
+ * The modules are ordered column by column, starting with the top module of the leftmost column.
+ */
+typedef struct {
+    uint16_t rows;             /**< Number of rows of the display. */
+    uint16_t columns;          /**< Number of columns of the display. */
+    module_text_align_t align; /**< Alignment of each line. */
+} module_text_layout_t;
+
+static esp_err_t module_text_layout_get(httpd_req_t *req, of_display_t *display, module_text_layout_t *layout);
+static esp_err_t module_text_query_get(httpd_req_t *req, const char *key, char *value, size_t value_size);
+static esp_err_t module_text_query_number_get(httpd_req_t *req, const char *key, uint16_t *number);
+static char *module_text_arrange(const char *text, const module_text_layout_t *layout);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t module_api_text_post_handler(httpd_req_t *req)
+{
+    of_display_t *display = (of_display_t *)req->user_ctx;
+    uint16_t module_count = display_size_get(display);
+
+    module_text_layout_t layout;
+    if (module_text_layout_get(req, display, &layout) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid layout");
+        return ESP_FAIL;
+    }
+
+    /* Every module shows a single character, every row may end with a CRLF. */
+    size_t text_size_max = (size_t)module_count * TEXT_CHARACTER_SIZE_MAX + layout.rows * 2;
+    if (req->content_len > text_size_max) {
+        ESP_LOGE(TAG, "Text of %zu bytes does not fit on the display", req->content_len);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Text too long");
+        return ESP_FAIL;
+    }
+
+    /* Read the text. */
+    char *text = calloc(req->content_len + 1, 1);
+    if (text == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the text");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+    for (int total_len = 0, recv_len = 0; total_len < req->content_len; total_len += recv_len) {
+        recv_len = httpd_req_recv(req, text + total_len, req->content_len - total_len);
+        if (recv_len <= 0) {
+            ESP_LOGE(TAG, "Failed to receive the text");
+            free(text);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+            return ESP_FAIL;
+        }
+    }
+
+    /* Place the text on the modules. */
+    char *display_text = module_text_arrange(text, &layout);
+    free(text);
+    uint8_t *indices = malloc(module_count);
+    if (display_text == NULL || indices == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the character indices");
+        free(display_text);
+        free(indices);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    /* The character sets which the indices refer to must not change before the indices are applied. */
+    display_lock(display);
+    uint16_t index_cnt = 0;
+    esp_err_t err      = display_text_character_indices_get(display, display_text, indices, &index_cnt);
+    free(display_text);
+    if (err == ESP_FAIL) {
+        display_unlock(display);
+        free(indices);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Character not in character set");
+        return ESP_FAIL;
+    } else if (err != ESP_OK) {
+        /* The character sets have not been read from the modules yet, the client can try again later. */
+        display_unlock(display);
+        free(indices);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "Character sets not available");
+        return ESP_FAIL;
+    }
+
+    /* Only the modules of which the character changes have to be written. */
+    for (uint16_t i = 0; i < index_cnt; i++) {
+        module_t *module = display_module_get(display, i);
+        if (module_character_index_get(module) != indices[i]) {
+            of_module_character_index_set(module, indices[i]);
+            module_property_indicate_desynchronized(module, OF_MDL_PROP_CHARACTER);
+        }
+    }
+    display_property_indicate_desynchronized(display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+    display_unlock(display);
+    free(indices);
+
+    httpd_resp_sendstr(req, "OK");
+
+    /* Notify that we have updated the display modules. */
+    of_display_synchronize(display, 0);
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the layout of the display from the query of a request.
+ *
+ * Without a rows or columns parameter, every module with the column end property ends a column. A display without
+ * column ends is a single row.
+ *
+ * \param[in] req The HTTP request.
+ * \param[in] display The display.
+ * \param[out] layout The layout.
+ *
+ * \retval ESP_OK The layout is valid.
+ * \retval ESP_ERR_INVALID_ARG The layout does not fit on the display or the alignment is unknown.
+ */
+static esp_err_t module_text_layout_get(httpd_req_t *req, of_display_t *display, module_text_layout_t *layout)
+{
+    char value[QUERY_VALUE_STR_LEN_MAX];
+    uint16_t module_count = display_size_get(display);
+    ESP_RETURN_ON_FALSE(module_count > 0, ESP_ERR_INVALID_ARG, TAG, "Display has no modules");
+
+    ESP_RETURN_ON_ERROR(module_text_query_number_get(req, ROWS_QUERY_KEY_STR, &layout->rows), TAG, "Invalid rows");
+    ESP_RETURN_ON_ERROR(module_text_query_number_get(req, COLUMNS_QUERY_KEY_STR, &layout->columns), TAG,
+                        "Invalid columns");
+
+    if (layout->rows == 0 && layout->columns == 0) {
+        display_lock(display);
+        for (uint16_t i = 0; i < MIN(module_count, display_size_get(display)); i++) {
+            layout->columns += display_module_get(display, i)->column_end;
+        }
+        display_unlock(display);
+        layout->columns = layout->columns ? layout->columns : module_count;
+    }
+    if (layout->rows == 0 && layout->columns != 0) {
+        layout->rows = module_count / layout->columns;
+    } else if (layout->columns == 0) {
+        layout->columns = module_count / layout->rows;
+    }
+    ESP_RETURN_ON_FALSE(layout->rows > 0 && layout->columns > 0 &&
+                            (uint32_t)layout->rows * layout->columns <= module_count,
+                        ESP_ERR_INVALID_ARG, TAG, "Layout of %d rows and %d columns does not fit on %d modules",
+                        layout->rows, layout->columns, module_count);
+
+    layout->align = MODULE_TEXT_ALIGN_LEFT;
+    if (module_text_query_get(req, ALIGN_QUERY_KEY_STR, value, sizeof(value)) == ESP_OK) {
+        if (strcmp(value, "center") == 0) {
+            layout->align = MODULE_TEXT_ALIGN_CENTER;
+        } else if (strcmp(value, "right") == 0) {
+            layout->align = MODULE_TEXT_ALIGN_RIGHT;
+        } else {
+            ESP_RETURN_ON_FALSE(strcmp(value, "left") == 0, ESP_ERR_INVALID_ARG, TAG, "Unknown alignment %s", value);
+        }
+    }
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get a query parameter of a request.
+ *
+ * \param[in] req The HTTP request.
+ * \param[in] key The key of the parameter.
+ * \param[out] value The value of the parameter.
+ * \param[in] value_size The size of value.
+ *
+ * \retval ESP_OK The parameter has been found.
+ * \retval ESP_ERR_NOT_FOUND The request has no such parameter.
+ */
+static esp_err_t module_text_query_get(httpd_req_t *req, const char *key, char *value, size_t value_size)
+{
+    char query[QUERY_STR_LEN_MAX];
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, key, value, value_size) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get a numeric query parameter of a request.
+ *
+ * \param[in] req The HTTP request.
+ * \param[in] key The key of the parameter.
+ * \param[out] number The value of the parameter, 0 if the request has no such parameter.
+ *
+ * \retval ESP_OK The parameter has been found or is not provided.
+ * \retval ESP_ERR_INVALID_ARG The parameter is not a number.
+ */
+static esp_err_t module_text_query_number_get(httpd_req_t *req, const char *key, uint16_t *number)
+{
+    char value[QUERY_VALUE_STR_LEN_MAX];
+
+    *number = 0;
+    if (module_text_query_get(req, key, value, sizeof(value)) != ESP_OK) {
+        return ESP_OK;
+    }
+
+    char *end            = NULL;
+    unsigned long parsed = strtoul(value, &end, 10);
+    ESP_RETURN_ON_FALSE(end != value && *end == '\0' && parsed <= UINT16_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid number %s", value);
+    *number = parsed;
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Arrange a text on the modules of the display.
+ *
+ * Each line of the text is shown on a row. A line which is longer than a row continues on the next row, lines beyond
+ * the last row are dropped. Modules without a character show a blank.
+ *
+ * \param[in] text The UTF-8 text, lines are separated by LF or CRLF.
+ * \param[in] layout The layout of the display.
+ *
+ * \return The character of each module in the order of the display, NULL if no memory is available.
+ */
+static char *module_text_arrange(const char *text, const module_text_layout_t *layout)
+{
+    uint32_t cell_cnt  = (uint32_t)layout->rows * layout->columns;
+    const char **cells = calloc(cell_cnt, sizeof(char *));
+    char *display_text = malloc(cell_cnt * TEXT_CHARACTER_SIZE_MAX + 1);
+    if (cells == NULL || display_text == NULL) {
+        free(cells);
+        free(display_text);
+        return NULL;
+    }
+
+    /* Place the characters of each row. */
+    for (uint16_t row = 0; row < layout->rows && *text != '\0'; row++) {
+        const char *line = text;
+        uint16_t length  = 0;
+        while (*text != '\0' && *text != '\n' && length < layout->columns) {
+            if (*text != '\r') {
+                length++;
+            }
+            text += character_utf8_size(text);
+        }
+
+        uint16_t column = 0;
+        if (layout->align == MODULE_TEXT_ALIGN_CENTER) {
+            column = (layout->columns - length) / 2;
+        } else if (layout->align == MODULE_TEXT_ALIGN_RIGHT) {
+            column = layout->columns - length;
+        }
+        for (; line < text; line += character_utf8_size(line)) {
+            if (*line != '\r') {
+                cells[column++ * layout->rows + row] = line;
+            }
+        }
+
+        /* A line that fits on the row ends here, a longer line continues on the next row. */
+        text += (*text == '\r') ? 1 : 0;
+        text += (*text == '\n') ? 1 : 0;
+    }
+
+    /* Join the characters in the order of the modules. */
+    char *end = display_text;
+    for (uint32_t i = 0; i < cell_cnt; i++) {
+        const char *character = cells[i] ? cells[i] : TEXT_BLANK_STR;
+        size_t size           = character_utf8_size(character);
+        memcpy(end, character, size);
+        end += size;
+    }
+    *end = '\0';
+
+    free(cells);
+    return display_text;
+}
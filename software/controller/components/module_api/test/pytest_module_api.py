@@ -4,9 +4,13 @@ import json
 from typing import List
 import requests
 import re
+import struct
 
 IP_AD_REGEX = r"ip:\s(\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3})"
 
+# Number of modules on the display, see TEST_MODULE_CNT in test.c
+MODULE_CNT = 6
+
 
 class OpenFlapModule:
     _module_counter = 0
@@ -49,6 +53,45 @@ class OpenFlapModule:
         return cls(**data)
 
 
+# Property ids, see openflap_properties.h
+PROP_CHARACTER = 5
+PROP_OFFSET = 6
+PROP_COLOR = 7
+
+
+def bin_entry(module_index: int, prop_id: int, payload: bytes) -> bytes:
+    return struct.pack("<HBH", module_index, prop_id, len(payload)) + payload
+
+
+def bin_entries_parse(data: bytes) -> dict:
+    entries = {}
+    while data:
+        module_index, prop_id, payload_size = struct.unpack_from("<HBH", data)
+        entries[(module_index, prop_id)] = data[5 : 5 + payload_size]
+        data = data[5 + payload_size :]
+    return entries
+
+
+def characters_get(ip_address: str) -> str:
+    # The chain masters are suspended, a large max_age serves the model without refreshing it from the chains.
+    response = requests.get(
+        f"http://{ip_address}:80/api/module?max_age=3600000",
+        headers={"Accept": "application/octet-stream"},
+    )
+    assert response.status_code == 200
+    entries = bin_entries_parse(response.content)
+    character_map = OpenFlapModule(moduleIndex=0).characterMap
+    return "".join(character_map[entries[(i, PROP_CHARACTER)][0]] for i in range(MODULE_CNT))
+
+
+def text_post(ip_address: str, text: str, query: str = "") -> requests.Response:
+    return requests.post(
+        f"http://{ip_address}:80/api/text{query}",
+        data=text.encode("utf-8"),
+        headers={"Content-Type": "text/plain"},
+    )
+
+
 def launch_unity_test_by_name(dut, name):
     testcase = [c for c in dut.test_menu if c.name == name][0]
     dut._get_ready(timeout=5)
@@ -69,7 +112,7 @@ def test_module_api(dut: IdfDut, mark) -> None:
     ip_address = ip_match.group(1).decode("utf-8")
 
     modules = []
-    for i in range(1):
+    for i in range(MODULE_CNT):
         module = OpenFlapModule(moduleIndex=i)
         modules.append(module)
 
@@ -91,6 +134,70 @@ def test_module_api(dut: IdfDut, mark) -> None:
     )
     assert response.status_code == 200
 
+    # Each module object is applied as soon as it is received, a body which is not an array of objects is rejected.
+    response = requests.post(
+        f"http://{ip_address}:80/api/module",
+        data=b'{"module": 0}',
+        headers={"Content-Type": "application/json"},
+    )
+    assert response.status_code == 400
+
+    # Binary format: module index, property id and payload size, followed by the payload in the chain format.
+    bin_data = b"".join(
+        bin_entry(module.moduleIndex, PROP_CHARACTER, bytes([module.moduleIndex + 1]))
+        + bin_entry(module.moduleIndex, PROP_OFFSET, bytes([10 + module.moduleIndex]))
+        + bin_entry(module.moduleIndex, PROP_COLOR, bytes([1, 2, 3, 4, 5, module.moduleIndex]))
+        for module in modules
+    )
+    response = requests.post(
+        f"http://{ip_address}:80/api/module",
+        data=bin_data,
+        headers={"Content-Type": "application/octet-stream"},
+    )
+    assert response.status_code == 200
+
+    # Entries with a wrong size or a character outside the character set are skipped.
+    bin_data = bin_entry(0, PROP_CHARACTER, bytes([48])) + bin_entry(0, PROP_COLOR, bytes([9, 9, 9]))
+    response = requests.post(
+        f"http://{ip_address}:80/api/module",
+        data=bin_data,
+        headers={"Content-Type": "application/octet-stream"},
+    )
+    assert response.status_code == 200
+
+    # The chain masters are suspended, a large max_age serves the model without refreshing it from the chains.
+    response = requests.get(
+        f"http://{ip_address}:80/api/module?max_age=3600000",
+        headers={"Accept": "application/octet-stream"},
+    )
+    assert response.status_code == 200
+    entries = bin_entries_parse(response.content)
+    for module in modules:
+        assert entries[(module.moduleIndex, PROP_CHARACTER)] == bytes([module.moduleIndex + 1])
+        assert entries[(module.moduleIndex, PROP_OFFSET)] == bytes([10 + module.moduleIndex])
+        assert entries[(module.moduleIndex, PROP_COLOR)] == bytes([1, 2, 3, 4, 5, module.moduleIndex])
+
+    # The modules are ordered column by column: with 2 rows of 3 columns, module 1 is the first module of row 2.
+    layout = "?rows=2&columns=3"
+    assert text_post(ip_address, "AB\nC", layout).status_code == 200
+    assert characters_get(ip_address) == "ACB   "
+    assert text_post(ip_address, "A\nBC", layout + "&align=center").status_code == 200
+    assert characters_get(ip_address) == " BAC  "
+    assert text_post(ip_address, "A\r\nBC", layout + "&align=right").status_code == 200
+    assert characters_get(ip_address) == "   BAC"
+
+    # A line longer than a row continues on the next row.
+    assert text_post(ip_address, "ABCDE", layout).status_code == 200
+    assert characters_get(ip_address) == "ADBEC "
+
+    # Text with a character outside the character set is rejected and leaves the modules untouched.
+    assert text_post(ip_address, "A%", layout).status_code == 400
+    assert characters_get(ip_address) == "ADBEC "
+
+    # A layout larger than the display is rejected, even when its size does not fit in an int.
+    assert text_post(ip_address, "A", "?rows=65535&columns=65535").status_code == 400
+    assert text_post(ip_address, "A", layout + "&align=top").status_code == 400
+
     dut.write(b"\n")  # Signal the rest to stop
     dut.expect_exact("Webserver stopped")
     dut.expect_unity_test_output()
@@ -1,17 +1,22 @@
 #include "cJSON.h"
 #include "esp_err.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "memory_checks.h"
 #include "module.h"
 #include "module_api.h"
 #include "networking.h"
 #include "openflap_display.h"
+#include "openflap_property_handlers.h"
 #include "properties.h"
 #include "unity.h"
 #include "webserver.h"
 
 #define TAG "module_api_TEST"
 
+/** Number of modules on the display, must match MODULE_CNT in pytest. */
+#define TEST_MODULE_CNT (6)
+
 TEST_CASE("Test module http API post handler", "[module_api][qemu]")
 {
     /* Configure Ethernet for testing on qemu. */
@@ -24,8 +29,34 @@ TEST_CASE("Test module http API post handler", "[module_api][qemu]")
 
     of_display_t display;
     TEST_ASSERT_EQUAL(of_display_init(&display), ESP_OK);
+    of_property_handlers_init();
     TEST_ASSERT_EQUAL(module_api_init(&webserver_ctx, &display), ESP_OK);
 
+    /* There is no chain to synchronize with, the modules are only changed through the API. */
+    of_display_chain_t *chain = &display.chains[0];
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        vTaskSuspend(display.chains[c].mdl_master.task);
+    }
+
+    /* The same modules as in pytest, with the character set that they report when read. */
+    const char characters[] = " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789*$!?.,:/@#&";
+    uint8_t character_set_bin[(sizeof(characters) - 1) * 4] = {0};
+    for (uint8_t i = 0; i < sizeof(characters) - 1; i++) {
+        character_set_bin[4 * i] = characters[i];
+    }
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, TEST_MODULE_CNT));
+    for (uint16_t i = 0; i < TEST_MODULE_CNT; i++) {
+        size_t size = sizeof(character_set_bin);
+        TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER_SET].handler.set(chain, i, character_set_bin, &size));
+    }
+
+    /* Without chain masters nothing is ever read, mark the model as read so a GET does not wait for the chains. */
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+            display.chains[c].prop_read_time_us[prop_id] = esp_timer_get_time();
+        }
+    }
+
     ESP_LOGI(TAG, "Webserver started");
 
     /* Wait for pytest to send a character. */
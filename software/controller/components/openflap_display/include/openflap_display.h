@@ -10,21 +10,85 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/** Properties older than this are refreshed by the background refresher. */
+#define OF_DISPLAY_REFRESH_MAX_AGE_MS_DEFAULT (30000)
+/** Interval at which the background refresher checks if the chain is idle. */
+#define OF_DISPLAY_REFRESH_POLL_MS (1000)
+
+/** Number of chains which are synchronized in parallel, one for every chain port of the controller. */
+#define OF_DISPLAY_CHAIN_CNT (OF_MDL_MASTER_CHAIN_CNT)
+
+typedef struct of_display_tag of_display_t;
 
 /**
- * \brief Display structure.
+ * \brief Number of modules with a certain content hash.
+ */
+typedef struct {
+    uint32_t hash; /**< Content hash of the property. (0 if the entry has never been used) */
+    uint16_t cnt;  /**< Number of modules with this hash. */
+} of_display_hash_cnt_t;
+
+/**
+ * \brief The content hashes of a property of all modules on a chain, counted per distinct hash.
+ *
+ * This is an open addressing hash table indexed by the content hash. Entries which have reached a count of 0 are only
+ * removed when the table is rebuilt.
+ */
+typedef struct {
+    of_display_hash_cnt_t *entries; /**< The entries of the table. */
+    uint16_t size;                  /**< Number of entries in the table, a power of two. */
+    uint16_t used_cnt;              /**< Number of entries that have been used since the table was rebuilt. */
+    uint16_t distinct_cnt;          /**< Number of distinct hashes, i.e. entries with a count above 0. */
+    bool invalid;                   /**< The table could not be grown, the counts are incomplete. */
+} of_display_prop_hashes_t;
+
+/**
+ * \brief A chain of modules, synchronized by its own chain communication master.
+ *
+ * The chain is used as the model user data of its master, the node index of the property handlers is relative to the
+ * first module of the chain.
  */
 typedef struct {
     of_mdl_master_ctx_t mdl_master; /**< Openflap Chain communication master context. */
+    of_display_t *display;          /**< The display the chain is part of. */
 
-    module_t **modules;    /**< Array of modules. */
-    uint16_t module_count; /**< Number of modules. */
+    module_t *modules;     /**< Array of modules on the chain, allocated as a single block. */
+    uint16_t module_count; /**< Number of modules on the chain. */
+    module_store_t store;  /**< The frequently used properties of the modules, stored per property. */
 
     /** Indicates which properties need to be synchronized by reading actual modules. */
     uint64_t sync_prop_read_required;
     /** Indicates which properties need to be synchronized by writing to actual modules. */
     uint64_t sync_prop_write_required;
-} of_display_t;
+    /** Indicates which properties are written by broadcasting their most common value, see #majority_value. */
+    uint64_t sync_prop_majority_broadcast;
+    /** A copy of the value which is broadcast, modules with another value are patched after the broadcast. */
+    uint8_t *majority_value[OF_MDL_PROP_CNT];
+    /** The size of the value which is broadcast. */
+    size_t majority_value_size[OF_MDL_PROP_CNT];
+
+    /** Time of the last successful read of each property in microseconds since boot. (0 if never read) */
+    int64_t prop_read_time_us[OF_MDL_PROP_CNT];
+
+    /** The content hashes of each property, used to check if all modules are identical without comparing them. */
+    of_display_prop_hashes_t prop_hashes[OF_MDL_PROP_CNT];
+} of_display_chain_t;
+
+/**
+ * \brief Display structure.
+ *
+ * The modules of all chains are merged into a single display, starting with the modules of the first chain.
+ */
+struct of_display_tag {
+    of_display_chain_t chains[OF_DISPLAY_CHAIN_CNT]; /**< The chains of the display. */
+    SemaphoreHandle_t lock; /**< Recursive lock of the modules and their synchronization flags, see #display_lock. */
+
+    TaskHandle_t refresh_task;   /**< Background refresher task handle. */
+    uint32_t refresh_max_age_ms; /**< Age at which the background refresher reads a property again. */
+};
 
 typedef enum {
     PROPERTY_SYNC_METHOD_READ,  /**< Property is synchronized by reading the actual module. */
@@ -45,6 +109,8 @@ esp_err_t of_display_init(of_display_t *display);
 /**
  * \brief Destroy the display.
  *
+ * The background refresher is stopped and all modules are removed.
+ *
  * \param[in] display The display to destroy.
  */
 esp_err_t display_destroy(of_display_t *display);
@@ -62,6 +128,28 @@ uint16_t display_size_get(of_display_t *display);
 
 //---------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Lock the modules of the display.
+ *
+ * The modules of a chain are moved or freed when the chain is resized, which is done by the task of the chain. A module
+ * may only be used while the display is locked, and must not be kept after the display is unlocked. The lock is
+ * recursive. The chains take the lock while they synchronize, so don't wait for a synchronization while holding it.
+ *
+ * \param[in] display The display to lock.
+ */
+void display_lock(of_display_t *display);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Unlock the modules of the display.
+ *
+ * \param[in] display The display to unlock.
+ */
+void display_unlock(of_display_t *display);
+
+//---------------------------------------------------------------------------------------------------------------------
+
 /**
  * \brief Synchronize the display with the actual modules.
  *
@@ -72,9 +160,76 @@ esp_err_t of_display_synchronize(of_display_t *display, uint32_t timeout_ms);
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Get the merged statistics of the last completed synchronization pass of every chain.
+ *
+ * Counters are summed over the chains, durations and delays are the longest of all chains because the chains are
+ * synchronized in parallel.
+ *
+ * \param[in] display The display ctx.
+ * \param[out] stats The merged statistics.
+ *
+ * \retval ESP_OK The statistics were merged.
+ * \retval ESP_ERR_INVALID_ARG The display or stats is NULL.
+ */
+esp_err_t of_display_sync_stats_get(of_display_t *display, of_mdl_master_sync_stats_t *stats);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Read the properties of the display which are older than a given age.
+ *
+ * Only properties which can be represented as JSON are considered. Properties with a pending write are not read, the
+ * model already holds their most recent value.
+ *
+ * \param[in] display The display to refresh.
+ * \param[in] max_age_ms The maximum age of a property in milliseconds before it is read again. (0 to read all)
+ * \param[in] timeout_ms The timeout in milliseconds to wait for synchronization. (0 for no wait)
+ *
+ * \retval ESP_OK All properties are younger than max_age_ms or have been read.
+ * \retval ESP_ERR_INVALID_ARG The display is NULL.
+ * \retval ESP_ERR_TIMEOUT The synchronization did not complete within the timeout.
+ * \retval ESP_FAIL The synchronization failed.
+ */
+esp_err_t of_display_refresh(of_display_t *display, uint32_t max_age_ms, uint32_t timeout_ms);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Start a low priority task which keeps the model fresh by reading stale properties while the chain is idle.
+ *
+ * The refresher reads at most one property per synchronization pass, so it never delays other requests by more than a
+ * single read.
+ *
+ * \param[in] display The display to refresh.
+ * \param[in] max_age_ms The age in milliseconds at which a property is read again.
+ *
+ * \retval ESP_OK The refresher has been started.
+ * \retval ESP_ERR_INVALID_ARG The display is NULL or max_age_ms is 0.
+ * \retval ESP_ERR_INVALID_STATE The refresher is already running.
+ * \retval ESP_ERR_NO_MEM The task could not be created.
+ */
+esp_err_t of_display_background_refresh_start(of_display_t *display, uint32_t max_age_ms);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the time since a property was last read from the modules.
+ *
+ * \param[in] display The display ctx.
+ * \param[in] property_id The id of the property.
+ *
+ * \return The age of the property in milliseconds, UINT32_MAX if the property has never been read.
+ */
+uint32_t display_property_age_ms_get(of_display_t *display, mdl_prop_id_t property_id);
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * \brief Get a module from the display by the module index.
  *
+ * The module may only be used while the display is locked, see #display_lock.
+ *
  * \param[in] display The display to get the module from.
  * \param[in] module_index The index of the module to get.
  *
@@ -84,6 +239,91 @@ module_t *display_module_get(of_display_t *display, uint16_t module_index);
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Get the chain of a module of the display.
+ *
+ * The chain is the user data of the binary property handlers, see #mdl_prop_list.
+ *
+ * \param[in] display The display ctx.
+ * \param[in] module_index The index of the module on the display.
+ * \param[out] node_idx The index of the module on the chain.
+ *
+ * \return The chain if the module exists, NULL otherwise.
+ */
+of_display_chain_t *display_module_chain_get(of_display_t *display, uint16_t module_index, uint16_t *node_idx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get a module from a chain by its node index on the chain.
+ *
+ * The module may only be used while the display is locked, see #display_lock.
+ *
+ * \param[in] chain The chain to get the module from.
+ * \param[in] node_idx The index of the module on the chain.
+ *
+ * \return The module if found, NULL otherwise.
+ */
+module_t *display_chain_module_get(of_display_chain_t *chain, uint16_t node_idx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the value of a property which is broadcast to every node of a chain.
+ *
+ * The value is copied from the modules when the broadcast of the most common value is planned, so modules which are
+ * changed while the broadcast is sent do not alter it.
+ *
+ * \param[in] chain The chain to which the value is broadcast.
+ * \param[in] property_id The id of the property that is written.
+ * \param[out] buf The buffer to copy the value to.
+ * \param[out] size The size of the value.
+ *
+ * \return true if the most common value of the property is broadcast, false otherwise.
+ */
+bool display_chain_broadcast_value_get(of_display_chain_t *chain, mdl_prop_id_t property_id, uint8_t *buf,
+                                       size_t *size);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Serialize a property of a module to the chain format, as it is stored in the model.
+ *
+ * Unlike the chain format handler, this ignores a broadcast of the most common value which is in progress.
+ *
+ * \param[in] chain The chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[in] property_id The id of the property.
+ * \param[out] buf The buffer to serialize to, room for #MDL_PAYLOAD_SIZE_MAX bytes.
+ * \param[out] size The size of the serialized property.
+ *
+ * \return true if the property was serialized, false otherwise.
+ */
+bool display_chain_module_to_bin(of_display_chain_t *chain, uint16_t node_idx, mdl_prop_id_t property_id,
+                                 uint8_t *buf, size_t *size);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Convert a UTF-8 text into the character index of every module.
+ *
+ * The n-th character of the text is looked up in the character set of the n-th module of the display, in a single
+ * pass over the text. Characters beyond the last module are ignored.
+ *
+ * \param[in] display The display ctx.
+ * \param[in] text The NUL terminated UTF-8 text.
+ * \param[out] indices The character index of every module, room for #display_size_get entries.
+ * \param[out] index_cnt The number of indices, the number of characters of the text or the size of the display.
+ *
+ * \retval ESP_OK The text has been converted.
+ * \retval ESP_ERR_INVALID_ARG An argument is NULL or a module has no character set.
+ * \retval ESP_FAIL A character is not in the character set of its module, index_cnt is the index of this module.
+ */
+esp_err_t display_text_character_indices_get(of_display_t *display, const char *text, uint8_t *indices,
+                                             uint16_t *index_cnt);
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * \brief Indicate that a property of all modules has been updated and synchronisation between the display and model is
  * required.
@@ -113,6 +353,23 @@ esp_err_t display_property_indicate_synchronized(of_display_t *display, mdl_prop
 
 //---------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Check if a property is identical for all modules of the display.
+ *
+ * This is decided by the content hashes of the modules, see #module_property_hash_update, in constant time per chain.
+ * Different values with the same hash are reported as uniform, a broadcast of such a value leaves the modules which
+ * hold another value desynchronized, see #display_chain_broadcast_value_get.
+ *
+ * \param[in] display The display.
+ * \param[in] property_id The id of the property to check.
+ *
+ * \retval true The display has modules and the property of all modules has the same value.
+ * \retval false The property differs between modules, has no value or can't be compared.
+ */
+bool display_property_is_uniform(of_display_t *display, mdl_prop_id_t property_id);
+
+//---------------------------------------------------------------------------------------------------------------------
+
 /**
  * \brief Promote a property from write sequence to write all.
  *
@@ -1,9 +1,12 @@
 #include "openflap_display.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "openflap_property_handlers.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 
 //======================================================================================================================
 //                                                   MACROS a DEFINES
@@ -11,17 +14,59 @@
 
 #define TAG "DISPLAY"
 
+#define OF_DISPLAY_REFRESH_TASK_SIZE 3072
+#define OF_DISPLAY_REFRESH_TASK_PRIO (tskIDLE_PRIORITY + 1)
+
+/** Initial size of the content hash tables, see #of_display_prop_hashes_t. */
+#define OF_DISPLAY_HASH_TABLE_SIZE_MIN (8)
+/** Largest size of the content hash tables. */
+#define OF_DISPLAY_HASH_TABLE_SIZE_MAX (32768)
+
+/** Bytes sent for every written module of a sequential write, besides the payload: the header and the checksum. */
+#define OF_DISPLAY_WRITE_MODULE_OVERHEAD (2)
+/** Bytes sent for every skipped module of a sequential write: the header of an empty property. */
+#define OF_DISPLAY_WRITE_SKIP_SIZE (1)
+/** Bytes sent to end a sequential write: two execute headers. */
+#define OF_DISPLAY_WRITE_END_SIZE (2)
+/** Bytes sent for a broadcast, besides the payload: the header, the checksum and the execute header. */
+#define OF_DISPLAY_BROADCAST_OVERHEAD (3)
+
+/** Properties which a module may briefly hold the most common value of, before it is patched with its own value.
+ * Characters and commands are excluded, they would make the flaps move. */
+#define OF_DISPLAY_MAJORITY_PATCH_PROP_MASK                                                                            \
+    ((1ULL << OF_MDL_PROP_CHARACTER_SET) | (1ULL << OF_MDL_PROP_COLOR) | (1ULL << OF_MDL_PROP_MOTION) |                \
+     (1ULL << OF_MDL_PROP_MINIMUM_ROTATION) | (1ULL << OF_MDL_PROP_IR_THRESHOLD))
+
 //======================================================================================================================
 //                                                   FUNCTION PROTOTYPES
 //======================================================================================================================
 
 static bool of_display_resize(void *model_userdata, uint16_t module_count);
+static bool of_display_chain_resize(of_display_chain_t *chain, uint16_t module_count);
 static bool of_display_module_exists_and_must_be_written(void *model_userdata, uint16_t node_idx,
                                                          mdl_prop_id_t property_id, bool *must_be_written);
 static void of_display_module_error_set(void *model_userdata, uint16_t node_idx, mdl_node_err_t error,
                                         mdl_node_state_t state);
 static mdl_action_t of_display_prop_sync_required(void *model_userdata, mdl_prop_id_t property_id);
 static void of_display_prop_sync_done(void *model_userdata, mdl_prop_id_t property_id);
+static uint16_t of_display_prop_write_node_cnt(void *model_userdata, mdl_prop_id_t property_id);
+static uint32_t of_display_baud_rate_get(void *model_userdata);
+static void of_display_baud_rate_set(void *model_userdata, uint32_t baud_rate);
+static bool of_display_prop_is_stale(of_display_t *display, mdl_prop_id_t property_id, uint32_t max_age_ms);
+static bool of_display_prop_write_required(of_display_t *display, mdl_prop_id_t property_id);
+static void of_display_chain_sync_flags_clear(of_display_chain_t *chain, mdl_prop_id_t property_id);
+static bool of_display_is_idle(of_display_t *display);
+static void of_display_refresh_task(void *arg);
+static void of_display_module_prop_hash_changed(void *userdata, mdl_prop_id_t property_id, uint32_t old_hash,
+                                                uint32_t new_hash);
+static bool of_display_chain_prop_is_uniform(of_display_chain_t *chain, mdl_prop_id_t property_id);
+static of_display_hash_cnt_t *of_display_prop_hash_find(const of_display_prop_hashes_t *hashes, uint32_t hash);
+static void of_display_prop_hash_count(of_display_prop_hashes_t *hashes, uint32_t hash, bool add);
+static bool of_display_prop_hashes_rebuild(of_display_prop_hashes_t *hashes);
+static mdl_action_t of_display_chain_write_action_get(of_display_chain_t *chain, mdl_prop_id_t property_id);
+static void of_display_chain_majority_clear(of_display_chain_t *chain, mdl_prop_id_t property_id);
+static const of_display_hash_cnt_t *of_display_prop_hash_majority_get(const of_display_prop_hashes_t *hashes);
+static uint32_t of_display_write_bytes_calc(uint16_t node_cnt, uint16_t written_cnt, size_t payload_size);
 
 //======================================================================================================================
 //                                                   PUBLIC FUNCTIONS
@@ -34,17 +79,29 @@ esp_err_t of_display_init(of_display_t *display)
     /* Clear memory. */
     memset(display, 0, sizeof(of_display_t));
 
+    /* The chain masters use the lock as soon as they are started. */
+    display->lock = xSemaphoreCreateRecursiveMutex();
+    ESP_RETURN_ON_FALSE(display->lock != NULL, ESP_ERR_NO_MEM, TAG, "Failed to create display lock");
+
     of_mdl_master_cb_cfg_t of_mdl_master_cb_cfg = {
         .node_cnt_update                 = of_display_resize,
         .node_exists_and_must_be_written = of_display_module_exists_and_must_be_written,
         .node_error_set                  = of_display_module_error_set,
         .model_sync_required             = of_display_prop_sync_required,
         .model_sync_done                 = of_display_prop_sync_done,
+        .model_write_node_cnt            = of_display_prop_write_node_cnt,
+        .model_baud_rate_get             = of_display_baud_rate_get,
+        .model_baud_rate_set             = of_display_baud_rate_set,
     };
 
-    ESP_RETURN_ON_ERROR(
-        of_mdl_master_init(&display->mdl_master, display, &of_mdl_master_cb_cfg, &display->module_count), TAG,
-        "Failed to initialize CC master");
+    /* Every chain port is synchronized by its own master, so the chains are synchronized in parallel. */
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        chain->display            = display;
+        ESP_RETURN_ON_ERROR(
+            of_mdl_master_init(&chain->mdl_master, c, chain, &of_mdl_master_cb_cfg, &chain->module_count), TAG,
+            "Failed to initialize CC master");
+    }
 
     return ESP_OK;
 }
@@ -55,8 +112,23 @@ esp_err_t display_destroy(of_display_t *display)
 {
     ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
 
+    /* The refresher only uses the display while it holds the lock, so it can be stopped safely. */
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    if (display->refresh_task != NULL) {
+        vTaskDelete(display->refresh_task);
+        display->refresh_task = NULL;
+    }
+
     /* Free modules. */
-    return of_display_resize(display, 0) ? ESP_OK : ESP_FAIL;
+    bool success = true;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        success &= of_display_resize(&display->chains[c], 0);
+    }
+    xSemaphoreGiveRecursive(display->lock);
+    vSemaphoreDelete(display->lock);
+    display->lock = NULL;
+
+    return success ? ESP_OK : ESP_FAIL;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -65,25 +137,277 @@ uint16_t display_size_get(of_display_t *display)
 {
     ESP_RETURN_ON_FALSE(display != NULL, 0, TAG, "Display is NULL");
 
-    return display->module_count;
+    /* Every chain only updates its own module count, so the total is never stored. */
+    uint16_t module_count = 0;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        module_count += display->chains[c].module_count;
+    }
+    return module_count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void display_lock(of_display_t *display)
+{
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void display_unlock(of_display_t *display)
+{
+    xSemaphoreGiveRecursive(display->lock);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 esp_err_t of_display_synchronize(of_display_t *display, uint32_t timeout_ms)
 {
-    return of_mdl_master_synchronize(&display->mdl_master, timeout_ms);
+    ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
+
+    /* Start all chains before waiting for any of them. */
+    of_mdl_master_sync_waiter_t waiters[OF_DISPLAY_CHAIN_CNT] = {0};
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        ESP_RETURN_ON_ERROR(
+            of_mdl_master_sync_join(&display->chains[c].mdl_master, timeout_ms ? &waiters[c] : NULL), TAG,
+            "Failed to join synchronization pass");
+    }
+
+    if (timeout_ms == 0) {
+        return ESP_OK;
+    }
+
+    /* The chains share the timeout. A timeout takes precedence over a failed synchronization. */
+    esp_err_t result    = ESP_OK;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        int64_t remaining_ms = MAX((deadline_us - esp_timer_get_time()) / 1000, 0);
+        esp_err_t err        = of_mdl_master_sync_wait(&display->chains[c].mdl_master, &waiters[c], remaining_ms);
+        if (err != ESP_OK && result != ESP_ERR_TIMEOUT) {
+            result = err;
+        }
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_display_sync_stats_get(of_display_t *display, of_mdl_master_sync_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(stats != NULL, ESP_ERR_INVALID_ARG, TAG, "Stats is NULL");
+
+    memset(stats, 0, sizeof(of_mdl_master_sync_stats_t));
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_mdl_master_sync_stats_t chain_stats;
+        ESP_RETURN_ON_ERROR(of_mdl_master_sync_stats_get(&display->chains[c].mdl_master, &chain_stats), TAG,
+                            "Failed to get chain statistics");
+
+        stats->prop_cnt = MAX(stats->prop_cnt, chain_stats.prop_cnt);
+        stats->node_cnt += chain_stats.node_cnt;
+        stats->frame_cnt += chain_stats.frame_cnt;
+        stats->tx_byte_cnt += chain_stats.tx_byte_cnt;
+        stats->rx_byte_cnt += chain_stats.rx_byte_cnt;
+        stats->rx_error_cnt += chain_stats.rx_error_cnt;
+        stats->duration_ms = MAX(stats->duration_ms, chain_stats.duration_ms);
+        stats->request_cnt = MAX(stats->request_cnt, chain_stats.request_cnt);
+        stats->window_ms   = MAX(stats->window_ms, chain_stats.window_ms);
+        stats->dirty_prop_mask |= chain_stats.dirty_prop_mask;
+        stats->dirty_node_cnt += chain_stats.dirty_node_cnt;
+        stats->preempt_cnt += chain_stats.preempt_cnt;
+        for (of_mdl_master_prio_t prio = 0; prio < OF_MDL_MASTER_PRIO_CNT; prio++) {
+            stats->queue_delay_ms[prio] = MAX(stats->queue_delay_ms[prio], chain_stats.queue_delay_ms[prio]);
+        }
+
+        /* The slowest chain with modules determines the baud rate. */
+        if (display->chains[c].module_count != 0 &&
+            (stats->baud_rate == 0 || chain_stats.baud_rate < stats->baud_rate)) {
+            stats->baud_rate = chain_stats.baud_rate;
+        }
+    }
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_display_refresh(of_display_t *display, uint32_t max_age_ms, uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
+
+    /* A write that is requested between checking and reading would be overwritten by the read. */
+    bool refresh_required = false;
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+        if (of_display_prop_is_stale(display, prop_id, max_age_ms)) {
+            display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_READ);
+            refresh_required = true;
+        }
+    }
+    xSemaphoreGiveRecursive(display->lock);
+
+    /* The model is fresh enough, don't touch the chain. */
+    if (!refresh_required) {
+        return ESP_OK;
+    }
+
+    return of_display_synchronize(display, timeout_ms);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_display_background_refresh_start(of_display_t *display, uint32_t max_age_ms)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(max_age_ms > 0, ESP_ERR_INVALID_ARG, TAG, "Refresh age must be larger than 0");
+    ESP_RETURN_ON_FALSE(display->refresh_task == NULL, ESP_ERR_INVALID_STATE, TAG, "Refresher already running");
+
+    display->refresh_max_age_ms = max_age_ms;
+    ESP_RETURN_ON_FALSE(xTaskCreate(of_display_refresh_task, "of_display_refresh", OF_DISPLAY_REFRESH_TASK_SIZE,
+                                    display, OF_DISPLAY_REFRESH_TASK_PRIO, &display->refresh_task),
+                        ESP_ERR_NO_MEM, TAG, "Failed to create refresh task");
+
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t display_property_age_ms_get(of_display_t *display, mdl_prop_id_t property_id)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, UINT32_MAX, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(property_id < OF_MDL_PROP_CNT, UINT32_MAX, TAG, "Invalid property id");
+
+    /* The property is as old as the chain that read it the longest time ago. */
+    int64_t read_time_us = INT64_MAX;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        read_time_us = MIN(read_time_us, display->chains[c].prop_read_time_us[property_id]);
+    }
+    if (read_time_us == 0) {
+        return UINT32_MAX; /* Never read. */
+    }
+
+    int64_t age_ms = (esp_timer_get_time() - read_time_us) / 1000;
+    return MIN(age_ms, UINT32_MAX);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 module_t *display_module_get(of_display_t *display, uint16_t module_index)
 {
-    if ((display == NULL) || (module_index >= display->module_count)) {
-        ESP_LOGE(TAG, "Invalid display or module index: %d", module_index);
+    ESP_RETURN_ON_FALSE(display != NULL, NULL, TAG, "Display is NULL");
+
+    /* The modules of the chains follow each other in the display. */
+    uint16_t node_idx = module_index;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        if (node_idx < chain->module_count) {
+            return &chain->modules[node_idx];
+        }
+        node_idx -= chain->module_count;
+    }
+
+    ESP_LOGE(TAG, "Invalid module index: %d", module_index);
+    return NULL;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+of_display_chain_t *display_module_chain_get(of_display_t *display, uint16_t module_index, uint16_t *node_idx)
+{
+    ESP_RETURN_ON_FALSE(display != NULL && node_idx != NULL, NULL, TAG, "Invalid arguments");
+
+    *node_idx = module_index;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        if (*node_idx < chain->module_count) {
+            return chain;
+        }
+        *node_idx -= chain->module_count;
+    }
+
+    ESP_LOGE(TAG, "Invalid module index: %d", module_index);
+    return NULL;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+module_t *display_chain_module_get(of_display_chain_t *chain, uint16_t node_idx)
+{
+    if ((chain == NULL) || (node_idx >= chain->module_count)) {
+        ESP_LOGE(TAG, "Invalid chain or node index: %d", node_idx);
         return NULL;
     }
-    return display->modules[module_index];
+    return &chain->modules[node_idx];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool display_chain_broadcast_value_get(of_display_chain_t *chain, mdl_prop_id_t property_id, uint8_t *buf,
+                                       size_t *size)
+{
+    if (chain == NULL || property_id >= OF_MDL_PROP_CNT || buf == NULL || size == NULL) {
+        return false;
+    }
+
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    bool broadcast = (chain->sync_prop_majority_broadcast & (1ULL << property_id)) != 0;
+    if (broadcast) {
+        memcpy(buf, chain->majority_value[property_id], chain->majority_value_size[property_id]);
+        *size = chain->majority_value_size[property_id];
+    }
+    xSemaphoreGiveRecursive(chain->display->lock);
+    return broadcast;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool display_chain_module_to_bin(of_display_chain_t *chain, uint16_t node_idx, mdl_prop_id_t property_id,
+                                 uint8_t *buf, size_t *size)
+{
+    if (chain == NULL || property_id >= OF_MDL_PROP_CNT || mdl_prop_list[property_id].handler.get == NULL) {
+        return false;
+    }
+
+    /* Hide the planned broadcast from the handler, the chain task can not observe this while the lock is held. */
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    uint64_t broadcast = chain->sync_prop_majority_broadcast;
+    chain->sync_prop_majority_broadcast &= ~(1ULL << property_id);
+    bool success = mdl_prop_list[property_id].handler.get(chain, node_idx, buf, size);
+    chain->sync_prop_majority_broadcast = broadcast;
+    xSemaphoreGiveRecursive(chain->display->lock);
+    return success;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t display_text_character_indices_get(of_display_t *display, const char *text, uint8_t *indices,
+                                             uint16_t *index_cnt)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, ESP_ERR_INVALID_ARG, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(text != NULL && indices != NULL && index_cnt != NULL, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid arguments");
+
+    /* The characters of the text are shown on the modules in the order of the display. */
+    esp_err_t err = ESP_OK;
+    *index_cnt    = 0;
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT && err == ESP_OK; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        for (uint16_t i = 0; i < chain->module_count && *text != '\0' && err == ESP_OK; i++) {
+            const char *character = text;
+            err = character_set_index_next(chain->modules[i].character_set, &text, &indices[*index_cnt]);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Character '%.*s' not in the character set of module %d", (int)(text - character),
+                         character, *index_cnt);
+            } else {
+                (*index_cnt)++;
+            }
+        }
+    }
+    xSemaphoreGiveRecursive(display->lock);
+
+    return err;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -98,11 +422,18 @@ esp_err_t display_property_indicate_desynchronized(of_display_t *display, mdl_pr
     // display_property_indicate_synchronized(display, property_id);
 
     /* Indicate that all modules have been desynchronised. */
-    if (sync_method == PROPERTY_SYNC_METHOD_READ) {
-        display->sync_prop_read_required |= (1 << property_id);
-    } else {
-        display->sync_prop_write_required |= (1 << property_id);
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        if (sync_method == PROPERTY_SYNC_METHOD_READ) {
+            chain->sync_prop_read_required |= (1ULL << property_id);
+        } else {
+            /* A pending read would overwrite the new value in the model before it is written. */
+            chain->sync_prop_read_required &= ~(1ULL << property_id);
+            chain->sync_prop_write_required |= (1ULL << property_id);
+        }
     }
+    xSemaphoreGiveRecursive(display->lock);
 
     return ESP_OK;
 }
@@ -115,26 +446,54 @@ esp_err_t display_property_indicate_synchronized(of_display_t *display, mdl_prop
     ESP_RETURN_ON_FALSE(property_id < OF_MDL_PROP_CNT, ESP_ERR_INVALID_ARG, TAG, "Invalid property id");
 
     /* Reset the synchronisation flags for display. */
-    display->sync_prop_read_required &= ~(1 << property_id);
-    display->sync_prop_write_required &= ~(1 << property_id);
-    for (uint16_t i = 0; i < display_size_get(display); i++) {
-        module_property_indicate_synchronized(display_module_get(display, i), property_id);
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        of_display_chain_sync_flags_clear(&display->chains[c], property_id);
     }
+    xSemaphoreGiveRecursive(display->lock);
 
     return ESP_OK;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+bool display_property_is_uniform(of_display_t *display, mdl_prop_id_t property_id)
+{
+    ESP_RETURN_ON_FALSE(display != NULL, false, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(property_id < OF_MDL_PROP_CNT, false, TAG, "Invalid property id");
+
+    /* Every chain must be uniform, with the same value as the other chains. */
+    bool is_uniform       = true;
+    const module_t *first = NULL;
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT && is_uniform; c++) {
+        of_display_chain_t *chain = &display->chains[c];
+        if (chain->module_count == 0) {
+            continue;
+        }
+        is_uniform = of_display_chain_prop_is_uniform(chain, property_id);
+        if (is_uniform && first != NULL) {
+            is_uniform = mdl_prop_list[property_id].handler.compare(first, &chain->modules[0]);
+        }
+        first = &chain->modules[0];
+    }
+    xSemaphoreGiveRecursive(display->lock);
+
+    return is_uniform && first != NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 void display_property_promote_write_seq_to_write_all(of_display_t *display)
 {
     if (display_size_get(display) == 0) {
         return;
     }
 
+    xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
     for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
 
-        if (!(display->sync_prop_write_required & (1 << prop_id))) {
+        if (!of_display_prop_write_required(display, prop_id)) {
             continue; // Property is not marked for writing.
         }
 
@@ -143,28 +502,27 @@ void display_property_promote_write_seq_to_write_all(of_display_t *display)
             continue;
         }
 
-        /* Get the serialized data for the first module. */
-        bool all_modules_are_same    = true;
-        module_t *module_a           = display_module_get(display, 0);
-        bool module_property_updated = module_property_is_desynchronized(module_a, prop_id);
+        /* The content hashes tell if all modules are the same without comparing them. */
+        if (!display_property_is_uniform(display, prop_id)) {
+            continue;
+        }
 
-        /* Compare the serialized data for the next properties. */
-        for (uint16_t i = 1; all_modules_are_same && i < display_size_get(display); i++) {
-            module_t *module_b = display_module_get(display, i);
-            module_property_updated |= module_property_is_desynchronized(module_b, prop_id);
-            all_modules_are_same &= mdl_prop_list[prop_id].handler.compare(module_a, module_b);
+        /* Check if the property has been updated on any module. */
+        bool module_property_updated = false;
+        for (uint16_t i = 0; !module_property_updated && i < display_size_get(display); i++) {
+            module_property_updated = module_property_is_desynchronized(display_module_get(display, i), prop_id);
         }
 
         /* If all modules are the same and the property has been updated, promote the write all. */
-        if (all_modules_are_same && module_property_updated) {
+        if (module_property_updated) {
             ESP_LOGI(TAG, "Promoting [%s] property to write all", mdl_prop_list[prop_id].attribute.name);
             display_property_indicate_desynchronized(display, prop_id, PROPERTY_SYNC_METHOD_WRITE);
             for (uint16_t i = 0; i < display_size_get(display); i++) {
-                module_a = display_module_get(display, i);
-                module_property_indicate_synchronized(module_a, prop_id);
+                module_property_indicate_desynchronized(display_module_get(display, i), prop_id);
             }
         }
     }
+    xSemaphoreGiveRecursive(display->lock);
 }
 
 //======================================================================================================================
@@ -173,37 +531,89 @@ void display_property_promote_write_seq_to_write_all(of_display_t *display)
 
 static bool of_display_resize(void *model_userdata, uint16_t module_count)
 {
-    of_display_t *display = (of_display_t *)model_userdata;
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
 
-    ESP_RETURN_ON_FALSE(display != NULL, false, TAG, "Display is NULL");
+    ESP_RETURN_ON_FALSE(chain != NULL, false, TAG, "Chain is NULL");
+
+    /* The modules are only used while the display is locked, so they are never moved or freed while in use. */
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    bool success = of_display_chain_resize(chain, module_count);
+    xSemaphoreGiveRecursive(chain->display->lock);
+
+    return success;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
 
-    if (module_count == display->module_count) {
+static bool of_display_chain_resize(of_display_chain_t *chain, uint16_t module_count)
+{
+    if (module_count == chain->module_count) {
         return true; /* No resize required. */
     }
 
-    ESP_LOGI(TAG, "Resizing display from %d to %d modules", display->module_count, module_count);
+    ESP_LOGI(TAG, "Resizing chain %d from %d to %d modules", chain->mdl_master.uart_ctx.chain, chain->module_count,
+             module_count);
+
+    /* Grow the store first, the modules remain valid if this fails. */
+    if (module_count > chain->module_count) {
+        ESP_RETURN_ON_FALSE(module_store_resize(&chain->store, module_count) == ESP_OK, false, TAG,
+                            "Failed to grow the module store");
+    }
 
-    /* Free the modules which will be removed by the realloc. */
-    for (uint16_t i = module_count; i < display->module_count; i++) {
-        module_free(display->modules[i]);
+    /* Free the modules which will be removed by the realloc, their properties are no longer counted. */
+    for (uint16_t i = module_count; i < chain->module_count; i++) {
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+            of_display_module_prop_hash_changed(chain, prop_id, module_property_hash_get(&chain->modules[i], prop_id),
+                                                0);
+        }
+        module_deinit(&chain->modules[i]);
     }
 
-    /* Reallocate memory for the modules. */
-    module_t **new_modules = NULL;
+    /* Reallocate memory for the modules, all modules of the chain are kept in a single block. */
+    module_t *new_modules = NULL;
     if (module_count == 0) {
-        free(display->modules);
+        free(chain->modules);
     } else {
-        new_modules = realloc(display->modules, module_count * sizeof(module_t *));
+        new_modules = realloc(chain->modules, module_count * sizeof(module_t));
+        if (new_modules == NULL && module_count < chain->module_count) {
+            /* The removed modules are already freed, the old block is large enough to keep the remaining ones. */
+            new_modules = chain->modules;
+        }
         ESP_RETURN_ON_FALSE(new_modules != NULL, false, TAG, "Failed to reallocate memory for modules");
     }
+    if (module_count < chain->module_count) {
+        module_store_resize(&chain->store, module_count);
+    }
+
+    /* Initialize the new modules after the realloc, and count the hashes of their initial properties. */
+    for (uint16_t i = chain->module_count; i < module_count; i++) {
+        module_init(&new_modules[i], &chain->store, i);
+        module_property_hash_changed_cb_set(&new_modules[i], of_display_module_prop_hash_changed, chain);
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+            module_property_hash_update(&new_modules[i], prop_id);
+        }
+    }
+
+    /* Start over with empty tables when the chain becomes empty. */
+    if (module_count == 0) {
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+            free(chain->prop_hashes[prop_id].entries);
+            memset(&chain->prop_hashes[prop_id], 0, sizeof(of_display_prop_hashes_t));
+        }
+    }
+
+    /* The new modules have never been read, so nothing in the model is fresh anymore. */
+    if (module_count > chain->module_count) {
+        memset(chain->prop_read_time_us, 0, sizeof(chain->prop_read_time_us));
+    }
 
-    /* Allocate the new modules after the realloc. */
-    for (uint16_t i = display->module_count; i < module_count; i++) {
-        new_modules[i] = module_new();
+    /* A planned broadcast of the most common value no longer covers all modules. */
+    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+        of_display_chain_majority_clear(chain, prop_id);
     }
 
-    display->modules      = new_modules;
-    display->module_count = module_count;
+    chain->modules      = new_modules;
+    chain->module_count = module_count;
 
     return true;
 }
@@ -213,9 +623,9 @@ static bool of_display_resize(void *model_userdata, uint16_t module_count)
 static bool of_display_module_exists_and_must_be_written(void *model_userdata, uint16_t node_idx,
                                                          mdl_prop_id_t property_id, bool *must_be_written)
 {
-    of_display_t *display = (of_display_t *)model_userdata;
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
 
-    module_t *module = display_module_get(display, node_idx);
+    module_t *module = display_chain_module_get(chain, node_idx);
     if (module == NULL) {
         *must_be_written = false;
         return false;
@@ -230,44 +640,454 @@ static bool of_display_module_exists_and_must_be_written(void *model_userdata, u
 static void of_display_module_error_set(void *model_userdata, uint16_t node_idx, mdl_node_err_t error,
                                         mdl_node_state_t state)
 {
-    // of_display_t *display = (of_display_t *)model_userdata;
-    (void)model_userdata;
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
 
-    ESP_LOGE(TAG, "Module %d error: (%d) %s, state: (%d) %s", node_idx, error, mdl_node_error_to_str(error), state,
-             mdl_node_state_to_str(state));
+    ESP_LOGE(TAG, "Module %d on chain %d error: (%d) %s, state: (%d) %s", node_idx, chain->mdl_master.uart_ctx.chain,
+             error, mdl_node_error_to_str(error), state, mdl_node_state_to_str(state));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 static mdl_action_t of_display_prop_sync_required(void *model_userdata, mdl_prop_id_t property_id)
 {
-    of_display_t *display = (of_display_t *)model_userdata;
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
+    mdl_action_t action       = -1; /* No synchronization required. */
 
     /* It should not be possible that a property is both read and written at the same time. */
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    if (chain->sync_prop_read_required & (1ULL << property_id)) {
+        action = MDL_ACTION_READ;
+    } else if (chain->sync_prop_write_required & (1ULL << property_id)) {
+        action = of_display_chain_write_action_get(chain, property_id);
+    }
+    xSemaphoreGiveRecursive(chain->display->lock);
+
+    return action;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_prop_sync_done(void *model_userdata, mdl_prop_id_t property_id)
+{
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
+
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    if (chain->sync_prop_read_required & (1ULL << property_id)) {
+        chain->prop_read_time_us[property_id] = esp_timer_get_time();
+    }
 
-    if (display->sync_prop_read_required & (1 << property_id)) {
-        return MDL_ACTION_READ;
-    } else if (display->sync_prop_write_required & (1 << property_id)) {
-        module_t *module_0 = display_module_get(display, 0);
-        bool can_broadcast = module_property_is_desynchronized(module_0, property_id);
-        can_broadcast &= mdl_prop_list[property_id].handler.compare != NULL;
-        for (int16_t i = 1; can_broadcast && i < display_size_get(display); i++) {
-            module_t *module_x = display_module_get(display, i);
-            can_broadcast &= module_property_is_desynchronized(module_x, property_id);
-            can_broadcast &= mdl_prop_list[property_id].handler.compare(module_0, module_x);
+    /* Only the modules which hold the broadcast value now match their node, the others must be patched. The modules are
+     * compared to the value which was sent, as they may have been changed since the broadcast was planned. */
+    if (chain->sync_prop_majority_broadcast & (1ULL << property_id)) {
+        chain->sync_prop_majority_broadcast &= ~(1ULL << property_id);
+        bool patch_required = false;
+        for (uint16_t i = 0; i < chain->module_count; i++) {
+            uint8_t buf[MDL_PAYLOAD_SIZE_MAX];
+            size_t size = sizeof(buf);
+            if (mdl_prop_list[property_id].handler.get(chain, i, buf, &size) &&
+                size == chain->majority_value_size[property_id] &&
+                memcmp(buf, chain->majority_value[property_id], size) == 0) {
+                module_property_indicate_synchronized(display_chain_module_get(chain, i), property_id);
+            } else {
+                patch_required = true;
+            }
+        }
+        of_display_chain_majority_clear(chain, property_id);
+        if (patch_required) {
+            xSemaphoreGiveRecursive(chain->display->lock);
+            return;
         }
+    }
+
+    /* The other chains may still be synchronizing the same property. */
+    of_display_chain_sync_flags_clear(chain, property_id);
+    xSemaphoreGiveRecursive(chain->display->lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
 
-        return can_broadcast ? MDL_ACTION_BROADCAST : MDL_ACTION_WRITE;
+static uint16_t of_display_prop_write_node_cnt(void *model_userdata, mdl_prop_id_t property_id)
+{
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
+    uint16_t node_cnt         = 0;
+
+    /* Modules after the last desynchronized module don't need to be addressed. */
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+    for (uint16_t i = chain->module_count; i > 0 && node_cnt == 0; i--) {
+        if (chain->store.sync_prop_write_required[i - 1] & (1ULL << property_id)) {
+            node_cnt = i;
+        }
     }
-    return -1; /* No synchronization required. */
+    xSemaphoreGiveRecursive(chain->display->lock);
+
+    return node_cnt;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-static void of_display_prop_sync_done(void *model_userdata, mdl_prop_id_t property_id)
+static uint32_t of_display_baud_rate_get(void *model_userdata)
+{
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
+
+    if (chain->module_count == 0) {
+        return 0;
+    }
+
+    /* The chain can only run as fast as its slowest module. */
+    uint32_t baud_rate = UINT32_MAX;
+    for (uint16_t i = 0; i < chain->module_count; i++) {
+        module_t *module = display_chain_module_get(chain, i);
+        if (module->baud_rate < baud_rate) {
+            baud_rate = module->baud_rate;
+        }
+    }
+    return baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_baud_rate_set(void *model_userdata, uint32_t baud_rate)
+{
+    of_display_chain_t *chain = (of_display_chain_t *)model_userdata;
+
+    for (uint16_t i = 0; i < chain->module_count; i++) {
+        display_chain_module_get(chain, i)->baud_rate = baud_rate;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool of_display_prop_is_stale(of_display_t *display, mdl_prop_id_t property_id, uint32_t max_age_ms)
+{
+    /* Only properties which are exposed through the api are kept fresh. */
+    if (mdl_prop_list[property_id].handler.get_alt == NULL) {
+        return false;
+    }
+
+    /* The model holds a newer value than the modules. */
+    if (of_display_prop_write_required(display, property_id)) {
+        return false;
+    }
+
+    return display_property_age_ms_get(display, property_id) >= max_age_ms;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_refresh_task(void *arg)
+{
+    of_display_t *display = (of_display_t *)arg;
+
+    while (1) {
+        vTaskDelay(MAX(pdMS_TO_TICKS(OF_DISPLAY_REFRESH_POLL_MS), 1));
+
+        /* Never compete with other requests for the chains. */
+        if (!of_display_is_idle(display)) {
+            continue;
+        }
+
+        /* A write that is requested between checking and reading would be overwritten by the read. The display can
+         * only be destroyed while the refresher is waiting for the lock or delayed. */
+        xSemaphoreTakeRecursive(display->lock, portMAX_DELAY);
+
+        /* Find the stalest property. */
+        mdl_prop_id_t stalest_prop_id = OF_MDL_PROP_CNT;
+        uint32_t stalest_age_ms       = 0;
+        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+            if (!of_display_prop_is_stale(display, prop_id, display->refresh_max_age_ms)) {
+                continue;
+            }
+            uint32_t age_ms = display_property_age_ms_get(display, prop_id);
+            if (stalest_prop_id == OF_MDL_PROP_CNT || age_ms > stalest_age_ms) {
+                stalest_prop_id = prop_id;
+                stalest_age_ms  = age_ms;
+            }
+        }
+
+        /* Read a single property so the pass stays short when a request arrives. */
+        if (stalest_prop_id != OF_MDL_PROP_CNT) {
+            ESP_LOGD(TAG, "Refreshing [%s] property", mdl_prop_list[stalest_prop_id].attribute.name);
+            display_property_indicate_desynchronized(display, stalest_prop_id, PROPERTY_SYNC_METHOD_READ);
+            of_display_synchronize(display, 0);
+        }
+        xSemaphoreGiveRecursive(display->lock);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool of_display_prop_write_required(of_display_t *display, mdl_prop_id_t property_id)
+{
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        if (display->chains[c].sync_prop_write_required & (1ULL << property_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_chain_sync_flags_clear(of_display_chain_t *chain, mdl_prop_id_t property_id)
+{
+    chain->sync_prop_read_required &= ~(1ULL << property_id);
+    chain->sync_prop_write_required &= ~(1ULL << property_id);
+    for (uint16_t i = 0; i < chain->module_count; i++) {
+        chain->store.sync_prop_write_required[i] &= ~(1ULL << property_id);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool of_display_is_idle(of_display_t *display)
+{
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        if (!of_mdl_master_is_idle(&display->chains[c].mdl_master)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_module_prop_hash_changed(void *userdata, mdl_prop_id_t property_id, uint32_t old_hash,
+                                                uint32_t new_hash)
 {
-    of_display_t *display = (of_display_t *)model_userdata;
-    display_property_indicate_synchronized(display, property_id);
+    of_display_chain_t *chain        = (of_display_chain_t *)userdata;
+    of_display_prop_hashes_t *hashes = &chain->prop_hashes[property_id];
+
+    /* The API tasks and the chain master both update modules, the table may be rebuilt while it is counted. */
+    xSemaphoreTakeRecursive(chain->display->lock, portMAX_DELAY);
+
+    /* Properties without a value are not counted. */
+    if (old_hash != 0) {
+        of_display_prop_hash_count(hashes, old_hash, false);
+    }
+    if (new_hash != 0) {
+        of_display_prop_hash_count(hashes, new_hash, true);
+    }
+    xSemaphoreGiveRecursive(chain->display->lock);
 }
 
-//----------------------------------------------------------------------------------------------------------------------
\ No newline at end of file
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool of_display_chain_prop_is_uniform(of_display_chain_t *chain, mdl_prop_id_t property_id)
+{
+    const of_display_prop_hashes_t *hashes = &chain->prop_hashes[property_id];
+
+    if (chain->module_count == 0 || hashes->invalid || hashes->distinct_cnt != 1) {
+        return false;
+    }
+
+    /* The single hash must belong to all modules, modules without a value are not counted. */
+    uint32_t hash = module_property_hash_get(&chain->modules[0], property_id);
+    if (hash == 0) {
+        return false;
+    }
+    of_display_hash_cnt_t *entry = of_display_prop_hash_find(hashes, hash);
+    if (entry == NULL || entry->cnt != chain->module_count) {
+        return false;
+    }
+
+    /* Values are not compared, that would cost as much as not having the hashes. Different values with the same hash
+     * are caught after a broadcast, when every module is compared to the value that was sent. */
+    return mdl_prop_list[property_id].handler.compare != NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static of_display_hash_cnt_t *of_display_prop_hash_find(const of_display_prop_hashes_t *hashes, uint32_t hash)
+{
+    if (hashes->size == 0) {
+        return NULL;
+    }
+
+    /* Linear probing, the table is never more than half full, so the search always ends at an unused entry. */
+    uint16_t mask = hashes->size - 1;
+    for (uint16_t i = hash & mask;; i = (i + 1) & mask) {
+        of_display_hash_cnt_t *entry = &hashes->entries[i];
+        if (entry->hash == hash || entry->hash == 0) {
+            return entry;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_prop_hash_count(of_display_prop_hashes_t *hashes, uint32_t hash, bool add)
+{
+    if (hashes->invalid) {
+        return;
+    }
+
+    of_display_hash_cnt_t *entry = of_display_prop_hash_find(hashes, hash);
+
+    if (!add) {
+        if (entry == NULL || entry->hash != hash || entry->cnt == 0) {
+            ESP_LOGE(TAG, "Removing a hash which has not been counted");
+            hashes->invalid = true;
+            return;
+        }
+        if (--entry->cnt == 0) {
+            hashes->distinct_cnt--;
+        }
+        return;
+    }
+
+    /* A new hash takes an unused entry, rebuild the table first when it would become more than half full. */
+    if (entry == NULL || entry->hash != hash) {
+        if ((hashes->used_cnt + 1) * 2 > hashes->size) {
+            if (!of_display_prop_hashes_rebuild(hashes)) {
+                ESP_LOGE(TAG, "Failed to grow the content hash table");
+                hashes->invalid = true;
+                return;
+            }
+            entry = of_display_prop_hash_find(hashes, hash);
+        }
+        entry->hash = hash;
+        hashes->used_cnt++;
+    }
+
+    if (entry->cnt++ == 0) {
+        hashes->distinct_cnt++;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool of_display_prop_hashes_rebuild(of_display_prop_hashes_t *hashes)
+{
+    /* Entries with a count of 0 are dropped, leave room for as many new hashes as there are distinct hashes. */
+    uint32_t size = OF_DISPLAY_HASH_TABLE_SIZE_MIN;
+    while (size < 4 * ((uint32_t)hashes->distinct_cnt + 1)) {
+        size *= 2;
+    }
+    ESP_RETURN_ON_FALSE(size <= OF_DISPLAY_HASH_TABLE_SIZE_MAX, false, TAG, "Too many distinct hashes");
+
+    of_display_prop_hashes_t rebuilt = {
+        .entries = calloc(size, sizeof(of_display_hash_cnt_t)),
+        .size    = size,
+    };
+    ESP_RETURN_ON_FALSE(rebuilt.entries != NULL, false, TAG, "Failed to allocate memory for the hash table");
+
+    for (uint16_t i = 0; i < hashes->size; i++) {
+        if (hashes->entries[i].cnt == 0) {
+            continue;
+        }
+        *of_display_prop_hash_find(&rebuilt, hashes->entries[i].hash) = hashes->entries[i];
+        rebuilt.used_cnt++;
+        rebuilt.distinct_cnt++;
+    }
+
+    free(hashes->entries);
+    *hashes = rebuilt;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static mdl_action_t of_display_chain_write_action_get(of_display_chain_t *chain, mdl_prop_id_t property_id)
+{
+    of_display_chain_majority_clear(chain, property_id);
+
+    /* The most common value can be broadcast, after which the modules with another value are patched by a sequential
+     * write. This is chosen when it sends fewer bytes than a sequential write to all modules. A broadcast reaches every
+     * module, so every module must be written. */
+    if (mdl_prop_list[property_id].handler.compare == NULL || mdl_prop_list[property_id].handler.get == NULL ||
+        chain->module_count == 0) {
+        return MDL_ACTION_WRITE;
+    }
+    for (uint16_t i = 0; i < chain->module_count; i++) {
+        if (!(chain->store.sync_prop_write_required[i] & (1ULL << property_id))) {
+            return MDL_ACTION_WRITE;
+        }
+    }
+
+    const of_display_hash_cnt_t *majority = of_display_prop_hash_majority_get(&chain->prop_hashes[property_id]);
+    if (majority == NULL) {
+        return MDL_ACTION_WRITE;
+    }
+    uint16_t patch_cnt = chain->module_count - majority->cnt;
+    if (patch_cnt > 0 && !(OF_DISPLAY_MAJORITY_PATCH_PROP_MASK & (1ULL << property_id))) {
+        return MDL_ACTION_WRITE;
+    }
+
+    /* Find a module to copy the broadcast value from and the last module which must be patched. */
+    uint16_t majority_node_idx = chain->module_count;
+    uint16_t patch_node_cnt    = 0;
+    for (uint16_t i = 0; i < chain->module_count; i++) {
+        if (module_property_hash_get(display_chain_module_get(chain, i), property_id) != majority->hash) {
+            patch_node_cnt = i + 1;
+        } else if (majority_node_idx == chain->module_count) {
+            majority_node_idx = i;
+        }
+    }
+
+    /* The payload of the broadcast is the same size as the payload of a sequential write of the same value. */
+    uint8_t buf[MDL_PAYLOAD_SIZE_MAX];
+    size_t payload_size = sizeof(buf);
+    if (!mdl_prop_list[property_id].handler.get(chain, majority_node_idx, buf, &payload_size)) {
+        return MDL_ACTION_WRITE;
+    }
+
+    uint32_t write_bytes     = of_display_write_bytes_calc(chain->module_count, chain->module_count, payload_size);
+    uint32_t broadcast_bytes = payload_size + OF_DISPLAY_BROADCAST_OVERHEAD;
+    if (patch_cnt > 0) {
+        broadcast_bytes += of_display_write_bytes_calc(patch_node_cnt, patch_cnt, payload_size);
+    }
+    if (broadcast_bytes >= write_bytes) {
+        return MDL_ACTION_WRITE;
+    }
+
+    if (patch_cnt > 0) {
+        ESP_LOGI(TAG, "Broadcasting the most common [%s] value, patching %d modules",
+                 mdl_prop_list[property_id].attribute.name, patch_cnt);
+    }
+
+    /* The value is copied, so every node receives the same value even if the modules change during the broadcast. */
+    chain->majority_value[property_id] = malloc(payload_size);
+    if (chain->majority_value[property_id] == NULL) {
+        return MDL_ACTION_WRITE;
+    }
+    memcpy(chain->majority_value[property_id], buf, payload_size);
+    chain->majority_value_size[property_id] = payload_size;
+    chain->sync_prop_majority_broadcast |= (1ULL << property_id);
+    return MDL_ACTION_BROADCAST;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void of_display_chain_majority_clear(of_display_chain_t *chain, mdl_prop_id_t property_id)
+{
+    chain->sync_prop_majority_broadcast &= ~(1ULL << property_id);
+    free(chain->majority_value[property_id]);
+    chain->majority_value[property_id]      = NULL;
+    chain->majority_value_size[property_id] = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const of_display_hash_cnt_t *of_display_prop_hash_majority_get(const of_display_prop_hashes_t *hashes)
+{
+    if (hashes->invalid) {
+        return NULL;
+    }
+
+    const of_display_hash_cnt_t *majority = NULL;
+    for (uint16_t i = 0; i < hashes->size; i++) {
+        if (hashes->entries[i].cnt > 0 && (majority == NULL || hashes->entries[i].cnt > majority->cnt)) {
+            majority = &hashes->entries[i];
+        }
+    }
+    return majority;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static uint32_t of_display_write_bytes_calc(uint16_t node_cnt, uint16_t written_cnt, size_t payload_size)
+{
+    /* Skipped nodes before the last written node still take an empty property, see docs/chain_com.md. */
+    return written_cnt * (payload_size + OF_DISPLAY_WRITE_MODULE_OVERHEAD) +
+           (node_cnt - written_cnt) * OF_DISPLAY_WRITE_SKIP_SIZE + OF_DISPLAY_WRITE_END_SIZE;
+}
@@ -1,9 +1,20 @@
 #include "esp_err.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "memory_checks.h"
 #include "openflap_display.h"
+#include "openflap_property_handlers.h"
 #include "unity.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
 #define TAG "DISPLAY_TEST"
 
 TEST_CASE("Test of_display_init display_destroy", "[display][qemu][target]")
@@ -39,4 +50,535 @@ TEST_CASE("Test of_display_init display_destroy: ok", "[display][qemu][target]")
 
     TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
     TEST_ASSERT_NULL(display.event_handle);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Benchmark sequential write bus time vs dirty module count", "[display][benchmark][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    /* Read the characters of all modules to discover the chain length. */
+    TEST_ASSERT_EQUAL(ESP_OK, display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER,
+                                                                       PROPERTY_SYNC_METHOD_READ));
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_synchronize(&display, 5000));
+
+    uint16_t module_count = display_size_get(&display);
+    TEST_ASSERT_GREATER_THAN(0, module_count);
+
+    printf("dirty_modules, nodes_written, frames, tx_bytes, rx_bytes, duration_ms\n");
+    for (uint16_t dirty_cnt = 1; dirty_cnt <= module_count; dirty_cnt *= 2) {
+        /* Mark the first modules as dirty, the remaining modules are untouched. The dirty modules alternate between two
+         * characters, a chain of identical dirty modules would be broadcast to instead of written sequentially. */
+        display_lock(&display);
+        for (uint16_t i = 0; i < dirty_cnt; i++) {
+            module_t *module = display_module_get(&display, i);
+            TEST_ASSERT_EQUAL(ESP_OK, of_module_character_index_set(module, i % 2));
+            module_property_indicate_desynchronized(module, OF_MDL_PROP_CHARACTER);
+        }
+        display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+        display_unlock(&display);
+        TEST_ASSERT_EQUAL(ESP_OK, of_display_synchronize(&display, 5000));
+
+        of_mdl_master_sync_stats_t stats;
+        TEST_ASSERT_EQUAL(ESP_OK, of_display_sync_stats_get(&display, &stats));
+        TEST_ASSERT_EQUAL(dirty_cnt, stats.node_cnt);
+        printf("%d, %d, %d, %" PRIu32 ", %" PRIu32 ", %" PRIu32 "\n", dirty_cnt, stats.node_cnt, stats.frame_cnt,
+               stats.tx_byte_cnt, stats.rx_byte_cnt, stats.duration_ms);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+typedef struct {
+    of_display_t *display;
+    SemaphoreHandle_t done;
+    esp_err_t result;
+} sync_caller_t;
+
+static void sync_caller_task(void *arg)
+{
+    sync_caller_t *caller = (sync_caller_t *)arg;
+    caller->result        = of_display_synchronize(caller->display, 5000);
+    xSemaphoreGive(caller->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Concurrent synchronize calls are coalesced", "[display][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER,
+                                                                       PROPERTY_SYNC_METHOD_READ));
+
+    /* Start all callers at once, each with its own timeout and result. */
+    sync_caller_t callers[10];
+    for (int i = 0; i < 10; i++) {
+        callers[i].display = &display;
+        callers[i].done    = xSemaphoreCreateBinary();
+        callers[i].result  = ESP_FAIL;
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(sync_caller_task, "sync_caller", 3072, &callers[i], 4, NULL));
+    }
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(callers[i].done, pdMS_TO_TICKS(6000)));
+        TEST_ASSERT_EQUAL(ESP_OK, callers[i].result);
+        vSemaphoreDelete(callers[i].done);
+    }
+
+    /* All callers are served by at most two passes: the one that was started first and the one they joined. */
+    of_mdl_master_sync_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_sync_stats_get(&display, &stats));
+    TEST_ASSERT_GREATER_OR_EQUAL(9, stats.request_cnt);
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+TEST_CASE("Property age is tracked from the last read", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    /* Nothing has been read yet. */
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, display_property_age_ms_get(&display, OF_MDL_PROP_CHARACTER));
+
+    /* A pending write makes a property fresh, the model holds the newest value. */
+    display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_READ);
+    display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        TEST_ASSERT_FALSE(display.chains[c].sync_prop_read_required & (1ULL << OF_MDL_PROP_CHARACTER));
+        TEST_ASSERT_TRUE(display.chains[c].sync_prop_write_required & (1ULL << OF_MDL_PROP_CHARACTER));
+    }
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, of_display_background_refresh_start(&display, 0));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+TEST_CASE("Chains are merged into a single display", "[display][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER,
+                                                                       PROPERTY_SYNC_METHOD_READ));
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_synchronize(&display, 5000));
+
+    /* The modules of the second chain follow the modules of the first chain. */
+    uint16_t module_index = 0;
+    for (uint8_t c = 0; c < OF_DISPLAY_CHAIN_CNT; c++) {
+        for (uint16_t i = 0; i < display.chains[c].module_count; i++) {
+            TEST_ASSERT_EQUAL_PTR(display_chain_module_get(&display.chains[c], i),
+                                  display_module_get(&display, module_index++));
+        }
+    }
+    TEST_ASSERT_EQUAL(display_size_get(&display), module_index);
+    TEST_ASSERT_NULL(display_module_get(&display, module_index));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+/** Module counts of the display model benchmark. */
+static const uint16_t model_benchmark_module_cnts[] = {16, 64, 256, 1024};
+
+/** Number of modules visited by each measurement, the calls are repeated until this many modules are visited. */
+#define MODEL_BENCHMARK_MODULE_VISIT_CNT (16384)
+
+static void model_benchmark_print(const char *function, uint16_t module_count, int64_t start_us, uint32_t call_cnt)
+{
+    int64_t duration_ns = (esp_timer_get_time() - start_us) * 1000;
+    printf("%s, %d, %" PRId64 "\n", function, module_count, duration_ns / call_cnt);
+}
+
+TEST_CASE("Benchmark display model time per call vs module count", "[display][benchmark][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+    of_property_handlers_init();
+
+    /* All modules are placed on the first chain, the model callbacks of a chain only visit the modules of that chain.
+     * The chain is never synchronized, so the master does not touch the model during the benchmark. */
+    of_display_chain_t *chain = &display.chains[0];
+
+    /* The modules share their character set and firmware version, like modules read from the same chain. */
+    uint8_t characters[48 * 4] = {0};
+    const char *character_list = " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789*$!?.,:/@#&";
+    for (uint8_t i = 0; i < 48; i++) {
+        characters[4 * i] = character_list[i];
+    }
+
+    printf("function, module_count, ns_per_call\n");
+    for (uint8_t n = 0; n < sizeof(model_benchmark_module_cnts) / sizeof(model_benchmark_module_cnts[0]); n++) {
+        uint16_t module_count = model_benchmark_module_cnts[n];
+        uint32_t call_cnt     = MAX(1, MODEL_BENCHMARK_MODULE_VISIT_CNT / module_count);
+
+        TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, module_count));
+        for (uint16_t i = 0; i < module_count; i++) {
+            module_t *module = display_module_get(&display, i);
+            TEST_ASSERT_NOT_NULL(module);
+            if (module->character_set == NULL) {
+                module->character_set    = character_set_intern(characters, 48);
+                module->firmware_version = firmware_version_intern("v1.0.0", 6);
+                module_property_hash_update(module, OF_MDL_PROP_CHARACTER_SET);
+                module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_VERSION);
+            }
+        }
+
+        /* Identical modules are the slowest case, the dirty flags of all modules are checked. The modules are in
+         * sync, so the write is not promoted and every call does the same work. */
+        display_property_indicate_synchronized(&display, OF_MDL_PROP_CHARACTER);
+        display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+        int64_t start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            display_property_promote_write_seq_to_write_all(&display);
+        }
+        model_benchmark_print("display_property_promote_write_seq_to_write_all", module_count, start_us, call_cnt);
+
+        /* Dirty identical modules can be broadcast, which is only known after visiting all modules. */
+        for (uint16_t i = 0; i < module_count; i++) {
+            module_property_indicate_desynchronized(display_module_get(&display, i), OF_MDL_PROP_CHARACTER);
+        }
+        TEST_ASSERT_EQUAL(MDL_ACTION_BROADCAST, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_CHARACTER));
+        start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_CHARACTER);
+        }
+        model_benchmark_print("of_display_prop_sync_required", module_count, start_us, call_cnt);
+
+        start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            display_property_indicate_synchronized(&display, OF_MDL_PROP_CHARACTER);
+        }
+        model_benchmark_print("display_property_indicate_synchronized", module_count, start_us, call_cnt);
+
+        /* Serialize every readable property of every module, as done for a GET of the module API. */
+        start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            cJSON *json = cJSON_CreateArray();
+            for (uint16_t m = 0; m < module_count; m++) {
+                module_t *module   = display_module_get(&display, m);
+                cJSON *module_json = cJSON_CreateObject();
+                for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+                    if (mdl_prop_list[prop_id].handler.get_alt == NULL) {
+                        continue;
+                    }
+                    cJSON *property_json = cJSON_CreateObject();
+                    TEST_ASSERT_TRUE(mdl_prop_list[prop_id].handler.get_alt(module, m, &property_json));
+                    cJSON_AddItemToObject(module_json, mdl_prop_list[prop_id].attribute.name, property_json);
+                }
+                cJSON_AddItemToArray(json, module_json);
+            }
+            cJSON_Delete(json);
+        }
+        model_benchmark_print("get_alt all properties", module_count, start_us, call_cnt);
+
+        /* Deserialize the character of every module, as done for a POST of the module API. */
+        cJSON *character_json = cJSON_CreateString("Z");
+        start_us              = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            for (uint16_t m = 0; m < module_count; m++) {
+                TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER].handler.set_alt(display_module_get(&display, m),
+                                                                                      m, character_json));
+            }
+        }
+        model_benchmark_print("set_alt character", module_count, start_us, call_cnt);
+        cJSON_Delete(character_json);
+
+        /* Convert a message for the whole display into character indices. */
+        char *text       = malloc(module_count + 1);
+        uint8_t *indices = malloc(module_count);
+        TEST_ASSERT_NOT_NULL(text);
+        TEST_ASSERT_NOT_NULL(indices);
+        for (uint16_t m = 0; m < module_count; m++) {
+            text[m] = character_list[m % 48];
+        }
+        text[module_count] = '\0';
+        uint16_t index_cnt = 0;
+        start_us           = esp_timer_get_time();
+        for (uint32_t i = 0; i < call_cnt; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, display_text_character_indices_get(&display, text, indices, &index_cnt));
+        }
+        model_benchmark_print("display_text_character_indices_get", module_count, start_us, call_cnt);
+        TEST_ASSERT_EQUAL(module_count, index_cnt);
+        free(text);
+        free(indices);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+static void blob_benchmark_print(const char *function, uint16_t module_count,
+                                 const module_property_blob_stats_t *start)
+{
+    module_property_blob_stats_t stats;
+    module_property_blob_stats_get(&stats);
+    printf("%s, %d, %" PRIu32 ", %" PRIu32 ", %" PRIu32 "\n", function, module_count, stats.alloc_cnt - start->alloc_cnt,
+           stats.free_cnt - start->free_cnt, stats.shared_cnt - start->shared_cnt);
+}
+
+TEST_CASE("Benchmark property blob allocations vs module count", "[display][benchmark][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+    of_property_handlers_init();
+    of_display_chain_t *chain = &display.chains[0];
+
+    /* A firmware image of 20 kB. */
+    const uint16_t page_cnt = 20 * 1024 / OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    uint8_t page[OF_FIRMWARE_UPDATE_PAGE_SIZE];
+
+    /* The character set and firmware version as read from a module. */
+    uint8_t character_set_bin[48 * 4] = {0};
+    for (uint8_t i = 0; i < 48; i++) {
+        character_set_bin[4 * i] = 'A' + i;
+    }
+    uint8_t firmware_version_bin[] = {'v', '1', '.', '0', '.', '0', 0x78, 0x56, 0x34, 0x12};
+
+    printf("function, module_count, alloc_cnt, free_cnt, shared_cnt\n");
+    for (uint8_t n = 0; n < sizeof(model_benchmark_module_cnts) / sizeof(model_benchmark_module_cnts[0]); n++) {
+        uint16_t module_count = model_benchmark_module_cnts[n];
+        TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, module_count));
+
+        /* Every page of the firmware is set on all modules before it is written. */
+        module_property_blob_stats_t start;
+        module_property_blob_stats_get(&start);
+        for (uint16_t p = 0; p < page_cnt; p++) {
+            memset(page, p, sizeof(page));
+            for (uint16_t i = 0; i < module_count; i++) {
+                TEST_ASSERT_EQUAL(ESP_OK, of_module_firmware_update_property_set(display_module_get(&display, i), p,
+                                                                                 page));
+            }
+        }
+        blob_benchmark_print("of_module_firmware_update_property_set", module_count, &start);
+
+        /* Every module returns the same character set and firmware version when read. */
+        module_property_blob_stats_get(&start);
+        for (uint16_t i = 0; i < module_count; i++) {
+            size_t size = sizeof(character_set_bin);
+            TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER_SET].handler.set(chain, i, character_set_bin, &size));
+        }
+        blob_benchmark_print("character_set_from_bin", module_count, &start);
+
+        module_property_blob_stats_get(&start);
+        for (uint16_t i = 0; i < module_count; i++) {
+            size_t size = sizeof(firmware_version_bin);
+            TEST_ASSERT_TRUE(
+                mdl_prop_list[OF_MDL_PROP_FIRMWARE_VERSION].handler.set(chain, i, firmware_version_bin, &size));
+        }
+        blob_benchmark_print("firmware_version_from_bin", module_count, &start);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+TEST_CASE("Content hashes tell if all modules are identical", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+    of_property_handlers_init();
+
+    of_display_chain_t *chain = &display.chains[0];
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 100));
+
+    /* New modules are identical, except for properties without a value. */
+    TEST_ASSERT_TRUE(display_property_is_uniform(&display, OF_MDL_PROP_CHARACTER));
+    TEST_ASSERT_FALSE(display_property_is_uniform(&display, OF_MDL_PROP_CHARACTER_SET));
+    TEST_ASSERT_EQUAL(1, chain->prop_hashes[OF_MDL_PROP_CHARACTER].distinct_cnt);
+
+    /* Every setter updates the hash of the module and the count of distinct hashes. */
+    uint8_t buf[1];
+    size_t size = sizeof(buf);
+    for (uint16_t i = 0; i < 100; i++) {
+        buf[0] = i % 10;
+        TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER].handler.set(chain, i, buf, &size));
+    }
+    TEST_ASSERT_FALSE(display_property_is_uniform(&display, OF_MDL_PROP_CHARACTER));
+    TEST_ASSERT_EQUAL(10, chain->prop_hashes[OF_MDL_PROP_CHARACTER].distinct_cnt);
+    TEST_ASSERT_EQUAL(module_property_hash_get(display_module_get(&display, 0), OF_MDL_PROP_CHARACTER),
+                      module_property_hash_get(display_module_get(&display, 10), OF_MDL_PROP_CHARACTER));
+
+    buf[0] = 3;
+    for (uint16_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER].handler.set(chain, i, buf, &size));
+        module_property_indicate_desynchronized(display_module_get(&display, i), OF_MDL_PROP_CHARACTER);
+    }
+    TEST_ASSERT_TRUE(display_property_is_uniform(&display, OF_MDL_PROP_CHARACTER));
+    TEST_ASSERT_EQUAL(1, chain->prop_hashes[OF_MDL_PROP_CHARACTER].distinct_cnt);
+
+    /* Identical dirty modules are broadcast, a single different module prevents it. */
+    display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+    TEST_ASSERT_EQUAL(MDL_ACTION_BROADCAST, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_CHARACTER));
+    buf[0] = 4;
+    TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_CHARACTER].handler.set(chain, 50, buf, &size));
+    TEST_ASSERT_EQUAL(MDL_ACTION_WRITE, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_CHARACTER));
+
+    /* Removed modules are no longer counted. */
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 50));
+    TEST_ASSERT_TRUE(display_property_is_uniform(&display, OF_MDL_PROP_CHARACTER));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+    TEST_ASSERT_NULL(chain->prop_hashes[OF_MDL_PROP_CHARACTER].entries);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_CASE("The most common value is broadcast and the other modules are patched", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+    of_property_handlers_init();
+
+    of_display_chain_t *chain = &display.chains[0];
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 100));
+
+    /* All modules are white on black, except for two modules which are black on white. */
+    uint8_t common[6] = {0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00};
+    uint8_t other[6]  = {0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF};
+    uint8_t buf[6];
+    size_t size = sizeof(buf);
+    for (uint16_t i = 0; i < 100; i++) {
+        uint8_t *color = (i == 10 || i == 20) ? other : common;
+        TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.set(chain, i, color, &size));
+        module_property_indicate_desynchronized(display_module_get(&display, i), OF_MDL_PROP_COLOR);
+    }
+    display_property_indicate_desynchronized(&display, OF_MDL_PROP_COLOR, PROPERTY_SYNC_METHOD_WRITE);
+
+    /* Every node is served the most common value during the broadcast. */
+    TEST_ASSERT_EQUAL(MDL_ACTION_BROADCAST, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_COLOR));
+    TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.get(chain, 10, buf, &size));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(common, buf, sizeof(buf));
+
+    /* A module which changes during the broadcast does not change the value which is sent. */
+    TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.set(chain, 0, other, &size));
+    TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.get(chain, 0, buf, &size));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(common, buf, sizeof(buf));
+
+    /* Only the modules with another value than the one which was sent are written after the broadcast. */
+    chain->mdl_master.model_sync_done(chain, OF_MDL_PROP_COLOR);
+    TEST_ASSERT_TRUE(module_property_is_desynchronized(display_module_get(&display, 0), OF_MDL_PROP_COLOR));
+    TEST_ASSERT_FALSE(module_property_is_desynchronized(display_module_get(&display, 1), OF_MDL_PROP_COLOR));
+    TEST_ASSERT_TRUE(module_property_is_desynchronized(display_module_get(&display, 10), OF_MDL_PROP_COLOR));
+    TEST_ASSERT_EQUAL(MDL_ACTION_WRITE, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_COLOR));
+    TEST_ASSERT_EQUAL(21, chain->mdl_master.model_write_node_cnt(chain, OF_MDL_PROP_COLOR));
+    TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.get(chain, 10, buf, &size));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(other, buf, sizeof(buf));
+
+    chain->mdl_master.model_sync_done(chain, OF_MDL_PROP_COLOR);
+    TEST_ASSERT_EQUAL(-1, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_COLOR));
+
+    /* A sequential write is cheaper when no value is shared by enough modules. */
+    for (uint16_t i = 0; i < 100; i++) {
+        common[0] = i;
+        TEST_ASSERT_TRUE(mdl_prop_list[OF_MDL_PROP_COLOR].handler.set(chain, i, common, &size));
+        module_property_indicate_desynchronized(display_module_get(&display, i), OF_MDL_PROP_COLOR);
+    }
+    display_property_indicate_desynchronized(&display, OF_MDL_PROP_COLOR, PROPERTY_SYNC_METHOD_WRITE);
+    TEST_ASSERT_EQUAL(MDL_ACTION_WRITE, chain->mdl_master.model_sync_required(chain, OF_MDL_PROP_COLOR));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_CASE("Module properties are kept when the chain is resized", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    of_display_chain_t *chain = &display.chains[0];
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 10));
+    for (uint16_t i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, of_module_character_index_set(display_module_get(&display, i), i));
+    }
+    module_property_indicate_desynchronized(display_module_get(&display, 3), OF_MDL_PROP_CHARACTER);
+
+    /* The modules and their store are moved by a resize, their properties are not. */
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 1000));
+    TEST_ASSERT_EQUAL(1000, chain->store.size);
+    for (uint16_t i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(i, module_character_index_get(display_module_get(&display, i)));
+    }
+    TEST_ASSERT_EQUAL(0, module_character_index_get(display_module_get(&display, 999)));
+    TEST_ASSERT_TRUE(module_property_is_desynchronized(display_module_get(&display, 3), OF_MDL_PROP_CHARACTER));
+    TEST_ASSERT_FALSE(module_property_is_desynchronized(display_module_get(&display, 999), OF_MDL_PROP_CHARACTER));
+
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 5));
+    TEST_ASSERT_EQUAL(5, chain->store.size);
+    TEST_ASSERT_EQUAL(4, module_character_index_get(display_module_get(&display, 4)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+    TEST_ASSERT_NULL(chain->store.character_index);
+}
+
+TEST_CASE("Modules with the same property value share a single blob", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+    of_property_handlers_init();
+
+    of_display_chain_t *chain = &display.chains[0];
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 10));
+
+    module_property_blob_stats_t start, stats;
+    module_property_blob_stats_get(&start);
+
+    uint8_t page[OF_FIRMWARE_UPDATE_PAGE_SIZE] = {1, 2, 3};
+    for (uint16_t i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, of_module_firmware_update_property_set(display_module_get(&display, i), 7, page));
+    }
+    module_property_blob_stats_get(&stats);
+    TEST_ASSERT_EQUAL(1, stats.alloc_cnt - start.alloc_cnt);
+    TEST_ASSERT_EQUAL(9, stats.shared_cnt - start.shared_cnt);
+    TEST_ASSERT_EQUAL_PTR(display_module_get(&display, 0)->firmware_update,
+                          display_module_get(&display, 9)->firmware_update);
+    TEST_ASSERT_EQUAL(10, display_module_get(&display, 0)->firmware_update->reff_cnt);
+
+    /* A different page index or a compressed page is a different blob. */
+    TEST_ASSERT_EQUAL(ESP_OK, of_module_firmware_update_property_set(display_module_get(&display, 0), 8, page));
+    TEST_ASSERT_EQUAL(ESP_OK, of_module_firmware_lz_page_property_set(display_module_get(&display, 1), 7, page, 3));
+    TEST_ASSERT_NOT_EQUAL(display_module_get(&display, 0)->firmware_update,
+                          display_module_get(&display, 2)->firmware_update);
+    TEST_ASSERT_NOT_EQUAL(display_module_get(&display, 1)->firmware_update,
+                          display_module_get(&display, 2)->firmware_update);
+    TEST_ASSERT_EQUAL(8, display_module_get(&display, 2)->firmware_update->reff_cnt);
+    TEST_ASSERT_EQUAL(3, display_module_get(&display, 1)->firmware_update->compressed_size);
+
+    /* The blobs are freed once the last module releases them. */
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 0));
+    module_property_blob_stats_get(&stats);
+    TEST_ASSERT_EQUAL(stats.alloc_cnt - start.alloc_cnt, stats.free_cnt - start.free_cnt);
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
+
+TEST_CASE("Text is converted into the character index of every module", "[display][qemu][target]")
+{
+    of_display_t display;
+    TEST_ASSERT_EQUAL(ESP_OK, of_display_init(&display));
+
+    of_display_chain_t *chain = &display.chains[0];
+    TEST_ASSERT_TRUE(chain->mdl_master.node_cnt_update(chain, 6));
+
+    const uint8_t characters[] = {' ', 0, 0, 0, 'A', 0, 0, 0, 'B', 0, 0, 0, 0xE2, 0x82, 0xAC, 0};
+    for (uint16_t i = 0; i < 6; i++) {
+        display_module_get(&display, i)->character_set = character_set_intern(characters, 4);
+    }
+    TEST_ASSERT_NOT_NULL(display_module_get(&display, 0)->character_set->lookup);
+
+    /* Multi byte characters take a single module. */
+    uint8_t indices[6] = {0};
+    uint16_t index_cnt = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, display_text_character_indices_get(&display, "B€A", indices, &index_cnt));
+    TEST_ASSERT_EQUAL(3, index_cnt);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(((uint8_t[]){2, 3, 1}), indices, 3);
+
+    /* Characters beyond the last module are ignored. */
+    TEST_ASSERT_EQUAL(ESP_OK, display_text_character_indices_get(&display, "AAAAAAAB", indices, &index_cnt));
+    TEST_ASSERT_EQUAL(6, index_cnt);
+
+    /* The conversion stops at the first unknown character. */
+    TEST_ASSERT_EQUAL(ESP_FAIL, display_text_character_indices_get(&display, "AB?", indices, &index_cnt));
+    TEST_ASSERT_EQUAL(2, index_cnt);
+
+    TEST_ASSERT_EQUAL(ESP_OK, display_destroy(&display));
+}
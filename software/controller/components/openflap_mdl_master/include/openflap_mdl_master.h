@@ -8,6 +8,14 @@
  * check with the model which properties need to be synchronized. The task will then read or write the properties
  * from/to the nodes on the chain comm bus. Once all properties are synchronized, the task will signal the model that
  * the synchronization is complete.
+ *
+ * Every chain port of the controller is driven by its own context, with its own UART and task, so the ports are
+ * synchronized in parallel. The model is responsible for merging the nodes of all ports into a single display.
+ *
+ * Before a synchronization pass, the task negotiates the highest baud rate supported by every node on the chain. When
+ * the chain fails repeatedly, all nodes are reverted to #OF_BAUD_RATE_DEFAULT and a lower baud rate is negotiated.
+ * Nodes that were added or rebooted start at #OF_BAUD_RATE_DEFAULT, so the chain is reverted and negotiated again after
+ * the node count changes or a command is written, without lowering the baud rate.
  */
 
 #pragma once
@@ -19,8 +27,16 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <sys/queue.h>
+
+/** Default time to wait for more synchronization requests before a synchronization pass is started. */
+#define OF_MDL_MASTER_SYNC_WINDOW_MS_DEFAULT (10)
+/** Default maximum time a synchronization pass can be delayed while waiting for more synchronization requests. */
+#define OF_MDL_MASTER_SYNC_LATENCY_MAX_MS_DEFAULT (50)
+
 //----------------------------------------------------------------------------------------------------------------------
 
 /**
@@ -41,6 +57,9 @@ typedef mdl_action_t (*of_mdl_master_model_sync_required_cb)(void *model_userdat
 /**
  * \brief Indicate to the model that synchronization of a property has been completed.
  *
+ * A broadcast may leave some nodes with another value than the one that was broadcast. The model then still requires a
+ * sequential write of the property, which the master makes right after the broadcast.
+ *
  * \param[in] model_userdata Pointer to model user data.
  * \param[in] property_id The property that has been synchronized.
  */
@@ -48,6 +67,42 @@ typedef void (*of_mdl_master_model_sync_done_cb)(void *model_userdata, mdl_prop_
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Get the number of nodes, counted from the start of the chain, that must be addressed by a sequential write.
+ *
+ * Nodes after the last node that must be written do not need to receive a packet, this allows the master to only
+ * transmit the delta of the model.
+ *
+ * \param[in] model_userdata Pointer to model user data.
+ * \param[in] property_id The property that will be written.
+ *
+ * \return The index of the last node that must be written plus one, or 0 when no node must be written.
+ */
+typedef uint16_t (*of_mdl_master_model_write_node_cnt_cb)(void *model_userdata, mdl_prop_id_t property_id);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the highest baud rate that is supported by all nodes, as read through the baud rate property.
+ *
+ * \param[in] model_userdata Pointer to model user data.
+ *
+ * \return The highest common baud rate, or 0 if it is unknown.
+ */
+typedef uint32_t (*of_mdl_master_model_baud_rate_get_cb)(void *model_userdata);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Set the baud rate that will be written to all nodes through the baud rate property.
+ *
+ * \param[in] model_userdata Pointer to model user data.
+ * \param[in] baud_rate The baud rate to write.
+ */
+typedef void (*of_mdl_master_model_baud_rate_set_cb)(void *model_userdata, uint32_t baud_rate);
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * \brief Chain communication master callback configuration structure.
  */
@@ -62,16 +117,104 @@ typedef struct {
     of_mdl_master_model_sync_required_cb model_sync_required;
     /**Callback to indicate that synchronization is done. */
     of_mdl_master_model_sync_done_cb model_sync_done;
+    /**Optional callback to limit sequential writes to the nodes that must be written. */
+    of_mdl_master_model_write_node_cnt_cb model_write_node_cnt;
+    /**Optional callback to get the highest baud rate supported by all nodes. Required for baud rate negotiation. */
+    of_mdl_master_model_baud_rate_get_cb model_baud_rate_get;
+    /**Optional callback to set the baud rate that will be written. Required for baud rate negotiation. */
+    of_mdl_master_model_baud_rate_set_cb model_baud_rate_set;
 } of_mdl_master_cb_cfg_t;
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Priority classes of chain transactions, from highest to lowest priority.
+ */
+typedef enum {
+    OF_MDL_MASTER_PRIO_INTERACTIVE,     /**< User visible writes, e.g. characters and commands. */
+    OF_MDL_MASTER_PRIO_CONFIG,          /**< Configuration writes. */
+    OF_MDL_MASTER_PRIO_BACKGROUND_READ, /**< Reads which refresh the model. */
+    OF_MDL_MASTER_PRIO_BULK,            /**< Bulk transfers, e.g. firmware pages. */
+    OF_MDL_MASTER_PRIO_CNT,             /**< Number of priority classes. */
+} of_mdl_master_prio_t;
+
+/**
+ * \brief A single chain transaction planned by the master task.
+ */
+typedef struct {
+    mdl_prop_id_t prop_id;     /**< The property to synchronize. */
+    mdl_action_t action;       /**< The action required to synchronize the property. */
+    uint16_t node_cnt;         /**< The number of nodes addressed by a sequential write. */
+    of_mdl_master_prio_t prio; /**< The priority class of the transaction. */
+} of_mdl_master_sync_plan_entry_t;
+
+/**
+ * \brief All chain transactions required to synchronize the model, planned before the first frame is sent.
+ */
+typedef struct {
+    of_mdl_master_sync_plan_entry_t entries[OF_MDL_PROP_CNT]; /**< Planned transactions, in transmission order. */
+    uint8_t entry_cnt;                                        /**< Number of planned transactions. */
+} of_mdl_master_sync_plan_t;
+
+/**
+ * \brief Statistics of a single synchronization pass.
+ */
+typedef struct {
+    uint8_t prop_cnt;     /**< Number of properties that were planned for synchronization. */
+    uint16_t node_cnt;    /**< Number of nodes that were addressed by sequential writes. */
+    uint16_t frame_cnt;   /**< Number of chain transactions (including retries) that were sent. */
+    uint32_t tx_byte_cnt; /**< Number of bytes transmitted on the chain. */
+    uint32_t rx_byte_cnt; /**< Number of bytes received from the chain. */
+    /** Number of RX overflows, framing and parity errors reported by the UART driver. */
+    uint32_t rx_error_cnt;
+    /** Time between the start and the end of the synchronization pass, on the virtual clock of a simulated chain. */
+    uint32_t duration_ms;
+    uint32_t baud_rate;   /**< Baud rate of the chain at the end of the synchronization pass. */
+    uint16_t request_cnt; /**< Number of synchronization requests that were merged into the synchronization pass. */
+    uint32_t window_ms;   /**< Time the synchronization pass was delayed to merge synchronization requests. */
+    /** Properties which could not be synchronized and are left for the next synchronization pass. */
+    uint64_t dirty_prop_mask;
+    /** Number of nodes the next synchronization pass has to address to synchronize the dirty properties. */
+    uint16_t dirty_node_cnt;
+    /** Longest time between a synchronization request and the start of its transaction, per priority class. */
+    uint32_t queue_delay_ms[OF_MDL_MASTER_PRIO_CNT];
+    /** Number of times lower priority transactions were preempted by new requests. */
+    uint8_t preempt_cnt;
+} of_mdl_master_sync_stats_t;
+
+/**
+ * \brief A caller waiting in #of_mdl_master_synchronize for a synchronization pass to complete.
+ */
+typedef struct of_mdl_master_sync_waiter_tag {
+    uint32_t pass;                 /**< The synchronization pass the caller is waiting for. */
+    esp_err_t result;              /**< The result of the synchronization pass. */
+    SemaphoreHandle_t done;        /**< Given when the synchronization pass has completed. */
+    StaticSemaphore_t done_buffer; /**< Storage for the done semaphore. */
+    bool pending;                  /**< Indicates that the waiter is still in the list of waiters. */
+    /** Next waiter in the list. */
+    SLIST_ENTRY(of_mdl_master_sync_waiter_tag) next;
+} of_mdl_master_sync_waiter_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+
 typedef struct {
     mdl_master_ctx_t mdl_master; /**< Chain communication master context. */
     void *model_userdata;        /**< Model user data. */
+    /** Callback to update the node count, used to clear the model when the chain port is disconnected. */
+    mdl_master_node_cnt_update_cb_t node_cnt_update;
 
     TaskHandle_t task;               /**< Task handle. */
     EventGroupHandle_t event_handle; /**< Event group handle. */
+    SemaphoreHandle_t sync_lock;     /**< Protects the synchronization pass counters and the list of waiters. */
+    uint32_t sync_pass_started;      /**< Number of the last synchronization pass that was started. */
+    bool sync_busy;                  /**< Indicates that a synchronization pass is pending or running. */
+    uint16_t sync_request_cnt;       /**< Number of synchronization requests for the next synchronization pass. */
+    TickType_t sync_request_ticks;   /**< Time of the first synchronization request for the next pass. */
+    TickType_t sync_pass_ticks;      /**< Time of the first synchronization request for the current pass. */
+    uint32_t sync_window_ms;         /**< Time to wait for more synchronization requests before starting a pass. */
+    uint32_t sync_latency_max_ms;    /**< Maximum time a pass can be delayed by waiting for more requests. */
+    /** Callers waiting for a synchronization pass. */
+    SLIST_HEAD(, of_mdl_master_sync_waiter_tag) sync_waiters;
 
     of_mdl_master_uart_ctx_t uart_ctx; /**< UART context. */
 
@@ -80,6 +223,17 @@ typedef struct {
     /** Callback to check if the model requires synchronization. */
     of_mdl_master_model_sync_required_cb model_sync_required;
     of_mdl_master_model_sync_done_cb model_sync_done; /**< Callback to indicate that synchronization is done. */
+    of_mdl_master_model_write_node_cnt_cb model_write_node_cnt; /**< Callback to get the sequential write size. */
+    of_mdl_master_model_baud_rate_get_cb model_baud_rate_get;   /**< Callback to get the highest common baud rate. */
+    of_mdl_master_model_baud_rate_set_cb model_baud_rate_set;   /**< Callback to set the baud rate to write. */
+
+    bool baud_rate_negotiate;    /**< Indicates that the baud rate must be negotiated before the next pass. */
+    uint32_t baud_rate_limit;    /**< Highest baud rate that may be negotiated. Lowered when a baud rate fails. */
+    uint8_t baud_rate_error_cnt; /**< Number of consecutive failed synchronization passes. */
+    uint16_t baud_rate_node_cnt; /**< Number of nodes on the chain when the baud rate was last negotiated. */
+
+    of_mdl_master_sync_plan_t sync_plan;   /**< The plan of the current synchronization pass. */
+    of_mdl_master_sync_stats_t sync_stats; /**< Statistics of the last completed synchronization pass. */
 } of_mdl_master_ctx_t;
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -88,16 +242,17 @@ typedef struct {
  * \brief Initialize the chain communication.
  *
  * \param[in] ctx The chain communication context.
+ * \param[in] chain The chain port driven by the context.
  * \param[in] model_userdata The model user data. Used as userdata for the property handlers.
  * \param[in] of_master_cb_cfg The chain communication master callback configuration.
- * \param[in] node_cnt_ref A pointer to where the current node count is stored.
+ * \param[in] node_cnt_ref A pointer to where the current node count of the chain port is stored.
  *
  * \retval ESP_OK The chain communication was successfully initialized.
- * \retval ESP_ERR_INVALID_ARG The context or model user data is NULL.
+ * \retval ESP_ERR_INVALID_ARG The context or model user data is NULL, or the chain port is invalid.
  * \retval ESP_FAIL The chain communication failed to initialize.
  */
-esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, void *model_userdata, of_mdl_master_cb_cfg_t *of_master_cb_cfg,
-                             const uint16_t *node_cnt_ref);
+esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, of_mdl_master_chain_t chain, void *model_userdata,
+                             of_mdl_master_cb_cfg_t *of_master_cb_cfg, const uint16_t *node_cnt_ref);
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -117,10 +272,91 @@ esp_err_t chain_comm_destroy(of_mdl_master_ctx_t *ctx);
 /**
  * \brief Signal the chain communication task that the model and actual model require synchronization.
  *
+ * Concurrent callers are coalesced: every caller joins the first synchronization pass that has not started yet, and is
+ * released when that pass completes. A pass that is already running may have planned its transactions before the
+ * caller updated the model, so it is never joined.
+ *
  * \param[in] ctx The chain communication context.
  * \param[in] timeout_ms The timeout in milliseconds to wait for synchronization. (0 for no wait)
  *
  * \retval ESP_OK The model is synchronized.
+ * \retval ESP_FAIL Some properties could not be synchronized. The other properties are synchronized, see
+ *                  #of_mdl_master_sync_stats_get for the properties that are still dirty.
  * \retval ESP_ERR_TIMEOUT The model could not be synchronized within the timeout.
  */
-esp_err_t of_mdl_master_synchronize(of_mdl_master_ctx_t *ctx, uint32_t timeout_ms);
\ No newline at end of file
+esp_err_t of_mdl_master_synchronize(of_mdl_master_ctx_t *ctx, uint32_t timeout_ms);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Signal the chain communication task that synchronization is required, without waiting for it.
+ *
+ * This is the first half of #of_mdl_master_synchronize. It allows a caller to join the passes of several contexts
+ * before waiting for any of them, so the chains are synchronized in parallel.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[out] waiter The waiter to pass to #of_mdl_master_sync_wait, NULL when the caller does not wait.
+ *
+ * \retval ESP_OK The synchronization pass was joined.
+ * \retval ESP_ERR_INVALID_ARG The context is NULL.
+ */
+esp_err_t of_mdl_master_sync_join(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_waiter_t *waiter);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Wait for the synchronization pass joined by #of_mdl_master_sync_join to complete.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[inout] waiter The waiter filled in by #of_mdl_master_sync_join.
+ * \param[in] timeout_ms The timeout in milliseconds to wait for synchronization.
+ *
+ * \retval ESP_OK The model is synchronized.
+ * \retval ESP_FAIL Some properties could not be synchronized.
+ * \retval ESP_ERR_TIMEOUT The model could not be synchronized within the timeout.
+ * \retval ESP_ERR_INVALID_ARG The context or waiter is NULL.
+ */
+esp_err_t of_mdl_master_sync_wait(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_waiter_t *waiter, uint32_t timeout_ms);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the statistics of the last completed synchronization pass.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[out] stats The statistics of the last synchronization pass.
+ *
+ * \retval ESP_OK The statistics were copied.
+ * \retval ESP_ERR_INVALID_ARG The context or stats is NULL.
+ */
+esp_err_t of_mdl_master_sync_stats_get(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Configure the coalescing window of the synchronization passes.
+ *
+ * When a synchronization is requested without waiting for it, the master task waits until no new requests have been
+ * made for \p window_ms before starting the synchronization pass. This allows the model changes of several requests to
+ * be merged into a single pass. The pass is never delayed by more than \p latency_max_ms, and is started immediately
+ * when a caller is waiting for it.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] window_ms The coalescing window in milliseconds, 0 to disable coalescing.
+ * \param[in] latency_max_ms The maximum delay of a synchronization pass in milliseconds.
+ *
+ * \retval ESP_OK The coalescing window was configured.
+ * \retval ESP_ERR_INVALID_ARG The context is NULL or the maximum delay is shorter than the window.
+ */
+esp_err_t of_mdl_master_sync_window_set(of_mdl_master_ctx_t *ctx, uint32_t window_ms, uint32_t latency_max_ms);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Check if the chain is idle.
+ *
+ * \param[in] ctx The chain communication context.
+ *
+ * \return true if no synchronization pass is running or has been requested, false otherwise.
+ */
+bool of_mdl_master_is_idle(of_mdl_master_ctx_t *ctx);
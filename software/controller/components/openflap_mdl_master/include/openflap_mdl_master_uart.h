@@ -1,23 +1,77 @@
 #pragma once
 
 #include "madelink_master.h"
+#include "openflap_properties.h"
 
-#include "driver/uart.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 
-#define UART_BUF_SIZE (1024)
-#define UART_NUM      UART_NUM_1
+#if CONFIG_IDF_TARGET_LINUX
+#include <freertos/FreeRTOS.h>
+#include <sys/types.h>
+
+/** Environment variables with the shell commands that start the chain simulator of each chain port. */
+#define OF_MDL_SIM_COL_CMD_ENV "OF_MDL_SIM_COL_CMD"
+#define OF_MDL_SIM_ROW_CMD_ENV "OF_MDL_SIM_ROW_CMD"
+
+/* Commands to the chain simulator, see software/module/sim. The simulator only runs while the controller waits for it,
+ * it answers a read or wait with its virtual time in ns (uint64_t), the number of bytes (uint16_t) and the bytes. */
+#define OF_MDL_SIM_CMD_WRITE ('W') /**< Followed by a uint16_t size and the bytes which enter the first node. */
+#define OF_MDL_SIM_CMD_BREAK ('B') /**< Sends a break to the first node. */
+#define OF_MDL_SIM_CMD_READ  ('R') /**< Followed by a uint16_t size and a uint32_t timeout in us, ends early. */
+#define OF_MDL_SIM_CMD_WAIT  ('D') /**< Followed by a uint16_t size and a uint32_t timeout in us, runs until timeout. */
+#else
+#include "driver/uart.h"
+
+#define UART_NUM_COL  UART_NUM_1
+#define UART_NUM_ROW  UART_NUM_2
 #define COL_START_PIN (2)
 #define TX_COL_PIN    (47)
 #define RX_COL_PIN    (48)
 #define ROW_START_PIN (6)
 #define TX_ROW_PIN    (5)
 #define RX_ROW_PIN    (4)
+#endif
+
+#define UART_BUF_SIZE (1024)
+
+/** Length of the break used to revert all nodes to #OF_BAUD_RATE_DEFAULT, in bit times. */
+#define UART_BREAK_LEN (255)
+
+/** Number of UART driver events that can be queued for the chain communication task. */
+#define UART_EVENT_QUEUE_LEN (16)
+/** Number of bytes in the RX FIFO which wakes the chain communication task. */
+#define UART_RX_FULL_THRESHOLD (16)
+/** Idle time on the RX line, in symbol times, after which the received bytes are passed on to the task. */
+#define UART_RX_TIMEOUT_SYMBOLS (2)
+
+/**
+ * @brief The chain ports of the controller, each port is driven by its own UART.
+ */
+typedef enum {
+    OF_MDL_MASTER_CHAIN_COL, /**< The column the controller is mounted on. */
+    OF_MDL_MASTER_CHAIN_ROW, /**< The columns connected through the top connectors. */
+    OF_MDL_MASTER_CHAIN_CNT, /**< Number of chain ports. */
+} of_mdl_master_chain_t;
 
 typedef struct {
+    of_mdl_master_chain_t chain; /**< The chain port driven by the UART. */
+#if CONFIG_IDF_TARGET_LINUX
+    pid_t sim_pid;               /**< Process of the chain simulator, 0 if the chain port is not simulated. */
+    int sim_tx_fd;               /**< Pipe to the stdin of the chain simulator. */
+    int sim_rx_fd;               /**< Pipe from the stdout of the chain simulator. */
+    uint64_t sim_time_ns;        /**< Virtual time of the chain simulator at its last answer. */
+#else
     uart_port_t uart_num;        /**< UART port number. */
+    QueueHandle_t event_queue;   /**< Queue of UART driver events, posted from the UART ISR. */
+#endif
+    bool connected;              /**< Indicates that the chain port is connected to modules. */
     TickType_t rx_timeout_ticks; /**< Timeout for UART read operations. */
+    uint32_t rx_error_cnt;       /**< Number of RX overflows, framing and parity errors. */
+    uint32_t tx_byte_cnt;        /**< Total number of bytes written to the chain. */
+    uint32_t rx_byte_cnt;        /**< Total number of bytes read from the chain. */
+    uint32_t baud_rate;          /**< Current baud rate of the chain. */
 } of_mdl_master_uart_ctx_t;
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -26,11 +80,13 @@ typedef struct {
  * @brief Initialize the UART for chain communication.
  *
  * @param[out] uart_ctx UART configuration context.
+ * @param[in] chain The chain port driven by the UART.
  * @param[out] uart_cb_cfg UART callback configuration to be filled.
  *
  * @return ESP_OK on success.
  */
-esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, mdl_master_uart_cb_cfg_t *uart_cb_cfg);
+esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, of_mdl_master_chain_t chain,
+                                  mdl_master_uart_cb_cfg_t *uart_cb_cfg);
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -45,10 +101,98 @@ esp_err_t of_mdl_master_uart_deinit(of_mdl_master_uart_ctx_t *uart_ctx);
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Get the state of the pins which indicate how the controller is connected to the modules.
+ *
+ * @param[out] controller_is_col_start True if the controller is mounted on top of a module.
+ * @param[out] controller_is_row_start True if the controller is connected to another top-con board.
+ */
+void of_mdl_master_uart_start_pins_get(bool *controller_is_col_start, bool *controller_is_row_start);
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * @brief Reconfigure the UART pins based on the COL_START_PIN and ROW_START_PIN states.
  *
+ * The column and row ports are independent chains. A port that is not connected while the other port is, is released
+ * and marked as disconnected.
+ *
+ * @param[inout] uart_ctx UART configuration context.
  * @param controller_is_col_start True if the controller is mounted on top of a module.
  * @param controller_is_row_start True if the controller is connected to another top-con board.
  */
-esp_err_t of_mdl_master_uart_reconfigure(bool controller_is_col_start, bool controller_is_row_start);
\ No newline at end of file
+esp_err_t of_mdl_master_uart_reconfigure(of_mdl_master_uart_ctx_t *uart_ctx, bool controller_is_col_start,
+                                         bool controller_is_row_start);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Change the baud rate of the chain communication UART.
+ *
+ * Pending transmissions are completed at the old baud rate before the new baud rate is applied.
+ *
+ * @param[inout] uart_ctx UART configuration context.
+ * @param[in] baud_rate The new baud rate.
+ *
+ * @return ESP_OK on success.
+ */
+esp_err_t of_mdl_master_uart_baud_rate_set(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t baud_rate);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Transmit a break on the chain communication UART.
+ *
+ * The break is received as a framing error by every node, which causes the nodes to revert to #OF_BAUD_RATE_DEFAULT.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ *
+ * @return ESP_OK on success.
+ */
+esp_err_t of_mdl_master_uart_break_send(of_mdl_master_uart_ctx_t *uart_ctx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Check for received data while no data is expected, the data is discarded.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ *
+ * @return true if data was received.
+ */
+bool of_mdl_master_uart_rx_unexpected(of_mdl_master_uart_ctx_t *uart_ctx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Discard all received data and pending receive errors.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ */
+void of_mdl_master_uart_rx_flush(of_mdl_master_uart_ctx_t *uart_ctx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Get the time on the clock of the chain.
+ *
+ * On the linux target this is the virtual time of the chain simulator, so the duration of a synchronization does not
+ * depend on the load of the host.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ *
+ * @return The time in microseconds.
+ */
+int64_t of_mdl_master_uart_time_us_get(of_mdl_master_uart_ctx_t *uart_ctx);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Wait while the chain keeps running, e.g. to let the nodes time out or apply a new baud rate.
+ *
+ * On the linux target the chain simulator runs for the delay in virtual time.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ * @param[in] delay_ms The delay in milliseconds.
+ */
+void of_mdl_master_uart_delay(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t delay_ms);
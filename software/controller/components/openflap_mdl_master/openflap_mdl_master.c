@@ -1,10 +1,11 @@
 #include "openflap_mdl_master.h"
 
-#include "driver/gpio.h"
 #include "esp_check.h"
 #include "esp_log.h"
 
+#include <inttypes.h>
 #include <string.h>
+#include <sys/param.h>
 
 //======================================================================================================================
 //                                                   MACROS a DEFINES
@@ -17,21 +18,56 @@
 
 /** Indicates that the model and actual modules are no longer in sync. */
 #define OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED (1u << 0)
-/** Indicates that the model and actual modules are back in sync. */
-#define OF_MDL_MASTER_MODEL_EVENT_SYNCHRONIZED (1u << 1)
+
+/** Number of attempts for a single chain transaction. */
+#define OF_MDL_MASTER_ATTEMPT_MAX 3
+/** Backoff before the first retry of a chain transaction, doubled for every following retry. */
+#define OF_MDL_MASTER_RETRY_BACKOFF_MS 5
+/** Number of consecutive failed transactions after which the chain is considered broken and the pass is aborted. */
+#define OF_MDL_MASTER_FAIL_LIMIT 3
+
+/** Number of consecutive failed synchronization passes before the chain falls back to #OF_BAUD_RATE_DEFAULT. */
+#define OF_MDL_MASTER_BAUD_RATE_ERROR_LIMIT 3
+/** Time for the nodes to apply a new baud rate after the baud rate property was written. */
+#define OF_MDL_MASTER_BAUD_RATE_SETTLE_MS 10
+
+/** Baud rates that can be negotiated, from fastest to slowest. */
+static const uint32_t of_mdl_master_baud_rates[] = {1000000, 460800, 230400, OF_BAUD_RATE_DEFAULT};
+#define OF_MDL_MASTER_BAUD_RATE_CNT (sizeof(of_mdl_master_baud_rates) / sizeof(of_mdl_master_baud_rates[0]))
 
 //======================================================================================================================
 //                                                   FUNCTION PROTOTYPES
 //======================================================================================================================
 
 static void of_mdl_master_task(void *arg);
+static esp_err_t of_mdl_master_sync_pass(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats);
+static void of_mdl_master_sync_disconnected(of_mdl_master_ctx_t *ctx);
+static void of_mdl_master_sync_waiters_release(of_mdl_master_ctx_t *ctx, uint32_t pass, esp_err_t result);
+static uint32_t of_mdl_master_sync_window_wait(of_mdl_master_ctx_t *ctx);
+static uint8_t of_mdl_master_sync_plan(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_plan_t *plan,
+                                       of_mdl_master_prio_t prio_limit, uint64_t exclude_mask);
+static void of_mdl_master_sync_plan_execute(of_mdl_master_ctx_t *ctx, const of_mdl_master_sync_plan_t *plan,
+                                            TickType_t request_ticks, bool preemptible,
+                                            of_mdl_master_sync_stats_t *stats, uint8_t *fail_cnt);
+static void of_mdl_master_sync_preempt(of_mdl_master_ctx_t *ctx, of_mdl_master_prio_t prio,
+                                       of_mdl_master_sync_stats_t *stats, uint8_t *fail_cnt);
+static of_mdl_master_prio_t of_mdl_master_prio_get(mdl_prop_id_t prop_id, mdl_action_t action);
+static bool of_mdl_master_sync_patch_plan(of_mdl_master_ctx_t *ctx, const of_mdl_master_sync_plan_entry_t *entry,
+                                          of_mdl_master_sync_plan_entry_t *patch);
+static mdl_master_err_t of_mdl_master_sync_plan_entry_execute(of_mdl_master_ctx_t *ctx,
+                                                              const of_mdl_master_sync_plan_entry_t *entry,
+                                                              of_mdl_master_sync_stats_t *stats);
+static void of_mdl_master_baud_rate_negotiate(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats);
+static void of_mdl_master_baud_rate_fallback(of_mdl_master_ctx_t *ctx);
+static void of_mdl_master_baud_rate_reset(of_mdl_master_ctx_t *ctx);
+static void of_mdl_master_baud_rate_revert(of_mdl_master_ctx_t *ctx);
 
 //======================================================================================================================
 //                                                   PUBLIC FUNCTIONS
 //======================================================================================================================
 
-esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, void *model_userdata, of_mdl_master_cb_cfg_t *of_master_cb_cfg,
-                             const uint16_t *node_cnt_ref)
+esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, of_mdl_master_chain_t chain, void *model_userdata,
+                             of_mdl_master_cb_cfg_t *of_master_cb_cfg, const uint16_t *node_cnt_ref)
 {
     ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
     ESP_RETURN_ON_FALSE(model_userdata != NULL, ESP_ERR_INVALID_ARG, TAG, "Model user data is NULL");
@@ -44,9 +80,18 @@ esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, void *model_userdata, of_
                         "node_error_set callback is NULL");
     ESP_RETURN_ON_FALSE(node_cnt_ref != NULL, ESP_ERR_INVALID_ARG, TAG, "Node count reference is NULL");
 
-    ctx->model_userdata      = model_userdata;
-    ctx->model_sync_required = of_master_cb_cfg->model_sync_required;
-    ctx->model_sync_done     = of_master_cb_cfg->model_sync_done;
+    ctx->model_userdata       = model_userdata;
+    ctx->node_cnt_update      = of_master_cb_cfg->node_cnt_update;
+    ctx->model_sync_required  = of_master_cb_cfg->model_sync_required;
+    ctx->model_sync_done      = of_master_cb_cfg->model_sync_done;
+    ctx->model_write_node_cnt = of_master_cb_cfg->model_write_node_cnt;
+    ctx->model_baud_rate_get  = of_master_cb_cfg->model_baud_rate_get;
+    ctx->model_baud_rate_set  = of_master_cb_cfg->model_baud_rate_set;
+
+    ctx->baud_rate_negotiate = (ctx->model_baud_rate_get != NULL && ctx->model_baud_rate_set != NULL);
+    ctx->baud_rate_limit     = of_mdl_master_baud_rates[0];
+    ctx->baud_rate_error_cnt = 0;
+    ctx->baud_rate_node_cnt  = 0;
 
     mdl_master_cb_cfg_t master_cb_cfg = {
         .node_cnt_update                 = of_master_cb_cfg->node_cnt_update,
@@ -58,7 +103,7 @@ esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, void *model_userdata, of_
 
     /* Configure UART for chain communication. */
     mdl_master_uart_cb_cfg_t uart_cb = {0};
-    ESP_RETURN_ON_ERROR(of_mdl_master_uart_init(&ctx->uart_ctx, &uart_cb), TAG,
+    ESP_RETURN_ON_ERROR(of_mdl_master_uart_init(&ctx->uart_ctx, chain, &uart_cb), TAG,
                         "Failed to initialize UART for chain communication");
 
     /* Initialize chain communication master context. */
@@ -69,9 +114,19 @@ esp_err_t of_mdl_master_init(of_mdl_master_ctx_t *ctx, void *model_userdata, of_
     ctx->event_handle = xEventGroupCreate();
     ESP_RETURN_ON_FALSE(ctx->event_handle != NULL, ESP_FAIL, TAG, "Failed to create event group for context");
 
+    /* Create the lock for the synchronization requests. */
+    ctx->sync_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(ctx->sync_lock != NULL, ESP_FAIL, TAG, "Failed to create synchronization lock");
+    ctx->sync_pass_started   = 0;
+    ctx->sync_busy           = false;
+    ctx->sync_request_cnt    = 0;
+    ctx->sync_window_ms      = OF_MDL_MASTER_SYNC_WINDOW_MS_DEFAULT;
+    ctx->sync_latency_max_ms = OF_MDL_MASTER_SYNC_LATENCY_MAX_MS_DEFAULT;
+    SLIST_INIT(&ctx->sync_waiters);
+
     /* Start the task. */
-    ESP_RETURN_ON_FALSE(xTaskCreate(of_mdl_master_task, "of_mdl_master_task", OF_MDL_MASTER_TASK_SIZE, ctx,
-                                    OF_MDL_MASTER_TASK_PRIO, &ctx->task),
+    ESP_RETURN_ON_FALSE(xTaskCreate(of_mdl_master_task, chain == OF_MDL_MASTER_CHAIN_COL ? "of_mdl_col" : "of_mdl_row",
+                                    OF_MDL_MASTER_TASK_SIZE, ctx, OF_MDL_MASTER_TASK_PRIO, &ctx->task),
                         ESP_FAIL, TAG, "Failed to create chain comm task");
 
     return ESP_OK;
@@ -85,9 +140,11 @@ esp_err_t chain_comm_destroy(of_mdl_master_ctx_t *ctx)
 
     of_mdl_master_uart_deinit(&ctx->uart_ctx);
 
+    vTaskDelete(ctx->task);
     vEventGroupDelete(ctx->event_handle);
     ctx->event_handle = NULL;
-    vTaskDelete(ctx->task);
+    vSemaphoreDelete(ctx->sync_lock);
+    ctx->sync_lock = NULL;
 
     return ESP_OK;
 }
@@ -96,17 +153,102 @@ esp_err_t chain_comm_destroy(of_mdl_master_ctx_t *ctx)
 
 esp_err_t of_mdl_master_synchronize(of_mdl_master_ctx_t *ctx, uint32_t timeout_ms)
 {
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
+
+    if (timeout_ms == 0) {
+        return of_mdl_master_sync_join(ctx, NULL);
+    }
+
+    of_mdl_master_sync_waiter_t waiter = {0};
+    ESP_RETURN_ON_ERROR(of_mdl_master_sync_join(ctx, &waiter), TAG, "Failed to join synchronization pass");
+
+    return of_mdl_master_sync_wait(ctx, &waiter, timeout_ms);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_sync_join(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_waiter_t *waiter)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
+
+    /* Join the first synchronization pass that has not started yet. */
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    if (ctx->sync_request_cnt++ == 0) {
+        ctx->sync_request_ticks = xTaskGetTickCount();
+    }
+    if (waiter != NULL) {
+        waiter->pass    = ctx->sync_pass_started + 1;
+        waiter->result  = ESP_ERR_TIMEOUT;
+        waiter->done    = xSemaphoreCreateBinaryStatic(&waiter->done_buffer);
+        waiter->pending = true;
+        SLIST_INSERT_HEAD(&ctx->sync_waiters, waiter, next);
+    }
+    xSemaphoreGive(ctx->sync_lock);
 
-    xEventGroupClearBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_SYNCHRONIZED);
     xEventGroupSetBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED);
-    EventBits_t bits = xEventGroupWaitBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_SYNCHRONIZED, pdTRUE, pdFALSE,
-                                           pdMS_TO_TICKS(timeout_ms));
 
-    if (bits & OF_MDL_MASTER_MODEL_EVENT_SYNCHRONIZED || timeout_ms == 0) {
-        return ESP_OK;
-    } else {
-        return ESP_ERR_TIMEOUT;
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_sync_wait(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_waiter_t *waiter, uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
+    ESP_RETURN_ON_FALSE(waiter != NULL, ESP_ERR_INVALID_ARG, TAG, "Waiter is NULL");
+
+    xSemaphoreTake(waiter->done, pdMS_TO_TICKS(timeout_ms));
+
+    /* Leave the list of waiters if the synchronization pass did not complete in time. */
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    if (waiter->pending) {
+        SLIST_REMOVE(&ctx->sync_waiters, waiter, of_mdl_master_sync_waiter_tag, next);
     }
+    xSemaphoreGive(ctx->sync_lock);
+
+    vSemaphoreDelete(waiter->done);
+
+    return waiter->result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_sync_window_set(of_mdl_master_ctx_t *ctx, uint32_t window_ms, uint32_t latency_max_ms)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
+    ESP_RETURN_ON_FALSE(latency_max_ms >= window_ms, ESP_ERR_INVALID_ARG, TAG,
+                        "Maximum latency must not be shorter than the window");
+
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    ctx->sync_window_ms      = window_ms;
+    ctx->sync_latency_max_ms = latency_max_ms;
+    xSemaphoreGive(ctx->sync_lock);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_mdl_master_is_idle(of_mdl_master_ctx_t *ctx)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, false, TAG, "mdl_master context is NULL");
+
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    bool desynchronized = xEventGroupGetBits(ctx->event_handle) & OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED;
+    bool idle           = !ctx->sync_busy && !desynchronized;
+    xSemaphoreGive(ctx->sync_lock);
+
+    return idle;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_sync_stats_get(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "mdl_master context is NULL");
+    ESP_RETURN_ON_FALSE(stats != NULL, ESP_ERR_INVALID_ARG, TAG, "Stats is NULL");
+
+    *stats = ctx->sync_stats;
 
     return ESP_OK;
 }
@@ -119,74 +261,650 @@ static void of_mdl_master_task(void *arg)
 {
     of_mdl_master_ctx_t *ctx = (of_mdl_master_ctx_t *)arg;
 
-    bool controller_is_col_start_prev = !gpio_get_level(COL_START_PIN);
-    bool controller_is_row_start_prev = !gpio_get_level(ROW_START_PIN);
-    ESP_ERROR_CHECK(of_mdl_master_uart_reconfigure(controller_is_col_start_prev, controller_is_row_start_prev));
+    bool controller_is_col_start_prev, controller_is_row_start_prev;
+    of_mdl_master_uart_start_pins_get(&controller_is_col_start_prev, &controller_is_row_start_prev);
+    ESP_ERROR_CHECK(
+        of_mdl_master_uart_reconfigure(&ctx->uart_ctx, controller_is_col_start_prev, controller_is_row_start_prev));
 
     while (1) {
         /* Wait here until we receive a desynchronization event. */
         xEventGroupWaitBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED, pdTRUE, pdFALSE,
                             portMAX_DELAY);
+        xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+        ctx->sync_busy = true;
+        xSemaphoreGive(ctx->sync_lock);
+
+        /* Give bursts of requests the chance to be merged into a single pass. */
+        uint32_t window_ms = of_mdl_master_sync_window_wait(ctx);
 
-        /* Read a byte, we are not expecting data so data would indicate an error. */
-        uint8_t data = {0};
-        if (uart_read_bytes(ctx->uart_ctx.uart_num, &data, 1, 0)) {
+        /* We are not expecting data, so data would indicate an error. */
+        if (of_mdl_master_uart_rx_unexpected(&ctx->uart_ctx)) {
             ESP_LOGW(TAG, "Unexpected data received on chain-comm UART before synchronization.");
-            vTaskDelay(pdMS_TO_TICKS(MDL_NODE_TIMEOUT_MS * 1.1));
+            of_mdl_master_uart_delay(&ctx->uart_ctx, MDL_NODE_TIMEOUT_MS * 1.1);
         }
 
-        ESP_LOGI(TAG, "Chain Comm Master Synchronization Starting...");
+        ESP_LOGI(TAG, "Chain Comm Master %d Synchronization Starting...", ctx->uart_ctx.chain);
 
         /* Reconfigure IOs if needed. */
-        bool controller_is_col_start = !gpio_get_level(COL_START_PIN);
-        bool controller_is_row_start = !gpio_get_level(ROW_START_PIN);
+        bool controller_is_col_start, controller_is_row_start;
+        of_mdl_master_uart_start_pins_get(&controller_is_col_start, &controller_is_row_start);
         if (controller_is_col_start != controller_is_col_start_prev ||
             controller_is_row_start != controller_is_row_start_prev) {
             ESP_LOGI(TAG, "Reconfiguring chain-comm IOs");
-            ESP_ERROR_CHECK(of_mdl_master_uart_reconfigure(controller_is_col_start, controller_is_row_start));
+            ESP_ERROR_CHECK(
+                of_mdl_master_uart_reconfigure(&ctx->uart_ctx, controller_is_col_start, controller_is_row_start));
             controller_is_col_start_prev = controller_is_col_start;
             controller_is_row_start_prev = controller_is_row_start;
         }
 
-        /* Synchronize the model. */
-        for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
-            mdl_action_t required_action = ctx->model_sync_required(ctx->model_userdata, prop_id);
+        /* Every request made from here on joins the next synchronization pass. */
+        of_mdl_master_sync_stats_t stats = {0};
+        xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+        uint32_t pass         = ++ctx->sync_pass_started;
+        stats.request_cnt     = ctx->sync_request_cnt;
+        ctx->sync_pass_ticks  = ctx->sync_request_cnt ? ctx->sync_request_ticks : xTaskGetTickCount();
+        ctx->sync_request_cnt = 0;
+        xSemaphoreGive(ctx->sync_lock);
+        stats.window_ms = window_ms;
+
+        esp_err_t result = of_mdl_master_sync_pass(ctx, &stats);
+        ctx->sync_stats  = stats;
+
+        ESP_LOGI(TAG,
+                 "Synchronized %d properties for %d merged requests in %d frames (%d nodes written, %" PRIu32
+                 " bytes tx, %" PRIu32 " bytes rx, %" PRIu32 " ms + %" PRIu32 " ms window, %" PRIu32 " baud)",
+                 stats.prop_cnt, stats.request_cnt, stats.frame_cnt, stats.node_cnt, stats.tx_byte_cnt,
+                 stats.rx_byte_cnt, stats.duration_ms, stats.window_ms, stats.baud_rate);
+        ESP_LOGI(TAG,
+                 "Queueing delay: interactive %" PRIu32 " ms, config %" PRIu32 " ms, read %" PRIu32 " ms, bulk %" PRIu32
+                 " ms (%d preemptions)",
+                 stats.queue_delay_ms[OF_MDL_MASTER_PRIO_INTERACTIVE], stats.queue_delay_ms[OF_MDL_MASTER_PRIO_CONFIG],
+                 stats.queue_delay_ms[OF_MDL_MASTER_PRIO_BACKGROUND_READ],
+                 stats.queue_delay_ms[OF_MDL_MASTER_PRIO_BULK], stats.preempt_cnt);
+        ESP_LOGI(TAG, "Chain Comm Master %d Synchronization Completed!", ctx->uart_ctx.chain);
+
+        /* Release all callers that were waiting for this synchronization pass. */
+        of_mdl_master_sync_waiters_release(ctx, pass, result);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Execute a single synchronization pass.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[inout] stats The statistics of the synchronization pass.
+ *
+ * \retval ESP_OK All properties were synchronized.
+ * \retval ESP_FAIL One or more properties could not be synchronized.
+ */
+static esp_err_t of_mdl_master_sync_pass(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats)
+{
+    int64_t sync_start_us       = of_mdl_master_uart_time_us_get(&ctx->uart_ctx);
+    uint32_t tx_byte_cnt_start  = ctx->uart_ctx.tx_byte_cnt;
+    uint32_t rx_byte_cnt_start  = ctx->uart_ctx.rx_byte_cnt;
+    uint32_t rx_error_cnt_start = ctx->uart_ctx.rx_error_cnt;
+
+    /* A port without modules has nothing to synchronize. */
+    if (!ctx->uart_ctx.connected) {
+        of_mdl_master_sync_disconnected(ctx);
+        stats->baud_rate = ctx->uart_ctx.baud_rate;
+        return ESP_OK;
+    }
+
+    /* Nodes that were added start at the default baud rate, and the new chain may support a higher baud rate. */
+    if (*ctx->node_cnt_ref != ctx->baud_rate_node_cnt) {
+        ESP_LOGI(TAG, "Chain changed from %d to %d nodes", ctx->baud_rate_node_cnt, *ctx->node_cnt_ref);
+        ctx->baud_rate_limit = of_mdl_master_baud_rates[0];
+        of_mdl_master_baud_rate_reset(ctx);
+    }
+
+    /* Switch to the fastest baud rate supported by all nodes. */
+    if (ctx->baud_rate_negotiate) {
+        of_mdl_master_baud_rate_negotiate(ctx, stats);
+    }
+
+    /* Plan all required transactions up front, so they can be sent back-to-back. */
+    stats->prop_cnt = of_mdl_master_sync_plan(ctx, &ctx->sync_plan, OF_MDL_MASTER_PRIO_CNT, 0);
+
+    /* Synchronize the model. A failing property does not prevent the other properties from being synchronized. */
+    uint8_t fail_cnt = 0;
+    of_mdl_master_sync_plan_execute(ctx, &ctx->sync_plan, ctx->sync_pass_ticks, true, stats, &fail_cnt);
+
+    bool sync_failed = (stats->dirty_prop_mask != 0);
+    if (sync_failed) {
+        ESP_LOGW(TAG, "Properties 0x%" PRIx64 " remain dirty on %d nodes", stats->dirty_prop_mask,
+                 stats->dirty_node_cnt);
+    }
+
+    /* Revert the chain to the default baud rate when it keeps failing at a higher baud rate. */
+    if (!sync_failed) {
+        ctx->baud_rate_error_cnt = 0;
+    } else if (++ctx->baud_rate_error_cnt >= OF_MDL_MASTER_BAUD_RATE_ERROR_LIMIT &&
+               ctx->uart_ctx.baud_rate > OF_BAUD_RATE_DEFAULT) {
+        ESP_LOGW(TAG, "Chain failed %d times at %" PRIu32 " baud", ctx->baud_rate_error_cnt, ctx->uart_ctx.baud_rate);
+        of_mdl_master_baud_rate_fallback(ctx);
+    }
+
+    stats->tx_byte_cnt  = ctx->uart_ctx.tx_byte_cnt - tx_byte_cnt_start;
+    stats->rx_byte_cnt  = ctx->uart_ctx.rx_byte_cnt - rx_byte_cnt_start;
+    stats->rx_error_cnt = ctx->uart_ctx.rx_error_cnt - rx_error_cnt_start;
+    stats->duration_ms  = (of_mdl_master_uart_time_us_get(&ctx->uart_ctx) - sync_start_us) / 1000;
+    stats->baud_rate    = ctx->uart_ctx.baud_rate;
+
+    return sync_failed ? ESP_FAIL : ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Remove all nodes of a disconnected chain port from the model.
+ *
+ * \param[in] ctx The chain communication context.
+ */
+static void of_mdl_master_sync_disconnected(of_mdl_master_ctx_t *ctx)
+{
+    if (*ctx->node_cnt_ref != 0) {
+        ESP_LOGI(TAG, "Chain port %d is disconnected", ctx->uart_ctx.chain);
+        ctx->node_cnt_update(ctx->model_userdata, 0);
+    }
+
+    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+        mdl_action_t required_action = ctx->model_sync_required(ctx->model_userdata, prop_id);
+        if (required_action == MDL_ACTION_READ || required_action == MDL_ACTION_WRITE ||
+            required_action == MDL_ACTION_BROADCAST) {
+            ctx->model_sync_done(ctx->model_userdata, prop_id);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Release all callers waiting for a synchronization pass that has completed.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] pass The synchronization pass that has completed.
+ * \param[in] result The result of the synchronization pass.
+ */
+static void of_mdl_master_sync_waiters_release(of_mdl_master_ctx_t *ctx, uint32_t pass, esp_err_t result)
+{
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    of_mdl_master_sync_waiter_t *waiter = SLIST_FIRST(&ctx->sync_waiters);
+    while (waiter != NULL) {
+        of_mdl_master_sync_waiter_t *waiter_next = SLIST_NEXT(waiter, next);
+        if (waiter->pass <= pass) {
+            SLIST_REMOVE(&ctx->sync_waiters, waiter, of_mdl_master_sync_waiter_tag, next);
+            waiter->pending = false;
+            waiter->result  = result;
+            xSemaphoreGive(waiter->done);
+        }
+        waiter = waiter_next;
+    }
+    ctx->sync_busy = false;
+    xSemaphoreGive(ctx->sync_lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Wait until no new synchronization requests are made within the coalescing window.
+ *
+ * The wait ends early when the maximum latency is reached or when a caller is blocked waiting for the pass.
+ *
+ * \param[in] ctx The chain communication context.
+ *
+ * \return The time in milliseconds the synchronization pass was delayed.
+ */
+static uint32_t of_mdl_master_sync_window_wait(of_mdl_master_ctx_t *ctx)
+{
+    TickType_t start_ticks = xTaskGetTickCount();
+
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    uint32_t window_ms           = ctx->sync_window_ms;
+    TickType_t latency_max_ticks = pdMS_TO_TICKS(ctx->sync_latency_max_ms);
+    xSemaphoreGive(ctx->sync_lock);
+
+    if (window_ms == 0) {
+        return 0;
+    }
+
+    /* Short windows still wait for at least one tick. */
+    TickType_t window_ticks = MAX(pdMS_TO_TICKS(window_ms), 1);
+
+    while (1) {
+        xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+        bool caller_is_waiting = !SLIST_EMPTY(&ctx->sync_waiters);
+        xSemaphoreGive(ctx->sync_lock);
+
+        TickType_t elapsed_ticks = xTaskGetTickCount() - start_ticks;
+        if (caller_is_waiting || elapsed_ticks >= latency_max_ticks) {
+            break;
+        }
+
+        /* Restart the window each time a new request is made. */
+        TickType_t wait_ticks = MIN(window_ticks, latency_max_ticks - elapsed_ticks);
+        EventBits_t bits      = xEventGroupWaitBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED,
+                                                    pdTRUE, pdFALSE, wait_ticks);
+        if (!(bits & OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED)) {
+            break;
+        }
+    }
+
+    return pdTICKS_TO_MS(xTaskGetTickCount() - start_ticks);
+}
 
-            if (required_action == MDL_ACTION_READ) {
-                ESP_LOGI(TAG, "Model requires READ of property %s", of_mdl_prop_name_by_id(prop_id));
-                mdl_master_queue_prop_read(&ctx->mdl_master, prop_id);
-            } else if (required_action == MDL_ACTION_WRITE || required_action == MDL_ACTION_BROADCAST) {
-                bool broadcast = (required_action == MDL_ACTION_BROADCAST);
-                ESP_LOGI(TAG, "Model requires %s of property %s", broadcast ? "BROADCAST" : "WRITE",
-                         of_mdl_prop_name_by_id(prop_id));
-                mdl_master_queue_prop_write(&ctx->mdl_master, prop_id, *ctx->node_cnt_ref, broadcast);
-            } else {
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Ask the model which properties must be synchronized and store the result in a plan.
+ *
+ * The plan is ordered by priority class, properties within the same class keep their id order.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[out] plan The plan to fill in.
+ * \param[in] prio_limit Only plan transactions with a higher priority than this class.
+ * \param[in] exclude_mask Properties which must not be planned.
+ *
+ * \return The number of planned transactions.
+ */
+static uint8_t of_mdl_master_sync_plan(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_plan_t *plan,
+                                       of_mdl_master_prio_t prio_limit, uint64_t exclude_mask)
+{
+    plan->entry_cnt = 0;
+
+    for (mdl_prop_id_t prop_id = 0; prop_id < OF_MDL_PROP_CNT; prop_id++) {
+        if (exclude_mask & (1ULL << prop_id)) {
+            continue;
+        }
+
+        mdl_action_t required_action = ctx->model_sync_required(ctx->model_userdata, prop_id);
+        if (required_action != MDL_ACTION_READ && required_action != MDL_ACTION_WRITE &&
+            required_action != MDL_ACTION_BROADCAST) {
+            continue;
+        }
+
+        of_mdl_master_prio_t prio = of_mdl_master_prio_get(prop_id, required_action);
+        if (prio >= prio_limit) {
+            continue;
+        }
+
+        /* Only address the nodes up to the last node that must be written. */
+        uint16_t node_cnt = *ctx->node_cnt_ref;
+        if (required_action == MDL_ACTION_WRITE && ctx->model_write_node_cnt != NULL) {
+            node_cnt = ctx->model_write_node_cnt(ctx->model_userdata, prop_id);
+            if (node_cnt == 0) {
+                /* The model has nothing to write, so it is already synchronized. */
+                ctx->model_sync_done(ctx->model_userdata, prop_id);
                 continue;
             }
+        }
 
-            mdl_master_err_t err = MDL_MASTER_ERR_FAIL;
-            uint8_t attempt_cnt  = 1;
-            uint32_t delay_ms    = 0;
-            do {
-                ESP_LOGI(TAG, "Attempt %d for property %s", attempt_cnt, of_mdl_prop_name_by_id(prop_id));
-                err = mdl_master_communication_handler(&ctx->mdl_master, &delay_ms);
-                vTaskDelay(pdMS_TO_TICKS(delay_ms));
-            } while (err != MDL_MASTER_OK && attempt_cnt++ < 3); /* Max 3 Attempts. */
-
-            if (err == MDL_MASTER_OK) {
-                ESP_LOGI(TAG, "Synchronized property %s successfully", of_mdl_prop_name_by_id(prop_id));
-                ctx->model_sync_done(ctx->model_userdata, prop_id);
-            } else {
-                ESP_LOGE(TAG, "Failed to synchronize property %s after %d attempts", of_mdl_prop_name_by_id(prop_id),
-                         attempt_cnt - 1);
-                break;
+        /* Insert the transaction after all transactions with the same or a higher priority. */
+        uint8_t i = plan->entry_cnt;
+        for (; i > 0 && plan->entries[i - 1].prio > prio; i--) {
+            plan->entries[i] = plan->entries[i - 1];
+        }
+        plan->entries[i].prop_id  = prop_id;
+        plan->entries[i].action   = required_action;
+        plan->entries[i].node_cnt = node_cnt;
+        plan->entries[i].prio     = prio;
+        plan->entry_cnt++;
+    }
+
+    return plan->entry_cnt;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Execute all transactions of a plan.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] plan The plan to execute.
+ * \param[in] request_ticks Time of the first synchronization request which is served by the plan.
+ * \param[in] preemptible Allow new requests with a higher priority to be served before lower priority transactions.
+ * \param[inout] stats The statistics of the current synchronization pass.
+ * \param[inout] fail_cnt The number of consecutive failed transactions.
+ */
+static void of_mdl_master_sync_plan_execute(of_mdl_master_ctx_t *ctx, const of_mdl_master_sync_plan_t *plan,
+                                            TickType_t request_ticks, bool preemptible,
+                                            of_mdl_master_sync_stats_t *stats, uint8_t *fail_cnt)
+{
+    for (uint8_t i = 0; i < plan->entry_cnt; i++) {
+        const of_mdl_master_sync_plan_entry_t *entry = &plan->entries[i];
+
+        /* Serve higher priority requests that were made after the plan was made. */
+        bool sync_requested = xEventGroupGetBits(ctx->event_handle) & OF_MDL_MASTER_MODEL_EVENT_DESYNCHRONIZED;
+        if (preemptible && sync_requested && entry->prio > OF_MDL_MASTER_PRIO_INTERACTIVE) {
+            of_mdl_master_sync_preempt(ctx, entry->prio, stats, fail_cnt);
+        }
+
+        /* Leave the remaining properties dirty when the chain appears to be broken. */
+        if (*fail_cnt >= OF_MDL_MASTER_FAIL_LIMIT) {
+            stats->dirty_prop_mask |= (1ULL << entry->prop_id);
+            stats->dirty_node_cnt = MAX(stats->dirty_node_cnt, entry->node_cnt);
+            continue;
+        }
+
+        uint32_t queue_delay_ms            = pdTICKS_TO_MS(xTaskGetTickCount() - request_ticks);
+        stats->queue_delay_ms[entry->prio] = MAX(stats->queue_delay_ms[entry->prio], queue_delay_ms);
+
+        /* A successful broadcast may be followed by a sequential write which patches some nodes. */
+        of_mdl_master_sync_plan_entry_t patch;
+        if (of_mdl_master_sync_plan_entry_execute(ctx, entry, stats) == MDL_MASTER_OK) {
+            *fail_cnt = 0;
+            if (!of_mdl_master_sync_patch_plan(ctx, entry, &patch) ||
+                of_mdl_master_sync_plan_entry_execute(ctx, &patch, stats) == MDL_MASTER_OK) {
+                continue;
             }
+            entry = &patch;
         }
+        (*fail_cnt)++;
 
-        ESP_LOGI(TAG, "Chain Comm Master Synchronization Completed!");
-        /* Indicate synchronization is done. */
-        xEventGroupSetBits(ctx->event_handle, OF_MDL_MASTER_MODEL_EVENT_SYNCHRONIZED);
+        /* The model keeps the property dirty, so the next pass only covers what is left. */
+        uint16_t dirty_node_cnt = entry->node_cnt;
+        if (entry->action == MDL_ACTION_WRITE && ctx->model_write_node_cnt != NULL) {
+            dirty_node_cnt = ctx->model_write_node_cnt(ctx->model_userdata, entry->prop_id);
+        }
+        stats->dirty_prop_mask |= (1ULL << entry->prop_id);
+        stats->dirty_node_cnt = MAX(stats->dirty_node_cnt, dirty_node_cnt);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Serve new requests with a higher priority than the next planned transaction.
+ *
+ * The callers of these requests are still released by the next synchronization pass, only the bus time is preempted.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] prio The priority class of the next planned transaction.
+ * \param[inout] stats The statistics of the current synchronization pass.
+ * \param[inout] fail_cnt The number of consecutive failed transactions.
+ */
+static void of_mdl_master_sync_preempt(of_mdl_master_ctx_t *ctx, of_mdl_master_prio_t prio,
+                                       of_mdl_master_sync_stats_t *stats, uint8_t *fail_cnt)
+{
+    xSemaphoreTake(ctx->sync_lock, portMAX_DELAY);
+    TickType_t request_ticks = ctx->sync_request_ticks;
+    xSemaphoreGive(ctx->sync_lock);
+
+    /* Properties that failed in this pass are not retried. */
+    of_mdl_master_sync_plan_t plan;
+    if (of_mdl_master_sync_plan(ctx, &plan, prio, stats->dirty_prop_mask) == 0) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Preempting for %d higher priority transactions", plan.entry_cnt);
+    stats->preempt_cnt++;
+    stats->prop_cnt += plan.entry_cnt;
+    of_mdl_master_sync_plan_execute(ctx, &plan, request_ticks, false, stats, fail_cnt);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the priority class of a transaction.
+ *
+ * \param[in] prop_id The property of the transaction.
+ * \param[in] action The action of the transaction.
+ *
+ * \return The priority class.
+ */
+static of_mdl_master_prio_t of_mdl_master_prio_get(mdl_prop_id_t prop_id, mdl_action_t action)
+{
+    if (action == MDL_ACTION_READ) {
+        return OF_MDL_MASTER_PRIO_BACKGROUND_READ;
     }
+
+    switch (prop_id) {
+        case OF_MDL_PROP_CHARACTER:
+        case OF_MDL_PROP_COMMAND:
+            return OF_MDL_MASTER_PRIO_INTERACTIVE;
+        case OF_MDL_PROP_FIRMWARE_UPDATE:
+        case OF_MDL_PROP_FIRMWARE_LZ_PAGE:
+        case OF_MDL_PROP_FIRMWARE_BURST:
+            return OF_MDL_MASTER_PRIO_BULK;
+        default:
+            return OF_MDL_MASTER_PRIO_CONFIG;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Plan the sequential write which patches the nodes that did not receive their own value from a broadcast.
+ *
+ * The model may broadcast the most common value of a property, nodes with another value still require a write of the
+ * same property once the broadcast is done. This write is made right away, so the property is complete in one pass.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] entry The transaction that has been executed.
+ * \param[out] patch The sequential write of the same property.
+ *
+ * \return true if a sequential write must follow the transaction, false otherwise.
+ */
+static bool of_mdl_master_sync_patch_plan(of_mdl_master_ctx_t *ctx, const of_mdl_master_sync_plan_entry_t *entry,
+                                          of_mdl_master_sync_plan_entry_t *patch)
+{
+    if (entry->action != MDL_ACTION_BROADCAST ||
+        ctx->model_sync_required(ctx->model_userdata, entry->prop_id) != MDL_ACTION_WRITE) {
+        return false;
+    }
+
+    *patch        = *entry;
+    patch->action = MDL_ACTION_WRITE;
+    if (ctx->model_write_node_cnt != NULL) {
+        patch->node_cnt = ctx->model_write_node_cnt(ctx->model_userdata, entry->prop_id);
+    }
+    return patch->node_cnt > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Queue and transmit a single planned transaction, retrying with an exponential backoff on failure.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[in] entry The planned transaction.
+ * \param[inout] stats The statistics of the current synchronization pass.
+ *
+ * \retval MDL_MASTER_OK The property was synchronized.
+ * \retval MDL_MASTER_ERR_FAIL The property could not be synchronized.
+ */
+static mdl_master_err_t of_mdl_master_sync_plan_entry_execute(of_mdl_master_ctx_t *ctx,
+                                                              const of_mdl_master_sync_plan_entry_t *entry,
+                                                              of_mdl_master_sync_stats_t *stats)
+{
+    mdl_prop_id_t prop_id = entry->prop_id;
+
+    if (entry->action == MDL_ACTION_READ) {
+        ESP_LOGI(TAG, "Model requires READ of property %s", of_mdl_prop_name_by_id(prop_id));
+        mdl_master_queue_prop_read(&ctx->mdl_master, prop_id);
+    } else {
+        bool broadcast = (entry->action == MDL_ACTION_BROADCAST);
+        ESP_LOGI(TAG, "Model requires %s of property %s to %d nodes", broadcast ? "BROADCAST" : "WRITE",
+                 of_mdl_prop_name_by_id(prop_id), entry->node_cnt);
+        mdl_master_queue_prop_write(&ctx->mdl_master, prop_id, entry->node_cnt, broadcast);
+        if (!broadcast) {
+            stats->node_cnt += entry->node_cnt;
+        }
+    }
+
+    mdl_master_err_t err = MDL_MASTER_ERR_FAIL;
+    uint8_t attempt_cnt  = 1;
+    uint32_t delay_ms    = 0;
+    uint32_t backoff_ms  = OF_MDL_MASTER_RETRY_BACKOFF_MS;
+    while (1) {
+        ESP_LOGD(TAG, "Attempt %d for property %s", attempt_cnt, of_mdl_prop_name_by_id(prop_id));
+        err = mdl_master_communication_handler(&ctx->mdl_master, &delay_ms);
+        stats->frame_cnt++;
+        if (err == MDL_MASTER_OK || attempt_cnt++ >= OF_MDL_MASTER_ATTEMPT_MAX) {
+            of_mdl_master_uart_delay(&ctx->uart_ctx, delay_ms);
+            break;
+        }
+
+        /* Give a disturbed chain some time to recover before retrying. */
+        of_mdl_master_uart_delay(&ctx->uart_ctx, delay_ms + backoff_ms);
+        backoff_ms *= 2;
+    }
+
+    if (err == MDL_MASTER_OK) {
+        ESP_LOGI(TAG, "Synchronized property %s successfully", of_mdl_prop_name_by_id(prop_id));
+        ctx->model_sync_done(ctx->model_userdata, prop_id);
+    } else {
+        ESP_LOGE(TAG, "Failed to synchronize property %s after %d attempts", of_mdl_prop_name_by_id(prop_id),
+                 attempt_cnt - 1);
+    }
+
+    /* A command may have rebooted the nodes, which then start at the default baud rate. Failures that follow are not
+     * caused by the baud rate, so the limit is kept. */
+    if (prop_id == OF_MDL_PROP_COMMAND && entry->action != MDL_ACTION_READ) {
+        of_mdl_master_baud_rate_reset(ctx);
+    }
+
+    return err;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Negotiate the fastest baud rate that is supported by every node on the chain.
+ *
+ * The highest supported baud rate of every node is read, the fastest common baud rate is broadcast to all nodes and
+ * the controller follows. The new baud rate is verified by reading the baud rate property again, all nodes are
+ * reverted to #OF_BAUD_RATE_DEFAULT if this fails.
+ *
+ * \param[in] ctx The chain communication context.
+ * \param[inout] stats The statistics of the current synchronization pass.
+ */
+static void of_mdl_master_baud_rate_negotiate(of_mdl_master_ctx_t *ctx, of_mdl_master_sync_stats_t *stats)
+{
+    of_mdl_master_sync_plan_entry_t entry = {.prop_id = OF_MDL_PROP_BAUD_RATE, .action = MDL_ACTION_READ};
+
+    /* Read the highest baud rate supported by every node. */
+    if (of_mdl_master_sync_plan_entry_execute(ctx, &entry, stats) != MDL_MASTER_OK) {
+        ESP_LOGW(TAG, "Failed to read the supported baud rates, staying at %" PRIu32 " baud", ctx->uart_ctx.baud_rate);
+        ctx->baud_rate_negotiate = false;
+        ctx->baud_rate_node_cnt  = *ctx->node_cnt_ref;
+        return;
+    }
+
+    uint32_t baud_rate_max = ctx->model_baud_rate_get(ctx->model_userdata);
+    if (baud_rate_max == 0) {
+        /* No nodes on the chain (yet), try again next time. */
+        return;
+    }
+    ctx->baud_rate_negotiate = false;
+    ctx->baud_rate_node_cnt  = *ctx->node_cnt_ref;
+
+    /* Select the fastest baud rate that is supported by all nodes and has not failed before. */
+    uint32_t baud_rate = OF_BAUD_RATE_DEFAULT;
+    for (size_t i = 0; i < OF_MDL_MASTER_BAUD_RATE_CNT; i++) {
+        if (of_mdl_master_baud_rates[i] <= baud_rate_max && of_mdl_master_baud_rates[i] <= ctx->baud_rate_limit) {
+            baud_rate = of_mdl_master_baud_rates[i];
+            break;
+        }
+    }
+
+    if (baud_rate == ctx->uart_ctx.baud_rate) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Negotiating %" PRIu32 " baud with %d nodes", baud_rate, *ctx->node_cnt_ref);
+
+    /* Write the new baud rate to all nodes. The nodes switch once the transaction has completed. */
+    ctx->model_baud_rate_set(ctx->model_userdata, baud_rate);
+    entry.action   = MDL_ACTION_BROADCAST;
+    entry.node_cnt = *ctx->node_cnt_ref;
+    if (of_mdl_master_sync_plan_entry_execute(ctx, &entry, stats) != MDL_MASTER_OK) {
+        /* Some nodes may have switched, bring them all back to the same baud rate. */
+        of_mdl_master_baud_rate_fallback(ctx);
+        return;
+    }
+    of_mdl_master_uart_delay(&ctx->uart_ctx, OF_MDL_MASTER_BAUD_RATE_SETTLE_MS);
+    ESP_ERROR_CHECK(of_mdl_master_uart_baud_rate_set(&ctx->uart_ctx, baud_rate));
+
+    /* Verify that every node can keep up at the new baud rate. */
+    entry.action = MDL_ACTION_READ;
+    if (of_mdl_master_sync_plan_entry_execute(ctx, &entry, stats) != MDL_MASTER_OK) {
+        of_mdl_master_baud_rate_fallback(ctx);
+        return;
+    }
+
+    /* Only failures at the new baud rate count against it. */
+    ctx->baud_rate_error_cnt = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Revert all nodes on the chain to #OF_BAUD_RATE_DEFAULT.
+ *
+ * The baud rate that failed will not be negotiated again, the next synchronization pass will negotiate the next lower
+ * baud rate.
+ *
+ * \param[in] ctx The chain communication context.
+ */
+static void of_mdl_master_baud_rate_fallback(of_mdl_master_ctx_t *ctx)
+{
+    uint32_t baud_rate_failed = ctx->uart_ctx.baud_rate;
+
+    /* Lower the limit below the baud rate that failed. */
+    ctx->baud_rate_limit = OF_BAUD_RATE_DEFAULT;
+    for (size_t i = 0; i < OF_MDL_MASTER_BAUD_RATE_CNT; i++) {
+        if (of_mdl_master_baud_rates[i] < baud_rate_failed) {
+            ctx->baud_rate_limit = of_mdl_master_baud_rates[i];
+            break;
+        }
+    }
+
+    ESP_LOGW(TAG, "Reverting chain from %" PRIu32 " to %d baud", baud_rate_failed, OF_BAUD_RATE_DEFAULT);
+    of_mdl_master_baud_rate_revert(ctx);
+
+    ctx->baud_rate_error_cnt = 0;
+    ctx->baud_rate_negotiate = (ctx->baud_rate_limit > OF_BAUD_RATE_DEFAULT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Revert all nodes on the chain to #OF_BAUD_RATE_DEFAULT, and negotiate again up to the current limit.
+ *
+ * \param[in] ctx The chain communication context.
+ */
+static void of_mdl_master_baud_rate_reset(of_mdl_master_ctx_t *ctx)
+{
+    if (ctx->uart_ctx.baud_rate > OF_BAUD_RATE_DEFAULT) {
+        ESP_LOGI(TAG, "Reverting chain from %" PRIu32 " to %d baud", ctx->uart_ctx.baud_rate, OF_BAUD_RATE_DEFAULT);
+        of_mdl_master_baud_rate_revert(ctx);
+    }
+
+    ctx->baud_rate_error_cnt = 0;
+    ctx->baud_rate_node_cnt  = *ctx->node_cnt_ref;
+    ctx->baud_rate_negotiate = (ctx->model_baud_rate_get != NULL && ctx->model_baud_rate_set != NULL &&
+                                ctx->baud_rate_limit > OF_BAUD_RATE_DEFAULT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Switch the controller and all nodes on the chain to #OF_BAUD_RATE_DEFAULT.
+ *
+ * \param[in] ctx The chain communication context.
+ */
+static void of_mdl_master_baud_rate_revert(of_mdl_master_ctx_t *ctx)
+{
+    /* A break is received as a framing error by every node, which reverts the node to the default baud rate. */
+    ESP_ERROR_CHECK(of_mdl_master_uart_baud_rate_set(&ctx->uart_ctx, OF_BAUD_RATE_DEFAULT));
+    ESP_ERROR_CHECK(of_mdl_master_uart_break_send(&ctx->uart_ctx));
+
+    /* Allow the nodes to discard any partially received message. */
+    of_mdl_master_uart_delay(&ctx->uart_ctx, MDL_NODE_TIMEOUT_MS * 1.1);
+    of_mdl_master_uart_rx_flush(&ctx->uart_ctx);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -1,9 +1,9 @@
 #include "openflap_mdl_master_uart.h"
 
 #include "driver/gpio.h"
-#include "hal/gpio_hal.h"
-#include "rom/gpio.h"
-#include "soc/gpio_sig_map.h"
+#include "esp_timer.h"
+
+#include <inttypes.h>
 
 //======================================================================================================================
 //                                                   MACROS a DEFINES
@@ -11,6 +11,16 @@
 
 #define TAG "OF_MDL_MASTER_UART"
 
+/** The UART and pins of each chain port. */
+static const struct {
+    uart_port_t uart_num;
+    gpio_num_t tx_pin;
+    gpio_num_t rx_pin;
+} of_mdl_master_uart_ports[OF_MDL_MASTER_CHAIN_CNT] = {
+    [OF_MDL_MASTER_CHAIN_COL] = {.uart_num = UART_NUM_COL, .tx_pin = TX_COL_PIN, .rx_pin = RX_COL_PIN},
+    [OF_MDL_MASTER_CHAIN_ROW] = {.uart_num = UART_NUM_ROW, .tx_pin = TX_ROW_PIN, .rx_pin = RX_ROW_PIN},
+};
+
 //======================================================================================================================
 //                                                   FUNCTION PROTOTYPES
 //======================================================================================================================
@@ -25,22 +35,32 @@ void of_mdl_master_uart_wait_tx_done(void *uart_userdata);
 //                                                   PUBLIC FUNCTIONS
 //======================================================================================================================
 
-esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, mdl_master_uart_cb_cfg_t *uart_cb_cfg)
+esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, of_mdl_master_chain_t chain,
+                                  mdl_master_uart_cb_cfg_t *uart_cb_cfg)
 {
     ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+    ESP_RETURN_ON_FALSE(chain < OF_MDL_MASTER_CHAIN_CNT, ESP_ERR_INVALID_ARG, TAG, "Invalid chain port");
     ESP_RETURN_ON_FALSE(uart_cb_cfg != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_cb_cfg is NULL");
 
+    uart_port_t uart_num = of_mdl_master_uart_ports[chain].uart_num;
+
     uart_config_t uart_config = {
-        .baud_rate  = 115200,
+        .baud_rate  = OF_BAUD_RATE_DEFAULT,
         .data_bits  = UART_DATA_8_BITS,
         .parity     = UART_PARITY_DISABLE,
         .stop_bits  = UART_STOP_BITS_1,
         .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_APB,
     };
-    ESP_RETURN_ON_ERROR(uart_driver_install(UART_NUM, UART_BUF_SIZE, UART_BUF_SIZE, 0, NULL, 0), TAG,
-                        "Failed to install UART driver");
-    ESP_RETURN_ON_ERROR(uart_param_config(UART_NUM, &uart_config), TAG, "Failed to configure UART parameters");
+    ESP_RETURN_ON_ERROR(uart_driver_install(uart_num, UART_BUF_SIZE, UART_BUF_SIZE, UART_EVENT_QUEUE_LEN,
+                                            &uart_ctx->event_queue, 0),
+                        TAG, "Failed to install UART driver");
+    ESP_RETURN_ON_ERROR(uart_param_config(uart_num, &uart_config), TAG, "Failed to configure UART parameters");
+
+    /* Hand received bytes to the task as soon as the line goes idle, instead of after the default 10 symbols. */
+    ESP_RETURN_ON_ERROR(uart_set_rx_full_threshold(uart_num, UART_RX_FULL_THRESHOLD), TAG,
+                        "Failed to set RX FIFO threshold");
+    ESP_RETURN_ON_ERROR(uart_set_rx_timeout(uart_num, UART_RX_TIMEOUT_SYMBOLS), TAG, "Failed to set RX timeout");
 
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << COL_START_PIN) | (1ULL << ROW_START_PIN),
@@ -52,8 +72,14 @@ esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, mdl_master
     ESP_RETURN_ON_ERROR(gpio_config(&io_conf), TAG, "Failed to configure COL_START_PIN and ROW_START_PIN as inputs");
 
     /* Configure the context. */
-    uart_ctx->uart_num         = UART_NUM;
+    uart_ctx->chain            = chain;
+    uart_ctx->uart_num         = uart_num;
+    uart_ctx->connected        = false;
     uart_ctx->rx_timeout_ticks = 0;
+    uart_ctx->rx_error_cnt     = 0;
+    uart_ctx->tx_byte_cnt      = 0;
+    uart_ctx->rx_byte_cnt      = 0;
+    uart_ctx->baud_rate        = OF_BAUD_RATE_DEFAULT;
 
     /* Configure the callback functions. */
     uart_cb_cfg->read             = of_mdl_master_uart_read;
@@ -72,47 +98,114 @@ esp_err_t of_mdl_master_uart_deinit(of_mdl_master_uart_ctx_t *uart_ctx)
     ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
 
     uart_driver_delete(uart_ctx->uart_num);
+    uart_ctx->event_queue = NULL;
     return ESP_OK;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-esp_err_t of_mdl_master_uart_reconfigure(bool controller_is_col_start, bool controller_is_row_start)
+void of_mdl_master_uart_start_pins_get(bool *controller_is_col_start, bool *controller_is_row_start)
 {
-    gpio_reset_pin(RX_COL_PIN);
-    gpio_set_direction(RX_COL_PIN, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(RX_COL_PIN, GPIO_PULLUP_ONLY);
-    gpio_reset_pin(TX_COL_PIN);
-    gpio_set_direction(TX_COL_PIN, GPIO_MODE_OUTPUT);
-    gpio_set_pull_mode(TX_COL_PIN, GPIO_FLOATING);
-    gpio_reset_pin(RX_ROW_PIN);
-    gpio_set_direction(RX_ROW_PIN, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(RX_ROW_PIN, GPIO_PULLUP_ONLY);
-    gpio_reset_pin(TX_ROW_PIN);
-    gpio_set_direction(TX_ROW_PIN, GPIO_MODE_OUTPUT);
-    gpio_set_pull_mode(TX_ROW_PIN, GPIO_FLOATING);
+    *controller_is_col_start = !gpio_get_level(COL_START_PIN);
+    *controller_is_row_start = !gpio_get_level(ROW_START_PIN);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_reconfigure(of_mdl_master_uart_ctx_t *uart_ctx, bool controller_is_col_start,
+                                         bool controller_is_row_start)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    gpio_num_t tx_pin = of_mdl_master_uart_ports[uart_ctx->chain].tx_pin;
+    gpio_num_t rx_pin = of_mdl_master_uart_ports[uart_ctx->chain].rx_pin;
+
+    gpio_reset_pin(rx_pin);
+    gpio_set_direction(rx_pin, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(rx_pin, GPIO_PULLUP_ONLY);
+    gpio_reset_pin(tx_pin);
+    gpio_set_direction(tx_pin, GPIO_MODE_OUTPUT);
+    gpio_set_pull_mode(tx_pin, GPIO_FLOATING);
 
     if (controller_is_row_start == controller_is_col_start) {
-        /* Both values are the same, either connected in a full display or not connected at all. */
-        ESP_RETURN_ON_ERROR(uart_set_pin(UART_NUM, TX_COL_PIN, RX_ROW_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE), TAG,
-                            "Failed to set UART pins");
-
-        /* Also connect RX_COL_PIN -> TX_ROW_PIN (direct mirror) */
-        gpio_matrix_in(RX_COL_PIN, SIG_IN_FUNC_212_IDX, false);
-        gpio_matrix_out(TX_ROW_PIN, SIG_IN_FUNC_212_IDX, false, false);
-    } else if (controller_is_col_start && !controller_is_row_start) {
+        /* Both values are the same, either connected in a full display or not connected at all. Both ports are used as
+         * independent chains: the column returns on RX_COL_PIN and the other columns return on RX_ROW_PIN. */
+        uart_ctx->connected = true;
+    } else if (uart_ctx->chain == OF_MDL_MASTER_CHAIN_COL) {
         /* Tx and Rx from column only. */
-        ESP_RETURN_ON_ERROR(uart_set_pin(UART_NUM, TX_COL_PIN, RX_COL_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE), TAG,
-                            "Failed to set UART pins");
-    } else if (!controller_is_col_start && controller_is_row_start) {
+        uart_ctx->connected = controller_is_col_start;
+    } else {
         /* Tx and Rx from row only. */
-        ESP_RETURN_ON_ERROR(uart_set_pin(UART_NUM, TX_ROW_PIN, RX_ROW_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE), TAG,
-                            "Failed to set UART pins");
+        uart_ctx->connected = controller_is_row_start;
     }
 
+    if (uart_ctx->connected) {
+        ESP_RETURN_ON_ERROR(uart_set_pin(uart_ctx->uart_num, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE),
+                            TAG, "Failed to set UART pins");
+    }
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_baud_rate_set(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t baud_rate)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    ESP_RETURN_ON_ERROR(uart_wait_tx_done(uart_ctx->uart_num, portMAX_DELAY), TAG, "Failed to wait for TX done");
+    ESP_RETURN_ON_ERROR(uart_set_baudrate(uart_ctx->uart_num, baud_rate), TAG, "Failed to set baud rate");
+    uart_ctx->baud_rate = baud_rate;
+
+    ESP_LOGI(TAG, "Chain baud rate set to %" PRIu32, baud_rate);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_break_send(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    const char zero = 0;
+    ESP_RETURN_ON_FALSE(uart_write_bytes_with_break(uart_ctx->uart_num, &zero, 1, UART_BREAK_LEN) == 1, ESP_FAIL, TAG,
+                        "Failed to send break");
+    ESP_RETURN_ON_ERROR(uart_wait_tx_done(uart_ctx->uart_num, portMAX_DELAY), TAG, "Failed to wait for TX done");
+
     return ESP_OK;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_mdl_master_uart_rx_unexpected(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    uint8_t data = 0;
+    return uart_read_bytes(uart_ctx->uart_num, &data, 1, 0) > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_rx_flush(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    uart_flush_input(uart_ctx->uart_num);
+    xQueueReset(uart_ctx->event_queue);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int64_t of_mdl_master_uart_time_us_get(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    return esp_timer_get_time();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_delay(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t delay_ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(delay_ms));
+}
+
 //======================================================================================================================
 //                                                         PRIVATE FUNCTIONS
 //======================================================================================================================
@@ -120,7 +213,41 @@ esp_err_t of_mdl_master_uart_reconfigure(bool controller_is_col_start, bool cont
 size_t of_mdl_master_uart_read(void *uart_userdata, uint8_t *data, size_t size)
 {
     of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
-    return uart_read_bytes(ctx->uart_num, data, size, ctx->rx_timeout_ticks);
+
+    size_t read_cnt        = 0;
+    TickType_t start_ticks = xTaskGetTickCount();
+    while (read_cnt < size) {
+        /* Copy whatever the driver has buffered straight into the frame, without blocking. */
+        int cnt = uart_read_bytes(ctx->uart_num, data + read_cnt, size - read_cnt, 0);
+        if (cnt > 0) {
+            read_cnt += cnt;
+            continue;
+        }
+
+        /* Sleep until the ISR reports new data or an error. */
+        TickType_t elapsed_ticks = xTaskGetTickCount() - start_ticks;
+        if (elapsed_ticks >= ctx->rx_timeout_ticks) {
+            break;
+        }
+        uart_event_t event;
+        if (xQueueReceive(ctx->event_queue, &event, ctx->rx_timeout_ticks - elapsed_ticks) != pdTRUE) {
+            break;
+        }
+
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            /* Bytes have been lost, the frame can't be completed. */
+            ESP_LOGW(TAG, "UART %d RX overflow", ctx->uart_num);
+            ctx->rx_error_cnt++;
+            uart_flush_input(ctx->uart_num);
+            xQueueReset(ctx->event_queue);
+            break;
+        } else if (event.type == UART_FRAME_ERR || event.type == UART_PARITY_ERR) {
+            ctx->rx_error_cnt++;
+        }
+    }
+
+    ctx->rx_byte_cnt += read_cnt;
+    return read_cnt;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -128,7 +255,12 @@ size_t of_mdl_master_uart_read(void *uart_userdata, uint8_t *data, size_t size)
 size_t of_mdl_master_uart_write(void *uart_userdata, const uint8_t *data, size_t size)
 {
     of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
-    return uart_write_bytes(ctx->uart_num, (const char *)data, size);
+    int write_cnt                 = uart_write_bytes(ctx->uart_num, (const char *)data, size);
+    if (write_cnt < 0) {
+        return 0;
+    }
+    ctx->tx_byte_cnt += write_cnt;
+    return write_cnt;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -143,8 +275,7 @@ void of_mdl_master_uart_read_timeout_set(void *uart_userdata, uint32_t timeout_m
 
 void of_mdl_master_uart_flush_rx_buff(void *uart_userdata)
 {
-    of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
-    uart_flush_input(ctx->uart_num);
+    of_mdl_master_uart_rx_flush((of_mdl_master_uart_ctx_t *)uart_userdata);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,415 @@
+#include "openflap_mdl_master_uart.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Chain communication on the linux target: every chain port is connected to a chain simulator process
+ * (software/module/sim) through its stdin and stdout. The simulator only runs while it is asked to read or wait, so
+ * timeouts and delays are measured on its virtual clock. */
+
+//======================================================================================================================
+//                                                   MACROS a DEFINES
+//======================================================================================================================
+
+#define TAG "OF_MDL_MASTER_UART"
+
+/** Size of the answer of the chain simulator to a read or wait, without the bytes. */
+#define SIM_REPLY_HDR_LEN (sizeof(uint64_t) + sizeof(uint16_t))
+
+/** The environment variable with the simulator command of each chain port. */
+static const char *of_mdl_master_uart_sim_cmd_env[OF_MDL_MASTER_CHAIN_CNT] = {
+    [OF_MDL_MASTER_CHAIN_COL] = OF_MDL_SIM_COL_CMD_ENV,
+    [OF_MDL_MASTER_CHAIN_ROW] = OF_MDL_SIM_ROW_CMD_ENV,
+};
+
+//======================================================================================================================
+//                                                   FUNCTION PROTOTYPES
+//======================================================================================================================
+
+size_t of_mdl_master_uart_read(void *uart_userdata, uint8_t *data, size_t size);
+size_t of_mdl_master_uart_write(void *uart_userdata, const uint8_t *data, size_t size);
+void of_mdl_master_uart_read_timeout_set(void *uart_userdata, uint32_t timeout_ms);
+void of_mdl_master_uart_flush_rx_buff(void *uart_userdata);
+void of_mdl_master_uart_wait_tx_done(void *uart_userdata);
+
+static esp_err_t of_mdl_master_uart_sim_start(of_mdl_master_uart_ctx_t *uart_ctx, const char *cmd);
+static bool of_mdl_master_uart_sim_send(of_mdl_master_uart_ctx_t *uart_ctx, const void *data, size_t size);
+static bool of_mdl_master_uart_sim_recv(of_mdl_master_uart_ctx_t *uart_ctx, void *data, size_t size);
+static size_t of_mdl_master_uart_sim_run(of_mdl_master_uart_ctx_t *uart_ctx, uint8_t cmd, uint8_t *data, size_t size,
+                                         uint32_t timeout_us);
+
+//======================================================================================================================
+//                                                   PUBLIC FUNCTIONS
+//======================================================================================================================
+
+esp_err_t of_mdl_master_uart_init(of_mdl_master_uart_ctx_t *uart_ctx, of_mdl_master_chain_t chain,
+                                  mdl_master_uart_cb_cfg_t *uart_cb_cfg)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+    ESP_RETURN_ON_FALSE(chain < OF_MDL_MASTER_CHAIN_CNT, ESP_ERR_INVALID_ARG, TAG, "Invalid chain port");
+    ESP_RETURN_ON_FALSE(uart_cb_cfg != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_cb_cfg is NULL");
+
+    /* Configure the context. */
+    uart_ctx->chain            = chain;
+    uart_ctx->sim_pid          = 0;
+    uart_ctx->sim_tx_fd        = -1;
+    uart_ctx->sim_rx_fd        = -1;
+    uart_ctx->sim_time_ns      = 0;
+    uart_ctx->connected        = false;
+    uart_ctx->rx_timeout_ticks = 0;
+    uart_ctx->rx_error_cnt     = 0;
+    uart_ctx->tx_byte_cnt      = 0;
+    uart_ctx->rx_byte_cnt      = 0;
+    uart_ctx->baud_rate        = OF_BAUD_RATE_DEFAULT;
+
+    /* A chain port without a simulator command has no modules. */
+    const char *cmd = getenv(of_mdl_master_uart_sim_cmd_env[chain]);
+    if (cmd != NULL && cmd[0] != '\0') {
+        ESP_RETURN_ON_ERROR(of_mdl_master_uart_sim_start(uart_ctx, cmd), TAG, "Failed to start the chain simulator");
+    }
+
+    /* Configure the callback functions. */
+    uart_cb_cfg->read             = of_mdl_master_uart_read;
+    uart_cb_cfg->write            = of_mdl_master_uart_write;
+    uart_cb_cfg->read_timeout_set = of_mdl_master_uart_read_timeout_set;
+    uart_cb_cfg->flush_rx_buff    = of_mdl_master_uart_flush_rx_buff;
+    uart_cb_cfg->wait_tx_done     = of_mdl_master_uart_wait_tx_done;
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_deinit(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    if (uart_ctx->sim_pid > 0) {
+        /* Closing stdin ends the simulator. */
+        close(uart_ctx->sim_tx_fd);
+        close(uart_ctx->sim_rx_fd);
+        waitpid(uart_ctx->sim_pid, NULL, 0);
+    }
+    uart_ctx->sim_pid   = 0;
+    uart_ctx->sim_tx_fd = -1;
+    uart_ctx->sim_rx_fd = -1;
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_start_pins_get(bool *controller_is_col_start, bool *controller_is_row_start)
+{
+    /* Each chain port with a simulator behaves like a port with modules connected. */
+    *controller_is_col_start = getenv(OF_MDL_SIM_COL_CMD_ENV) != NULL;
+    *controller_is_row_start = getenv(OF_MDL_SIM_ROW_CMD_ENV) != NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_reconfigure(of_mdl_master_uart_ctx_t *uart_ctx, bool controller_is_col_start,
+                                         bool controller_is_row_start)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    uart_ctx->connected = (uart_ctx->sim_pid > 0);
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_baud_rate_set(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t baud_rate)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    /* The pipe has no baud rate, the simulator sends our bytes at the baud rate of its first node. */
+    uart_ctx->baud_rate = baud_rate;
+
+    ESP_LOGI(TAG, "Chain baud rate set to %" PRIu32, baud_rate);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_mdl_master_uart_break_send(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    ESP_RETURN_ON_FALSE(uart_ctx != NULL, ESP_ERR_INVALID_ARG, TAG, "uart_ctx is NULL");
+
+    if (uart_ctx->sim_pid > 0) {
+        uint8_t cmd = OF_MDL_SIM_CMD_BREAK;
+        ESP_RETURN_ON_FALSE(of_mdl_master_uart_sim_send(uart_ctx, &cmd, sizeof(cmd)), ESP_FAIL, TAG,
+                            "Failed to send break");
+    }
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_mdl_master_uart_rx_unexpected(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    uint8_t data = 0;
+    return of_mdl_master_uart_sim_run(uart_ctx, OF_MDL_SIM_CMD_READ, &data, sizeof(data), 0) > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_rx_flush(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    uint8_t data[64];
+    while (of_mdl_master_uart_sim_run(uart_ctx, OF_MDL_SIM_CMD_READ, data, sizeof(data), 0) > 0) {
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int64_t of_mdl_master_uart_time_us_get(of_mdl_master_uart_ctx_t *uart_ctx)
+{
+    return uart_ctx->sim_time_ns / 1000;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_delay(of_mdl_master_uart_ctx_t *uart_ctx, uint32_t delay_ms)
+{
+    if (uart_ctx->sim_pid > 0) {
+        /* The chain keeps running during the delay, the bytes it returns stay buffered like in the UART driver. */
+        of_mdl_master_uart_sim_run(uart_ctx, OF_MDL_SIM_CMD_WAIT, NULL, 0, delay_ms * 1000);
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+}
+
+//======================================================================================================================
+//                                                         PRIVATE FUNCTIONS
+//======================================================================================================================
+
+size_t of_mdl_master_uart_read(void *uart_userdata, uint8_t *data, size_t size)
+{
+    of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
+
+    size_t read_cnt = 0;
+    while (read_cnt < size) {
+        size_t chunk = MIN(size - read_cnt, UINT16_MAX);
+        size_t cnt   = of_mdl_master_uart_sim_run(ctx, OF_MDL_SIM_CMD_READ, data + read_cnt, chunk,
+                                                  pdTICKS_TO_MS(ctx->rx_timeout_ticks) * 1000);
+        read_cnt += cnt;
+        if (cnt < chunk) {
+            break;
+        }
+    }
+
+    ctx->rx_byte_cnt += read_cnt;
+    return read_cnt;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t of_mdl_master_uart_write(void *uart_userdata, const uint8_t *data, size_t size)
+{
+    of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
+    if (ctx->sim_pid <= 0) {
+        return 0;
+    }
+
+    size_t write_cnt = 0;
+    while (write_cnt < size) {
+        uint16_t chunk = MIN(size - write_cnt, UINT16_MAX);
+        uint8_t hdr[1 + sizeof(chunk)];
+        hdr[0] = OF_MDL_SIM_CMD_WRITE;
+        memcpy(&hdr[1], &chunk, sizeof(chunk));
+        if (!of_mdl_master_uart_sim_send(ctx, hdr, sizeof(hdr)) ||
+            !of_mdl_master_uart_sim_send(ctx, data + write_cnt, chunk)) {
+            break;
+        }
+        write_cnt += chunk;
+    }
+    ctx->tx_byte_cnt += write_cnt;
+    return write_cnt;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_read_timeout_set(void *uart_userdata, uint32_t timeout_ms)
+{
+    of_mdl_master_uart_ctx_t *ctx = (of_mdl_master_uart_ctx_t *)uart_userdata;
+    ctx->rx_timeout_ticks         = pdMS_TO_TICKS(timeout_ms);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_flush_rx_buff(void *uart_userdata)
+{
+    of_mdl_master_uart_rx_flush((of_mdl_master_uart_ctx_t *)uart_userdata);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_mdl_master_uart_wait_tx_done(void *uart_userdata)
+{
+    /* Writes to the pipe complete immediately, the simulator models the transmission time. */
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Start the chain simulator of a chain port with its stdin and stdout connected to pipes.
+ *
+ * @param[inout] uart_ctx UART configuration context.
+ * @param[in] cmd The shell command which starts the simulator.
+ *
+ * @return ESP_OK on success.
+ */
+static esp_err_t of_mdl_master_uart_sim_start(of_mdl_master_uart_ctx_t *uart_ctx, const char *cmd)
+{
+    int tx_pipe[2], rx_pipe[2];
+    ESP_RETURN_ON_FALSE(pipe(tx_pipe) == 0, ESP_FAIL, TAG, "Failed to create TX pipe");
+    if (pipe(rx_pipe) != 0) {
+        close(tx_pipe[0]);
+        close(tx_pipe[1]);
+        ESP_LOGE(TAG, "Failed to create RX pipe");
+        return ESP_FAIL;
+    }
+
+    /* The simulator of the other chain port must not inherit these pipes. */
+    fcntl(tx_pipe[1], F_SETFD, FD_CLOEXEC);
+    fcntl(rx_pipe[0], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(tx_pipe[0], STDIN_FILENO);
+        dup2(rx_pipe[1], STDOUT_FILENO);
+        close(tx_pipe[0]);
+        close(rx_pipe[1]);
+        execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+        _exit(127);
+    }
+
+    close(tx_pipe[0]);
+    close(rx_pipe[1]);
+    if (pid < 0) {
+        close(tx_pipe[1]);
+        close(rx_pipe[0]);
+        ESP_LOGE(TAG, "Failed to start '%s'", cmd);
+        return ESP_FAIL;
+    }
+
+    /* A simulator that stops must not take the controller down with it. */
+    signal(SIGPIPE, SIG_IGN);
+    fcntl(rx_pipe[0], F_SETFL, fcntl(rx_pipe[0], F_GETFL) | O_NONBLOCK);
+
+    uart_ctx->sim_pid   = pid;
+    uart_ctx->sim_tx_fd = tx_pipe[1];
+    uart_ctx->sim_rx_fd = rx_pipe[0];
+
+    ESP_LOGI(TAG, "Chain port %d simulated by '%s'", uart_ctx->chain, cmd);
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Write all bytes to the stdin of the chain simulator.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ * @param[in] data The bytes.
+ * @param[in] size The number of bytes.
+ *
+ * @return true if all bytes have been written.
+ */
+static bool of_mdl_master_uart_sim_send(of_mdl_master_uart_ctx_t *uart_ctx, const void *data, size_t size)
+{
+    const uint8_t *buf = data;
+    while (size) {
+        ssize_t cnt = write(uart_ctx->sim_tx_fd, buf, size);
+        if (cnt > 0) {
+            buf += cnt;
+            size -= cnt;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Read a number of bytes from the stdout of the chain simulator.
+ *
+ * @param[in] uart_ctx UART configuration context.
+ * @param[out] data Buffer for the bytes.
+ * @param[in] size The number of bytes.
+ *
+ * @return true if all bytes have been read, false if the simulator has stopped.
+ */
+static bool of_mdl_master_uart_sim_recv(of_mdl_master_uart_ctx_t *uart_ctx, void *data, size_t size)
+{
+    uint8_t *buf = data;
+    while (size) {
+        ssize_t cnt = read(uart_ctx->sim_rx_fd, buf, size);
+        if (cnt > 0) {
+            buf += cnt;
+            size -= cnt;
+            continue;
+        }
+        if (cnt == 0 || (errno != EAGAIN && errno != EINTR)) {
+            ESP_LOGE(TAG, "Chain simulator %d has stopped", uart_ctx->chain);
+            return false;
+        }
+
+        /* The pipe is non-blocking, blocking system calls would stall the FreeRTOS scheduler. */
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Let the chain simulator run for a read or wait command and take the bytes it returns.
+ *
+ * @param[inout] uart_ctx UART configuration context.
+ * @param[in] cmd #OF_MDL_SIM_CMD_READ or #OF_MDL_SIM_CMD_WAIT.
+ * @param[out] data Buffer for the bytes, may be NULL when size is 0.
+ * @param[in] size The number of bytes to read, at most UINT16_MAX.
+ * @param[in] timeout_us The timeout in virtual time.
+ *
+ * @return The number of bytes read.
+ */
+static size_t of_mdl_master_uart_sim_run(of_mdl_master_uart_ctx_t *uart_ctx, uint8_t cmd, uint8_t *data, size_t size,
+                                         uint32_t timeout_us)
+{
+    if (uart_ctx->sim_pid <= 0) {
+        return 0;
+    }
+
+    uint16_t req_size = size;
+    uint8_t req[1 + sizeof(req_size) + sizeof(timeout_us)];
+    req[0] = cmd;
+    memcpy(&req[1], &req_size, sizeof(req_size));
+    memcpy(&req[1 + sizeof(req_size)], &timeout_us, sizeof(timeout_us));
+    if (!of_mdl_master_uart_sim_send(uart_ctx, req, sizeof(req))) {
+        return 0;
+    }
+
+    uint8_t reply[SIM_REPLY_HDR_LEN];
+    uint16_t cnt = 0;
+    if (!of_mdl_master_uart_sim_recv(uart_ctx, reply, sizeof(reply))) {
+        return 0;
+    }
+    memcpy(&uart_ctx->sim_time_ns, reply, sizeof(uart_ctx->sim_time_ns));
+    memcpy(&cnt, &reply[sizeof(uart_ctx->sim_time_ns)], sizeof(cnt));
+    if (cnt > size || !of_mdl_master_uart_sim_recv(uart_ctx, data, cnt)) {
+        return 0;
+    }
+    return cnt;
+}
@@ -7,9 +7,9 @@
  *
  * \param[in] module The module to get the character index from.
  * \param[out] index The index of the character in the character set.
- * \param[in] character The character to get the index of, this is a 4 byte array to support UTF-8.
+ * \param[in] character The character to get the index of, a string containing a single UTF-8 character.
  *
- * \return ESP_OK if the index of the character has been found.
+ * \return ESP_OK if the index of the character has been found, see #character_set_index_next.
  */
 esp_err_t module_character_set_index_of_character(module_t *module, uint8_t *index, const char *character);
 
@@ -27,6 +27,93 @@ module_t *module_new(void);
  */
 void module_free(module_t *module);
 
+/**
+ * \brief Initialize a module of which the frequently used properties are kept in a shared store.
+ *
+ * \param[in] module The module to initialize.
+ * \param[in] store The store, it must have room for the module.
+ * \param[in] store_idx The index of the module in the store.
+ */
+void module_init(module_t *module, module_store_t *store, uint16_t store_idx);
+
+/**
+ * \brief Free the properties of a module, without freeing the module itself or its store.
+ *
+ * \param[in] module The module to deinitialize.
+ */
+void module_deinit(module_t *module);
+
+/**
+ * \brief Resize the store of the frequently used properties of a number of modules.
+ *
+ * The values of the modules which remain in the store are kept, new entries are set by #module_init.
+ *
+ * \param[in] store The store to resize.
+ * \param[in] size The number of modules in the store. (0 to free the store)
+ *
+ * \retval ESP_OK The store has been resized.
+ * \retval ESP_ERR_INVALID_ARG The store is NULL.
+ * \retval ESP_ERR_NO_MEM The store could not be grown, it still holds the previous modules.
+ */
+esp_err_t module_store_resize(module_store_t *store, uint16_t size);
+
+/**
+ * \brief Get the character index property of a module.
+ *
+ * \param[in] module The module to get the property of.
+ *
+ * \return The index of the character in the character set.
+ */
+character_index_property_t module_character_index_get(const module_t *module);
+
+/**
+ * \brief Set the character index property of a module.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] character_index The index of the character in the character set.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_character_index_set(module_t *module, character_index_property_t character_index);
+
+/**
+ * \brief Get the offset property of a module.
+ *
+ * \param[in] module The module to get the property of.
+ *
+ * \return The offset.
+ */
+offset_property_t module_offset_get(const module_t *module);
+
+/**
+ * \brief Set the offset property of a module.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] offset The offset to set.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_offset_set(module_t *module, offset_property_t offset);
+
+/**
+ * \brief Get the color property of a module.
+ *
+ * \param[in] module The module to get the property of.
+ *
+ * \return The color, valid until the store of the module is resized.
+ */
+const color_property_t *module_color_get(const module_t *module);
+
+/**
+ * \brief Set the color property of a module.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] color The color to set.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_color_set(module_t *module, const color_property_t *color);
+
 /**
  * \brief Set the command property of a module.
  *
@@ -38,3 +125,63 @@ void module_free(module_t *module);
 esp_err_t of_module_command_set(module_t *module, command_property_cmd_t command);
 
 esp_err_t of_module_firmware_update_property_set(module_t *module, uint16_t index, const uint8_t *data);
+
+/**
+ * \brief Set the firmware update property of a module to a compressed firmware page.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] index The index of the page in the firmware.
+ * \param[in] data The page, compressed against the pages before it with #lzss_compress.
+ * \param[in] size The size of the compressed page, smaller than #OF_FIRMWARE_UPDATE_PAGE_SIZE.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_firmware_lz_page_property_set(module_t *module, uint16_t index, const uint8_t *data,
+                                                  uint16_t size);
+
+/**
+ * \brief Select the window of firmware pages reported by the firmware page CRC property of a module.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] region The firmware region, e.g. #OF_FIRMWARE_REGION_NEW_APP.
+ * \param[in] index The index of the first page in the window.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_firmware_page_crc_window_set(module_t *module, uint8_t region, uint16_t index);
+
+/**
+ * \brief Release the firmware page CRC property of a module once the firmware update is done.
+ *
+ * \param[in] module The module to clear the property of.
+ */
+void of_module_firmware_page_crc_clear(module_t *module);
+
+/**
+ * \brief Set the firmware burst property of a module.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] index The index of the first page in the burst.
+ * \param[in] data The pages, each preceded by its size. Must remain valid until the burst has been written.
+ * \param[in] size The size of data.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_firmware_burst_set(module_t *module, uint16_t index, const uint8_t *data, uint16_t size);
+
+/**
+ * \brief Set the largest firmware burst a module accepts.
+ *
+ * \param[in] module The module to set the property of.
+ * \param[in] size_max The largest burst, including the page index.
+ *
+ * \return esp_err_t
+ */
+esp_err_t of_module_firmware_burst_size_max_set(module_t *module, uint16_t size_max);
+
+/**
+ * \brief Release the firmware burst property of a module once the firmware update is done.
+ *
+ * \param[in] module The module to clear the property of.
+ */
+void of_module_firmware_burst_clear(module_t *module);
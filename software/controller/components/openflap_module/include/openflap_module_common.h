@@ -13,6 +13,9 @@ typedef struct {
     /** List of supported characters, 4 bytes will be allocated per character so all UTF-8 characters are supported.  */
     uint8_t *data;
     uint16_t reff_cnt /**< Reference count of this property instance. */;
+    /** Index plus one of every character by its key, see #character_set_index_next. (NULL if not interned) */
+    uint8_t *lookup;
+    uint16_t lookup_mask; /**< Number of lookup entries minus one, the number of entries is a power of two. */
 } character_set_property_t;
 
 /**
@@ -26,14 +29,38 @@ typedef struct {
 /**
  * \brief Firmware update property.
  *
- * Contains one flash page at a time.
+ * Contains one flash page at a time, either as is or compressed.
  */
 typedef struct {
-    uint16_t index; /**< index of the currently contained flash page. */
-    uint8_t *data;  /**< Data in the firmware property.*/
+    uint16_t index;           /**< index of the currently contained flash page. */
+    uint8_t *data;            /**< Data in the firmware property.*/
+    uint16_t compressed_size; /**< Size of the compressed page in data, 0 if data contains the page as is. */
     uint16_t reff_cnt /**< Reference count of this property instance. */;
 } firmware_update_property_t;
 
+/**
+ * \brief Firmware page CRC property.
+ *
+ * Selects a window of firmware pages when written, contains the CRC of each page in the window after a read.
+ */
+typedef struct {
+    uint8_t region;                         /**< Firmware region, e.g. #OF_FIRMWARE_REGION_NEW_APP. */
+    uint16_t index;                         /**< Index of the first page in the window. */
+    uint32_t crc[OF_FIRMWARE_PAGE_CRC_CNT]; /**< CRC of each page in the window. */
+} firmware_page_crc_property_t;
+
+/**
+ * \brief Firmware burst property.
+ *
+ * Contains several consecutive flash pages when written, the largest burst a module accepts after a read.
+ */
+typedef struct {
+    uint16_t size_max;   /**< Largest burst the module accepts, including the page index. */
+    uint16_t index;      /**< Index of the first page in the burst. */
+    const uint8_t *data; /**< The pages, each preceded by its size. Owned by the firmware update, not the module. */
+    uint16_t size;       /**< Size of data. */
+} firmware_burst_property_t;
+
 /** Encoder offset properties. */
 typedef uint8_t offset_property_t;
 
@@ -70,8 +97,35 @@ typedef struct {
 /** Minimum rotation property. */
 typedef uint8_t minimum_rotation_property_t;
 
+/**
+ * \brief Callback to indicate that the content hash of a module property has changed.
+ *
+ * \param[in] userdata The user data registered with the callback.
+ * \param[in] property_id The property of which the hash has changed.
+ * \param[in] old_hash The previous hash of the property. (0 if the property had no value)
+ * \param[in] new_hash The new hash of the property. (0 if the property has no value)
+ */
+typedef void (*module_prop_hash_changed_cb_t)(void *userdata, mdl_prop_id_t property_id, uint32_t old_hash,
+                                              uint32_t new_hash);
+
+/**
+ * \brief The frequently used properties of a number of modules, stored per property in contiguous arrays.
+ *
+ * Iterating over a property of all modules of a chain only touches the array of that property.
+ */
+typedef struct {
+    uint16_t size;                               /**< Number of modules the arrays are allocated for. */
+    character_index_property_t *character_index; /**< Character index property of each module. */
+    offset_property_t *offset;                   /**< Offset property of each module. */
+    color_property_t *color;                     /**< Color property of each module. */
+    /** Indicates witch properties need to be synchronized by writing to actual modules, for each module. */
+    uint64_t *sync_prop_write_required;
+} module_store_t;
+
 /**
  * \brief Module structure.
+ *
+ * The frequently used properties are kept in a #module_store_t, which can be shared by the modules of a chain.
  */
 typedef struct {
     firmware_version_property_t *firmware_version; /**< Firmware version property. */
@@ -80,14 +134,22 @@ typedef struct {
     command_property_cmd_t command;                /**< Command property. */
     bool column_end;                               /**< Column end property. */
     character_set_property_t *character_set;       /**< Character set property. */
-    character_index_property_t character_index;    /**< Current index of the character in the charactermap. */
-    offset_property_t offset;                      /**< offset property. */
-    color_property_t color;                        /**< Color property. */
     motion_property_t motion;                      /**< Motion property. */
     minimum_rotation_property_t minimum_rotation;  /**< Minimum rotation property. */
     ir_threshold_property_t ir_threshold;          /**< IR threshold property. */
-    /** Indicates witch properties need to be synchronized by writing to actual modules. */
-    uint64_t sync_prop_write_required;
+    /** Highest supported baud rate after a read, the requested baud rate for a write. */
+    uint32_t baud_rate;
+    /** Firmware page CRC property, only allocated during a firmware update. */
+    firmware_page_crc_property_t *firmware_page_crc;
+    /** Firmware burst property, only allocated during a firmware update. */
+    firmware_burst_property_t *firmware_burst;
+    module_store_t *store; /**< Store of the character index, offset, color and synchronization flags. */
+    uint16_t store_idx;    /**< Index of the module in the store. */
+    bool store_owned;      /**< The store has been allocated for this module only, see #module_new. */
+    /** Content hash of every property, equal hashes indicate equal properties. (0 if the property has no value) */
+    uint32_t prop_hash[OF_MDL_PROP_CNT];
+    module_prop_hash_changed_cb_t prop_hash_changed_cb; /**< Called when the hash of a property changes. */
+    void *prop_hash_changed_userdata;                   /**< User data of the hash changed callback. */
 } module_t;
 
 //---------------------------------------------------------------------------------------------------------------------
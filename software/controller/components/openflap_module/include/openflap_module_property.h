@@ -42,14 +42,153 @@ bool module_property_is_desynchronized(module_t *module, mdl_prop_id_t property_
 
 //---------------------------------------------------------------------------------------------------------------------
 
+/**
+ * \brief Recalculate the content hash of a property after its value has been changed.
+ *
+ * Every function which changes a property of a module must call this function, the hash changed callback of the
+ * module is called when the hash differs from the previous hash. Modules with equal hashes have equal properties
+ * according to the compare handler of the property. Properties without a compare handler have no hash.
+ *
+ * \param[in] module The module of which the property has been changed.
+ * \param[in] property_id The id of the property that has been changed.
+ */
+void module_property_hash_update(module_t *module, mdl_prop_id_t property_id);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the content hash of a property.
+ *
+ * \param[in] module The module.
+ * \param[in] property_id The id of the property.
+ *
+ * \return The content hash of the property, 0 if the property has no value or the arguments are invalid.
+ */
+uint32_t module_property_hash_get(const module_t *module, mdl_prop_id_t property_id);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Set the callback which is called when the content hash of a property of the module changes.
+ *
+ * \param[in] module The module.
+ * \param[in] cb The callback, NULL to remove the callback.
+ * \param[in] userdata The user data passed to the callback.
+ */
+void module_property_hash_changed_cb_set(module_t *module, module_prop_hash_changed_cb_t cb, void *userdata);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Number of property blobs that have been allocated and shared since boot.
+ *
+ * The firmware version, firmware update and character set properties are blobs which are interned: modules with the
+ * same value share a single blob.
+ */
+typedef struct {
+    uint32_t alloc_cnt;  /**< Number of blobs allocated. */
+    uint32_t free_cnt;   /**< Number of blobs freed. */
+    uint32_t shared_cnt; /**< Number of times an interned blob was shared instead of allocating a new blob. */
+} module_property_blob_stats_t;
+
+/**
+ * \brief Get the allocation statistics of the property blobs.
+ *
+ * \param[out] stats The statistics.
+ */
+void module_property_blob_stats_get(module_property_blob_stats_t *stats);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Allocate a firmware update property which is not shared, its data may be changed by the caller.
+ */
 firmware_update_property_t *firmware_update_new(void);
 
+/**
+ * \brief Get the shared firmware update property containing a firmware page.
+ *
+ * The property is looked up by its content and only allocated when no module holds the same page yet. The returned
+ * property must not be changed and is released with #firmware_update_free.
+ *
+ * \param[in] index The index of the page.
+ * \param[in] data The page, or the compressed page.
+ * \param[in] compressed_size The size of the compressed page, 0 if data contains a page of
+ * #OF_FIRMWARE_UPDATE_PAGE_SIZE as is.
+ *
+ * \return The property, NULL if it could not be allocated.
+ */
+firmware_update_property_t *firmware_update_intern(uint16_t index, const uint8_t *data, uint16_t compressed_size);
+
+/**
+ * \brief Release a reference to a firmware update property, it is freed when it is no longer used.
+ */
 void firmware_update_free(firmware_update_property_t *firmware_update);
 
+/**
+ * \brief Allocate a firmware version property which is not shared, its data may be changed by the caller.
+ */
 firmware_version_property_t *firmware_version_new(size_t size);
 
+/**
+ * \brief Get the shared firmware version property containing a version string.
+ *
+ * \param[in] str The version, not necessarily NUL terminated.
+ * \param[in] size The size of the version.
+ *
+ * \return The property, NULL if it could not be allocated. See #firmware_update_intern.
+ */
+firmware_version_property_t *firmware_version_intern(const char *str, size_t size);
+
+/**
+ * \brief Release a reference to a firmware version property, it is freed when it is no longer used.
+ */
 void firmware_version_free(firmware_version_property_t *firmware_version);
 
+/**
+ * \brief Allocate a character set property which is not shared, its data may be changed by the caller.
+ */
 character_set_property_t *character_set_new(uint8_t size);
 
-void character_set_free(character_set_property_t *character_set);
\ No newline at end of file
+/**
+ * \brief Get the shared character set property containing a character set.
+ *
+ * \param[in] data The characters, 4 bytes per character.
+ * \param[in] size The number of characters.
+ *
+ * \return The property, NULL if it could not be allocated. See #firmware_update_intern.
+ */
+character_set_property_t *character_set_intern(const uint8_t *data, uint8_t size);
+
+/**
+ * \brief Release a reference to a character set property, it is freed when it is no longer used.
+ */
+void character_set_free(character_set_property_t *character_set);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the size of the UTF-8 character at the start of a string.
+ *
+ * \param[in] text The string.
+ *
+ * \return The size of the character in bytes, 0 at the end of the string. Invalid characters are a single byte.
+ */
+size_t character_utf8_size(const char *text);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the index of the next UTF-8 character of a text in a character set.
+ *
+ * Interned character sets are looked up in a hash table, other character sets are searched linearly.
+ *
+ * \param[in] character_set The character set.
+ * \param[inout] text The text, advanced past the character. Also when the character is not in the character set.
+ * \param[out] index The index of the character in the character set.
+ *
+ * \retval ESP_OK The character has been found.
+ * \retval ESP_FAIL The character is not in the character set.
+ * \retval ESP_ERR_INVALID_ARG An argument is NULL, the text is empty or the character set is empty.
+ */
+esp_err_t character_set_index_next(const character_set_property_t *character_set, const char **text, uint8_t *index);
\ No newline at end of file
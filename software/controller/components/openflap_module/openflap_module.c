@@ -10,28 +10,31 @@ esp_err_t module_character_set_index_of_character(module_t *module, uint8_t *ind
 {
     ESP_RETURN_ON_FALSE(index != NULL, ESP_ERR_INVALID_ARG, TAG, "Index is NULL");
     ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
-    ESP_RETURN_ON_FALSE(module->character_set->size > 0, ESP_ERR_INVALID_ARG, TAG, "Character set size is 0");
-    ESP_RETURN_ON_FALSE(module->character_set->data != NULL, ESP_ERR_INVALID_ARG, TAG, "Character set is NULL");
+    ESP_RETURN_ON_FALSE(character != NULL, ESP_ERR_INVALID_ARG, TAG, "Character is NULL");
 
-    for (int i = 0; i < module->character_set->size; i++) {
-        if (strncmp(character, (const char *)&module->character_set->data[i * 4], 4) == 0) {
-            *index = i;
-            return ESP_OK;
-        }
-    }
+    const char *text = character;
+    esp_err_t err    = character_set_index_next(module->character_set, &text, index);
 
-    return ESP_FAIL;
+    /* The character must be the only character of the string. */
+    return (err == ESP_OK && *text != '\0') ? ESP_FAIL : err;
 }
 
 module_t *module_new(void)
 {
-    module_t *module = malloc(sizeof(module_t));
-    if (module == NULL) {
+    module_t *module      = malloc(sizeof(module_t));
+    module_store_t *store = calloc(1, sizeof(module_store_t));
+    if (module == NULL || store == NULL || module_store_resize(store, 1) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to allocate memory for module");
+        if (store != NULL) {
+            module_store_resize(store, 0);
+        }
+        free(module);
+        free(store);
         return NULL;
     }
 
-    memset(module, 0, sizeof(module_t));
+    module_init(module, store, 0);
+    module->store_owned = true;
 
     return module;
 }
@@ -42,12 +45,125 @@ void module_free(module_t *module)
         return;
     }
 
+    module_deinit(module);
+    if (module->store_owned) {
+        module_store_resize(module->store, 0);
+        free(module->store);
+    }
+
+    free(module);
+}
+
+void module_init(module_t *module, module_store_t *store, uint16_t store_idx)
+{
+    assert(module != NULL);
+    assert(store != NULL && store_idx < store->size);
+
+    memset(module, 0, sizeof(module_t));
+    module->store     = store;
+    module->store_idx = store_idx;
+
+    store->character_index[store_idx]          = 0;
+    store->offset[store_idx]                   = 0;
+    store->sync_prop_write_required[store_idx] = 0;
+    memset(&store->color[store_idx], 0, sizeof(color_property_t));
+}
+
+void module_deinit(module_t *module)
+{
+    if (module == NULL) {
+        return;
+    }
+
     /* Free all properties. */
     firmware_version_free(module->firmware_version);
     firmware_update_free(module->firmware_update);
     character_set_free(module->character_set);
+    free(module->firmware_page_crc);
+    free(module->firmware_burst);
+}
 
-    free(module);
+esp_err_t module_store_resize(module_store_t *store, uint16_t size)
+{
+    ESP_RETURN_ON_FALSE(store != NULL, ESP_ERR_INVALID_ARG, TAG, "Store is NULL");
+
+    if (size == 0) {
+        free(store->character_index);
+        free(store->offset);
+        free(store->color);
+        free(store->sync_prop_write_required);
+        memset(store, 0, sizeof(module_store_t));
+        return ESP_OK;
+    }
+
+    /* Every array is only replaced once it has been reallocated, so a failure leaves a smaller store intact. */
+    character_index_property_t *character_index = realloc(store->character_index, size * sizeof(*character_index));
+    if (character_index != NULL) {
+        store->character_index = character_index;
+    }
+    offset_property_t *offset = realloc(store->offset, size * sizeof(*offset));
+    if (offset != NULL) {
+        store->offset = offset;
+    }
+    color_property_t *color = realloc(store->color, size * sizeof(*color));
+    if (color != NULL) {
+        store->color = color;
+    }
+    uint64_t *sync_prop_write_required = realloc(store->sync_prop_write_required, size * sizeof(uint64_t));
+    if (sync_prop_write_required != NULL) {
+        store->sync_prop_write_required = sync_prop_write_required;
+    }
+    ESP_RETURN_ON_FALSE(character_index != NULL && offset != NULL && color != NULL && sync_prop_write_required != NULL,
+                        ESP_ERR_NO_MEM, TAG, "Failed to allocate memory for the module store");
+
+    store->size = size;
+    return ESP_OK;
+}
+
+character_index_property_t module_character_index_get(const module_t *module)
+{
+    return module->store->character_index[module->store_idx];
+}
+
+esp_err_t of_module_character_index_set(module_t *module, character_index_property_t character_index)
+{
+    ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
+
+    module->store->character_index[module->store_idx] = character_index;
+    module_property_hash_update(module, OF_MDL_PROP_CHARACTER);
+
+    return ESP_OK;
+}
+
+offset_property_t module_offset_get(const module_t *module)
+{
+    return module->store->offset[module->store_idx];
+}
+
+esp_err_t of_module_offset_set(module_t *module, offset_property_t offset)
+{
+    ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
+
+    module->store->offset[module->store_idx] = offset;
+    module_property_hash_update(module, OF_MDL_PROP_OFFSET);
+
+    return ESP_OK;
+}
+
+const color_property_t *module_color_get(const module_t *module)
+{
+    return &module->store->color[module->store_idx];
+}
+
+esp_err_t of_module_color_set(module_t *module, const color_property_t *color)
+{
+    ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
+    ESP_RETURN_ON_FALSE(color != NULL, ESP_ERR_INVALID_ARG, TAG, "Color is NULL");
+
+    module->store->color[module->store_idx] = *color;
+    module_property_hash_update(module, OF_MDL_PROP_COLOR);
+
+    return ESP_OK;
 }
 
 esp_err_t of_module_command_set(module_t *module, command_property_cmd_t command)
@@ -55,6 +171,7 @@ esp_err_t of_module_command_set(module_t *module, command_property_cmd_t command
     ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
 
     module->command = command;
+    module_property_hash_update(module, OF_MDL_PROP_COMMAND);
 
     return ESP_OK;
 }
@@ -66,19 +183,135 @@ esp_err_t of_module_firmware_update_property_set(module_t *module, uint16_t inde
     assert(module != NULL);
     assert(data != NULL);
 
-    /* Create new firmware update property. */
-    firmware_update_property_t *new_firmware_update = firmware_update_new();
+    /* Get the firmware update property, the page is shared with the other modules which receive it. */
+    firmware_update_property_t *new_firmware_update = firmware_update_intern(index, data, 0);
     ESP_RETURN_ON_FALSE(new_firmware_update != NULL, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory");
 
-    /* Free the old data. */
+    /* Release the old page. */
     firmware_update_free(module->firmware_update);
 
     /* Update the module with the new firmware update. */
     module->firmware_update = new_firmware_update;
 
-    /* Set the data. */
-    module->firmware_update->index = index;
-    memcpy(module->firmware_update->data, data, OF_FIRMWARE_UPDATE_PAGE_SIZE);
+    /* Both firmware page properties are served from the firmware update property. */
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_UPDATE);
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_LZ_PAGE);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_module_firmware_lz_page_property_set(module_t *module, uint16_t index, const uint8_t *data,
+                                                  uint16_t size)
+{
+    assert(module != NULL);
+    assert(data != NULL);
+    ESP_RETURN_ON_FALSE(size > 0 && size < OF_FIRMWARE_UPDATE_PAGE_SIZE, ESP_ERR_INVALID_SIZE, TAG,
+                        "Invalid compressed page size");
+
+    /* Get the firmware update property, the remainder of the page is zero. */
+    firmware_update_property_t *new_firmware_update = firmware_update_intern(index, data, size);
+    ESP_RETURN_ON_FALSE(new_firmware_update != NULL, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory");
+
+    /* Release the old page. */
+    firmware_update_free(module->firmware_update);
+
+    /* Update the module with the new firmware update. */
+    module->firmware_update = new_firmware_update;
+
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_UPDATE);
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_LZ_PAGE);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_module_firmware_page_crc_window_set(module_t *module, uint8_t region, uint16_t index)
+{
+    ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
+
+    if (module->firmware_page_crc == NULL) {
+        module->firmware_page_crc = calloc(1, sizeof(firmware_page_crc_property_t));
+        ESP_RETURN_ON_FALSE(module->firmware_page_crc != NULL, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory");
+    }
+
+    module->firmware_page_crc->region = region;
+    module->firmware_page_crc->index  = index;
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_PAGE_CRC);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void of_module_firmware_page_crc_clear(module_t *module)
+{
+    if (module == NULL) {
+        return;
+    }
+
+    free(module->firmware_page_crc);
+    module->firmware_page_crc = NULL;
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_PAGE_CRC);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Allocate the firmware burst property of a module when it doesn't have one yet.
+ *
+ * \param[in] module The module.
+ *
+ * \return esp_err_t
+ */
+static esp_err_t of_module_firmware_burst_alloc(module_t *module)
+{
+    ESP_RETURN_ON_FALSE(module != NULL, ESP_ERR_INVALID_ARG, TAG, "Module is NULL");
+
+    if (module->firmware_burst == NULL) {
+        module->firmware_burst = calloc(1, sizeof(firmware_burst_property_t));
+        ESP_RETURN_ON_FALSE(module->firmware_burst != NULL, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory");
+    }
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_module_firmware_burst_set(module_t *module, uint16_t index, const uint8_t *data, uint16_t size)
+{
+    ESP_RETURN_ON_ERROR(of_module_firmware_burst_alloc(module), TAG, "Failed to allocate firmware burst");
+
+    module->firmware_burst->index = index;
+    module->firmware_burst->data  = data;
+    module->firmware_burst->size  = size;
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_BURST);
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+esp_err_t of_module_firmware_burst_size_max_set(module_t *module, uint16_t size_max)
+{
+    ESP_RETURN_ON_ERROR(of_module_firmware_burst_alloc(module), TAG, "Failed to allocate firmware burst");
+
+    module->firmware_burst->size_max = size_max;
+
+    return ESP_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void of_module_firmware_burst_clear(module_t *module)
+{
+    if (module == NULL) {
+        return;
+    }
+
+    free(module->firmware_burst);
+    module->firmware_burst = NULL;
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_BURST);
+}
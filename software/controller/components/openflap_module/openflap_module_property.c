@@ -3,10 +3,71 @@
 #include "esp_log.h"
 #include "openflap_module.h"
 
+#include <pthread.h>
 #include <string.h>
 
 #define TAG "MODULE_PROPERTY"
 
+/** FNV-1a offset basis and prime, used for the content hash of the properties. */
+#define MODULE_HASH_FNV_OFFSET (2166136261UL)
+#define MODULE_HASH_FNV_PRIME  (16777619UL)
+
+/** Smallest number of entries of a character set lookup table. */
+#define CHARACTER_SET_LOOKUP_SIZE_MIN (16)
+
+/** Initial number of entries of a blob pool. */
+#define MODULE_BLOB_POOL_SIZE_MIN (4)
+
+/**
+ * \brief The content of a blob, used to look up an interned blob.
+ */
+typedef struct {
+    const void *data;         /**< The data of the blob. */
+    size_t size;              /**< Size of the data. */
+    uint16_t index;           /**< Page index, firmware update only. */
+    uint16_t compressed_size; /**< Compressed size, firmware update only. */
+} module_blob_content_t;
+
+/**
+ * \brief An interned blob, shared by all modules with the same property value.
+ */
+typedef struct {
+    void *blob;         /**< The blob, it is never changed while it is interned. */
+    uint16_t *reff_cnt; /**< Reference count of the blob. */
+    uint32_t hash;      /**< Hash of the content of the blob. */
+    size_t size;        /**< Size of the content of the blob. */
+} module_blob_pool_entry_t;
+
+/**
+ * \brief The interned blobs of a property type.
+ *
+ * Only a few distinct values are live at a time, e.g. one character set or firmware page for all modules, so the
+ * entries are searched linearly.
+ */
+typedef struct {
+    module_blob_pool_entry_t *entries; /**< The interned blobs. */
+    uint16_t cnt;                      /**< Number of interned blobs. */
+    uint16_t size;                     /**< Number of allocated entries. */
+} module_blob_pool_t;
+
+/** Compares the content of an interned blob to the content of a blob to look up. */
+typedef bool (*module_blob_equal_t)(const void *blob, const void *content);
+
+static module_blob_pool_t firmware_version_pool;
+static module_blob_pool_t firmware_update_pool;
+static module_blob_pool_t character_set_pool;
+static module_property_blob_stats_t module_blob_stats;
+/** Protects the pools, the reference counts and the statistics. The chains are synchronized in parallel, so the
+ * property handlers of different chains share blobs from different tasks. A pthread mutex can be initialized
+ * statically, on the target as well as on the linux host. */
+static pthread_mutex_t module_blob_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t module_hash_add(uint32_t hash, const void *data, size_t size);
+static uint32_t module_property_hash_calc(const module_t *module, mdl_prop_id_t property_id);
+static uint32_t character_key(const char *character, size_t size);
+static uint16_t character_key_hash(uint32_t key);
+static void character_set_lookup_build(character_set_property_t *character_set);
+
 esp_err_t module_property_indicate_desynchronized(module_t *module, mdl_prop_id_t property_id)
 {
     /* Validate inputs. */
@@ -14,7 +75,7 @@ esp_err_t module_property_indicate_desynchronized(module_t *module, mdl_prop_id_
     ESP_RETURN_ON_FALSE(property_id < OF_MDL_PROP_CNT, ESP_ERR_INVALID_ARG, TAG, "Invalid property id");
 
     /* Indicate that the property has been desynchronized. */
-    module->sync_prop_write_required |= (1 << property_id);
+    module->store->sync_prop_write_required[module->store_idx] |= (1ULL << property_id);
 
     return ESP_OK;
 }
@@ -28,7 +89,7 @@ esp_err_t module_property_indicate_synchronized(module_t *module, mdl_prop_id_t
     ESP_RETURN_ON_FALSE(property_id < OF_MDL_PROP_CNT, ESP_ERR_INVALID_ARG, TAG, "Invalid property id");
 
     /* Indicate that the property has been synchronized. */
-    module->sync_prop_write_required &= ~(1 << property_id);
+    module->store->sync_prop_write_required[module->store_idx] &= ~(1ULL << property_id);
 
     return ESP_OK;
 }
@@ -48,7 +109,179 @@ bool module_property_is_desynchronized(module_t *module, mdl_prop_id_t property_
         return false;
     }
 
-    return (module->sync_prop_write_required & (1 << property_id));
+    return (module->store->sync_prop_write_required[module->store_idx] & (1ULL << property_id));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void module_property_hash_update(module_t *module, mdl_prop_id_t property_id)
+{
+    if (module == NULL || property_id >= OF_MDL_PROP_CNT) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return;
+    }
+
+    uint32_t old_hash = module->prop_hash[property_id];
+    uint32_t new_hash = module_property_hash_calc(module, property_id);
+    if (new_hash == old_hash) {
+        return;
+    }
+
+    module->prop_hash[property_id] = new_hash;
+    if (module->prop_hash_changed_cb != NULL) {
+        module->prop_hash_changed_cb(module->prop_hash_changed_userdata, property_id, old_hash, new_hash);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t module_property_hash_get(const module_t *module, mdl_prop_id_t property_id)
+{
+    if (module == NULL || property_id >= OF_MDL_PROP_CNT) {
+        return 0;
+    }
+    return module->prop_hash[property_id];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void module_property_hash_changed_cb_set(module_t *module, module_prop_hash_changed_cb_t cb, void *userdata)
+{
+    if (module == NULL) {
+        return;
+    }
+    module->prop_hash_changed_cb       = cb;
+    module->prop_hash_changed_userdata = userdata;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Find an interned blob with the given content.
+ *
+ * \param[in] pool The pool of the property type.
+ * \param[in] hash The hash of the content.
+ * \param[in] size The size of the content.
+ * \param[in] equal Compares the content of a blob of the pool to the content.
+ * \param[in] content The content, passed to equal.
+ *
+ * \return The blob with its reference count increased, NULL if there is no blob with this content.
+ */
+static void *module_blob_pool_get(module_blob_pool_t *pool, uint32_t hash, size_t size, module_blob_equal_t equal,
+                                  const void *content)
+{
+    void *blob = NULL;
+
+    pthread_mutex_lock(&module_blob_lock);
+    for (uint16_t i = 0; i < pool->cnt; i++) {
+        module_blob_pool_entry_t *entry = &pool->entries[i];
+        if (entry->hash == hash && entry->size == size && equal(entry->blob, content)) {
+            blob = entry->blob;
+            (*entry->reff_cnt)++;
+            module_blob_stats.shared_cnt++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&module_blob_lock);
+
+    return blob;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Add a new blob to a pool, so it is shared by the next modules with the same content.
+ *
+ * A blob which can't be added is still valid, it is just not shared.
+ *
+ * \param[in] pool The pool of the property type.
+ * \param[in] blob The blob, it must not be changed anymore.
+ * \param[in] reff_cnt The reference count of the blob.
+ * \param[in] hash The hash of the content.
+ * \param[in] size The size of the content.
+ */
+static void module_blob_pool_add(module_blob_pool_t *pool, void *blob, uint16_t *reff_cnt, uint32_t hash, size_t size)
+{
+    pthread_mutex_lock(&module_blob_lock);
+    if (pool->cnt == pool->size) {
+        uint16_t new_size                 = pool->size ? pool->size * 2 : MODULE_BLOB_POOL_SIZE_MIN;
+        module_blob_pool_entry_t *entries = realloc(pool->entries, new_size * sizeof(module_blob_pool_entry_t));
+        if (entries == NULL) {
+            pthread_mutex_unlock(&module_blob_lock);
+            ESP_LOGW(TAG, "Failed to grow the blob pool, the blob is not shared");
+            return;
+        }
+        pool->entries = entries;
+        pool->size    = new_size;
+    }
+    pool->entries[pool->cnt++] = (module_blob_pool_entry_t){
+        .blob     = blob,
+        .reff_cnt = reff_cnt,
+        .hash     = hash,
+        .size     = size,
+    };
+    pthread_mutex_unlock(&module_blob_lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Release a reference to a blob.
+ *
+ * \param[in] pool The pool of the property type.
+ * \param[in] blob The blob.
+ * \param[in] reff_cnt The reference count of the blob.
+ *
+ * \retval true This was the last reference, the blob has been removed from the pool and must be freed.
+ * \retval false The blob is still used.
+ */
+static bool module_blob_release(module_blob_pool_t *pool, void *blob, uint16_t *reff_cnt)
+{
+    bool last = false;
+
+    pthread_mutex_lock(&module_blob_lock);
+    if (*reff_cnt > 1) {
+        (*reff_cnt)--;
+    } else {
+        last = true;
+        module_blob_stats.free_cnt++;
+        for (uint16_t i = 0; i < pool->cnt; i++) {
+            if (pool->entries[i].blob == blob) {
+                pool->entries[i] = pool->entries[--pool->cnt];
+                break;
+            }
+        }
+        /* Release the pool once it is empty, the pools are only used while modules exist. */
+        if (pool->cnt == 0) {
+            free(pool->entries);
+            pool->entries = NULL;
+            pool->size    = 0;
+        }
+    }
+    pthread_mutex_unlock(&module_blob_lock);
+
+    return last;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/** Count the allocation of a new blob. */
+static void module_blob_alloc_count(void)
+{
+    pthread_mutex_lock(&module_blob_lock);
+    module_blob_stats.alloc_cnt++;
+    pthread_mutex_unlock(&module_blob_lock);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+void module_property_blob_stats_get(module_property_blob_stats_t *stats)
+{
+    assert(stats != NULL);
+
+    pthread_mutex_lock(&module_blob_lock);
+    *stats = module_blob_stats;
+    pthread_mutex_unlock(&module_blob_lock);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -71,6 +304,40 @@ firmware_version_property_t *firmware_version_new(size_t size)
         return NULL;
     }
 
+    module_blob_alloc_count();
+    return firmware_version;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/** Compare an interned firmware version to a version string, see #module_blob_equal_t. */
+static bool firmware_version_equal(const void *blob, const void *content)
+{
+    const firmware_version_property_t *firmware_version = blob;
+    const module_blob_content_t *version                = content;
+    return memcmp(firmware_version->str, version->data, version->size) == 0;
+}
+
+firmware_version_property_t *firmware_version_intern(const char *str, size_t size)
+{
+    assert(str != NULL);
+
+    module_blob_content_t content = {.data = str, .size = size};
+    uint32_t hash                 = module_hash_add(MODULE_HASH_FNV_OFFSET, str, size);
+
+    firmware_version_property_t *firmware_version =
+        module_blob_pool_get(&firmware_version_pool, hash, size, firmware_version_equal, &content);
+    if (firmware_version != NULL) {
+        return firmware_version;
+    }
+
+    firmware_version = firmware_version_new(size);
+    if (firmware_version == NULL) {
+        return NULL;
+    }
+    memcpy(firmware_version->str, str, size);
+    module_blob_pool_add(&firmware_version_pool, firmware_version, &firmware_version->reff_cnt, hash, size);
+
     return firmware_version;
 }
 
@@ -84,8 +351,7 @@ void firmware_version_free(firmware_version_property_t *firmware_version)
     }
 
     /* Reduce reference count. */
-    if (firmware_version->reff_cnt > 1) {
-        firmware_version->reff_cnt--;
+    if (!module_blob_release(&firmware_version_pool, firmware_version, &firmware_version->reff_cnt)) {
         return;
     }
 
@@ -105,7 +371,8 @@ firmware_update_property_t *firmware_update_new(void)
     }
 
     /* Initialize the reference count. */
-    firmware_update->reff_cnt = 1;
+    firmware_update->reff_cnt        = 1;
+    firmware_update->compressed_size = 0;
 
     /* Allocate the data. */
     uint16_t size         = OF_FIRMWARE_UPDATE_PAGE_SIZE;
@@ -115,6 +382,47 @@ firmware_update_property_t *firmware_update_new(void)
         return NULL;
     }
 
+    module_blob_alloc_count();
+    return firmware_update;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/** Compare an interned firmware update to a firmware page, see #module_blob_equal_t. */
+static bool firmware_update_equal(const void *blob, const void *content)
+{
+    const firmware_update_property_t *firmware_update = blob;
+    const module_blob_content_t *page                 = content;
+    return firmware_update->index == page->index && firmware_update->compressed_size == page->compressed_size &&
+           memcmp(firmware_update->data, page->data, page->size) == 0;
+}
+
+firmware_update_property_t *firmware_update_intern(uint16_t index, const uint8_t *data, uint16_t compressed_size)
+{
+    assert(data != NULL);
+    assert(compressed_size < OF_FIRMWARE_UPDATE_PAGE_SIZE);
+
+    /* The remainder of a compressed page is zero, so only the compressed data has to be compared. */
+    size_t size                   = compressed_size ? compressed_size : OF_FIRMWARE_UPDATE_PAGE_SIZE;
+    module_blob_content_t content = {.data = data, .size = size, .index = index, .compressed_size = compressed_size};
+    uint32_t hash                 = module_hash_add(MODULE_HASH_FNV_OFFSET, &index, sizeof(index));
+    hash                          = module_hash_add(hash, data, size);
+
+    firmware_update_property_t *firmware_update =
+        module_blob_pool_get(&firmware_update_pool, hash, size, firmware_update_equal, &content);
+    if (firmware_update != NULL) {
+        return firmware_update;
+    }
+
+    firmware_update = firmware_update_new();
+    if (firmware_update == NULL) {
+        return NULL;
+    }
+    firmware_update->index           = index;
+    firmware_update->compressed_size = compressed_size;
+    memcpy(firmware_update->data, data, size);
+    module_blob_pool_add(&firmware_update_pool, firmware_update, &firmware_update->reff_cnt, hash, size);
+
     return firmware_update;
 }
 
@@ -128,8 +436,7 @@ void firmware_update_free(firmware_update_property_t *firmware_update)
     }
 
     /* Reduce reference count. */
-    if (firmware_update->reff_cnt > 1) {
-        firmware_update->reff_cnt--;
+    if (!module_blob_release(&firmware_update_pool, firmware_update, &firmware_update->reff_cnt)) {
         return;
     }
 
@@ -151,14 +458,51 @@ character_set_property_t *character_set_new(uint8_t size)
     /* Initialize the reference count. */
     character_set->reff_cnt = 1;
 
-    /* Allocate the data. */
-    character_set->size = size;
-    character_set->data = calloc(size, 4);
+    /* Allocate the data, the lookup table is only built for interned character sets. */
+    character_set->lookup      = NULL;
+    character_set->lookup_mask = 0;
+    character_set->size        = size;
+    character_set->data        = calloc(size, 4);
     if (character_set->data == NULL) {
         free(character_set);
         return NULL;
     }
 
+    module_blob_alloc_count();
+    return character_set;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/** Compare an interned character set to character set data, see #module_blob_equal_t. */
+static bool character_set_equal(const void *blob, const void *content)
+{
+    const character_set_property_t *character_set = blob;
+    const module_blob_content_t *characters       = content;
+    return memcmp(character_set->data, characters->data, characters->size) == 0;
+}
+
+character_set_property_t *character_set_intern(const uint8_t *data, uint8_t size)
+{
+    assert(data != NULL || size == 0);
+
+    module_blob_content_t content = {.data = data, .size = size * 4};
+    uint32_t hash                 = module_hash_add(MODULE_HASH_FNV_OFFSET, data, content.size);
+
+    character_set_property_t *character_set =
+        module_blob_pool_get(&character_set_pool, hash, content.size, character_set_equal, &content);
+    if (character_set != NULL) {
+        return character_set;
+    }
+
+    character_set = character_set_new(size);
+    if (character_set == NULL) {
+        return NULL;
+    }
+    memcpy(character_set->data, data, content.size);
+    character_set_lookup_build(character_set);
+    module_blob_pool_add(&character_set_pool, character_set, &character_set->reff_cnt, hash, content.size);
+
     return character_set;
 }
 
@@ -172,12 +516,251 @@ void character_set_free(character_set_property_t *character_set)
     }
 
     /* Reduce reference count. */
-    if (character_set->reff_cnt > 1) {
-        character_set->reff_cnt--;
+    if (!module_blob_release(&character_set_pool, character_set, &character_set->reff_cnt)) {
         return;
     }
 
     /* Free the data when count reaches 0. */
+    free(character_set->lookup);
     free(character_set->data);
     free(character_set);
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+esp_err_t character_set_index_next(const character_set_property_t *character_set, const char **text, uint8_t *index)
+{
+    ESP_RETURN_ON_FALSE(text != NULL && *text != NULL && index != NULL, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(**text != '\0', ESP_ERR_INVALID_ARG, TAG, "No character left in text");
+    ESP_RETURN_ON_FALSE(character_set != NULL && character_set->size > 0 && character_set->data != NULL,
+                        ESP_ERR_INVALID_ARG, TAG, "Character set is empty");
+
+    /* Consume a single UTF-8 character. */
+    size_t size  = character_utf8_size(*text);
+    uint32_t key = character_key(*text, size);
+    *text += size;
+
+    /* Character sets which are not interned are searched linearly. */
+    if (character_set->lookup == NULL) {
+        for (uint16_t i = 0; i < character_set->size; i++) {
+            if (character_key((const char *)&character_set->data[i * 4], 4) == key) {
+                *index = i;
+                return ESP_OK;
+            }
+        }
+        return ESP_FAIL;
+    }
+
+    for (uint16_t slot = character_key_hash(key) & character_set->lookup_mask;;
+         slot = (slot + 1) & character_set->lookup_mask) {
+        uint8_t entry = character_set->lookup[slot];
+        if (entry == 0) {
+            return ESP_FAIL;
+        }
+        if (character_key((const char *)&character_set->data[(entry - 1) * 4], 4) == key) {
+            *index = entry - 1;
+            return ESP_OK;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+size_t character_utf8_size(const char *text)
+{
+    uint8_t lead = (uint8_t)text[0];
+    size_t size  = 1;
+    if ((lead & 0xE0) == 0xC0) {
+        size = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+        size = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+        size = 4;
+    }
+
+    /* Don't run past the end of a truncated string. */
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] == '\0') {
+            return i;
+        }
+    }
+    return size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the key of a character, its bytes up to the first NUL as a little endian 32 bit value.
+ *
+ * \param[in] character The character.
+ * \param[in] size The maximum size of the character, at most 4 bytes.
+ *
+ * \return The key of the character.
+ */
+static uint32_t character_key(const char *character, size_t size)
+{
+    uint32_t key = 0;
+    for (size_t i = 0; i < size && i < 4 && character[i] != '\0'; i++) {
+        key |= (uint32_t)(uint8_t)character[i] << (i * 8);
+    }
+    return key;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Get the slot of a character key in the lookup table, before it is masked to the size of the table.
+ */
+static uint16_t character_key_hash(uint32_t key)
+{
+    /* Fibonacci hashing, the upper bits of the product depend on all bits of the key. */
+    return (uint16_t)((key * 2654435761UL) >> 16);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Build the lookup table of an interned character set.
+ *
+ * The table is at most half full, so a lookup rarely visits more than one or two entries. A character which occurs
+ * more than once is found at its first index. Without a table the character set is searched linearly.
+ *
+ * \param[inout] character_set The character set.
+ */
+static void character_set_lookup_build(character_set_property_t *character_set)
+{
+    uint16_t lookup_size = CHARACTER_SET_LOOKUP_SIZE_MIN;
+    while (lookup_size < character_set->size * 2) {
+        lookup_size *= 2;
+    }
+
+    character_set->lookup = calloc(lookup_size, sizeof(uint8_t));
+    if (character_set->lookup == NULL) {
+        ESP_LOGW(TAG, "Failed to allocate the character set lookup table");
+        return;
+    }
+    character_set->lookup_mask = lookup_size - 1;
+
+    for (uint16_t i = 0; i < character_set->size; i++) {
+        uint32_t key = character_key((const char *)&character_set->data[i * 4], 4);
+        for (uint16_t slot = character_key_hash(key) & character_set->lookup_mask;;
+             slot = (slot + 1) & character_set->lookup_mask) {
+            uint8_t entry = character_set->lookup[slot];
+            if (entry == 0) {
+                character_set->lookup[slot] = i + 1;
+                break;
+            }
+            if (character_key((const char *)&character_set->data[(entry - 1) * 4], 4) == key) {
+                break;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Add data to an FNV-1a hash.
+ *
+ * \param[in] hash The hash so far.
+ * \param[in] data The data to add.
+ * \param[in] size The size of the data.
+ *
+ * \return The new hash.
+ */
+static uint32_t module_hash_add(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * MODULE_HASH_FNV_PRIME;
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Calculate the content hash of a property.
+ *
+ * Only the fields which are checked by the compare handler of the property are hashed. A property without a value is
+ * never equal to another property, so it has no hash.
+ *
+ * \param[in] module The module.
+ * \param[in] property_id The id of the property.
+ *
+ * \return The content hash, 0 if the property has no value or no compare handler.
+ */
+static uint32_t module_property_hash_calc(const module_t *module, mdl_prop_id_t property_id)
+{
+    uint32_t hash = MODULE_HASH_FNV_OFFSET;
+
+    switch (property_id) {
+        case OF_MDL_PROP_FIRMWARE_VERSION:
+            if (module->firmware_version == NULL) {
+                return 0;
+            }
+            hash = module_hash_add(hash, module->firmware_version->str, strlen(module->firmware_version->str));
+            break;
+        case OF_MDL_PROP_FIRMWARE_UPDATE:
+        case OF_MDL_PROP_FIRMWARE_LZ_PAGE:
+            if (module->firmware_update == NULL) {
+                return 0;
+            }
+            hash = module_hash_add(hash, &module->firmware_update->index, sizeof(module->firmware_update->index));
+            hash = module_hash_add(hash, &module->firmware_update->compressed_size,
+                                   sizeof(module->firmware_update->compressed_size));
+            hash = module_hash_add(hash, module->firmware_update->data, OF_FIRMWARE_UPDATE_PAGE_SIZE);
+            break;
+        case OF_MDL_PROP_COMMAND:
+            hash = module_hash_add(hash, &module->command, sizeof(module->command));
+            break;
+        case OF_MDL_PROP_CHARACTER_SET:
+            if (module->character_set == NULL) {
+                return 0;
+            }
+            hash = module_hash_add(hash, &module->character_set->size, sizeof(module->character_set->size));
+            hash = module_hash_add(hash, module->character_set->data, module->character_set->size * 4);
+            break;
+        case OF_MDL_PROP_CHARACTER:
+            hash = module_hash_add(hash, &module->store->character_index[module->store_idx],
+                                   sizeof(character_index_property_t));
+            break;
+        case OF_MDL_PROP_OFFSET:
+            hash = module_hash_add(hash, &module->store->offset[module->store_idx], sizeof(offset_property_t));
+            break;
+        case OF_MDL_PROP_COLOR:
+            hash = module_hash_add(hash, &module->store->color[module->store_idx], sizeof(color_property_t));
+            break;
+        case OF_MDL_PROP_MOTION:
+            hash = module_hash_add(hash, &module->motion, sizeof(module->motion));
+            break;
+        case OF_MDL_PROP_MINIMUM_ROTATION:
+            hash = module_hash_add(hash, &module->minimum_rotation, sizeof(module->minimum_rotation));
+            break;
+        case OF_MDL_PROP_IR_THRESHOLD:
+            hash = module_hash_add(hash, &module->ir_threshold, sizeof(module->ir_threshold));
+            break;
+        case OF_MDL_PROP_FIRMWARE_PAGE_CRC:
+            if (module->firmware_page_crc == NULL) {
+                return 0;
+            }
+            hash = module_hash_add(hash, &module->firmware_page_crc->region, sizeof(module->firmware_page_crc->region));
+            hash = module_hash_add(hash, &module->firmware_page_crc->index, sizeof(module->firmware_page_crc->index));
+            break;
+        case OF_MDL_PROP_FIRMWARE_BURST:
+            if (module->firmware_burst == NULL || module->firmware_burst->data == NULL) {
+                return 0;
+            }
+            /* The bursts of all modules share the buffer of the firmware update, hashing its address avoids hashing a
+             * large burst for every module. Equal bursts in different buffers are not detected. */
+            hash = module_hash_add(hash, &module->firmware_burst->index, sizeof(module->firmware_burst->index));
+            hash = module_hash_add(hash, &module->firmware_burst->size, sizeof(module->firmware_burst->size));
+            hash = module_hash_add(hash, &module->firmware_burst->data, sizeof(module->firmware_burst->data));
+            break;
+        default:
+            return 0; /* No compare handler. */
+    }
+
+    /* 0 is reserved for properties without a value. */
+    return hash ? hash : 1;
+}
@@ -1,6 +1,8 @@
 #include "openflap_property_handlers.h"
 #include "esp_check.h"
 
+#include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 //======================================================================================================================
@@ -29,8 +31,8 @@ static esp_err_t json_to_color(color_t *color, const cJSON *json);
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -41,24 +43,22 @@ bool firmware_version_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf,
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
-    /* Create new firmware version property. */
-    firmware_version_property_t *new_firmware_version = firmware_version_new(*size - 4);
+    /* Get the firmware version property, modules with the same firmware share it. */
+    firmware_version_property_t *new_firmware_version = firmware_version_intern((const char *)buf, *size - 4);
     ESP_RETURN_ON_FALSE(new_firmware_version != NULL, false, TAG, "Failed to allocate memory");
 
-    /* Free the old data. */
+    /* Release the old data. */
     firmware_version_free(module->firmware_version);
 
     /* Update the module with the new firmware version. */
     module->firmware_version = new_firmware_version;
 
-    /* Copy the binary array to the firmware version. */
-    memcpy(module->firmware_version->str, buf, *size - 4);
-
     /* Read the CRC from the last 4 bytes of the binary array. */
     module->firmware_crc = 0;
     for (size_t i = 0; i < 4; i++) {
         module->firmware_crc |= (uint32_t)buf[*size - 4 + i] << (i * 8);
     }
+    module_property_hash_update(module, OF_MDL_PROP_FIRMWARE_VERSION);
 
     return true;
 }
@@ -84,7 +84,7 @@ bool firmware_version_to_json(void *userdata, uint16_t node_idx, void *data)
                         TAG, "Failed to create JSON string");
 
     char crc_str[9] = {0};
-    snprintf(crc_str, sizeof(crc_str), "%08lX", module->firmware_crc);
+    snprintf(crc_str, sizeof(crc_str), "%08" PRIX32, module->firmware_crc);
     ESP_RETURN_ON_FALSE(cJSON_AddStringToObject(*json, "crc", crc_str) != NULL, false, TAG,
                         "Failed to create JSON string");
 
@@ -129,8 +129,8 @@ bool firmware_version_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -138,9 +138,14 @@ bool firmware_version_compare(const void *userdata_a, const void *userdata_b)
  */
 bool firmware_update_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_FIRMWARE_UPDATE, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
+    ESP_RETURN_ON_FALSE(module->firmware_update->compressed_size == 0, false, TAG, "Firmware page is compressed");
+
     *size = OF_FIRMWARE_UPDATE_PAGE_SIZE + 2; /* 2 bytes for index */
 
     /* Copy the index and firmware page to the binary array. */
@@ -179,7 +184,7 @@ bool firmware_update_compare(const void *userdata_a, const void *userdata_b)
     }
 
     /* Check if the sizes are the same. */
-    if (firmware_a->index != firmware_b->index) {
+    if (firmware_a->index != firmware_b->index || firmware_a->compressed_size != firmware_b->compressed_size) {
         return false;
     }
 
@@ -187,6 +192,39 @@ bool firmware_update_compare(const void *userdata_a, const void *userdata_b)
     return memcmp(firmware_a->data, firmware_b->data, OF_FIRMWARE_UPDATE_PAGE_SIZE) == 0;
 }
 
+//======================================================================================================================
+// FIRMWARE LZ PAGE PROPERTY HANDLER
+//======================================================================================================================
+
+/**
+ * \brief Serialize the property into a byte array.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[out] buf The byte array to serialize.
+ * \param[out] size The size of the byte array after serialization.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool firmware_lz_page_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_FIRMWARE_LZ_PAGE, buf, size)) {
+        return true;
+    }
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(module->firmware_update->compressed_size != 0, false, TAG, "Firmware page is not compressed");
+
+    *size = module->firmware_update->compressed_size + 2; /* 2 bytes for index */
+
+    /* Copy the index and compressed firmware page to the binary array. */
+    buf[0] = (module->firmware_update->index >> 8) & 0xFF;
+    buf[1] = module->firmware_update->index & 0xFF;
+    memcpy(buf + 2, module->firmware_update->data, *size - 2);
+
+    return true;
+}
+
 //======================================================================================================================
 // COMMAND PROPERTY HANDLER
 //======================================================================================================================
@@ -194,8 +232,8 @@ bool firmware_update_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -203,6 +241,9 @@ bool firmware_update_compare(const void *userdata_a, const void *userdata_b)
  */
 bool command_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_COMMAND, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
@@ -232,6 +273,7 @@ bool command_from_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(cJSON_IsString(json), false, TAG, "Expected a string");
 
     module->command = of_cmd_id_by_name(json->valuestring);
+    module_property_hash_update(module, OF_MDL_PROP_COMMAND);
     if (module->command != CMD_UNDEFINED) {
         return true;
     }
@@ -268,8 +310,8 @@ bool command_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -315,8 +357,8 @@ bool module_info_to_json(void *userdata, uint16_t node_idx, void *data)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -329,18 +371,16 @@ bool character_set_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, siz
 
     ESP_RETURN_ON_FALSE(*size % 4 == 0, false, TAG, "Invalid binary size, expected multiple of 4.");
 
-    /* Allocate memory for the character set. */
-    character_set_property_t *new_character_set = character_set_new(*size / 4);
+    /* Get the character set property, modules with the same character set share it. */
+    character_set_property_t *new_character_set = character_set_intern(buf, *size / 4);
     ESP_RETURN_ON_FALSE(new_character_set != NULL, false, TAG, "Memory allocation failed");
 
-    /* Free old character set. */
+    /* Release old character set. */
     character_set_free(module->character_set);
 
     /* Update the module with the new character set. */
     module->character_set = new_character_set;
-
-    /* Copy the binary array to the character set. */
-    memcpy(module->character_set->data, buf, module->character_set->size * 4);
+    module_property_hash_update(module, OF_MDL_PROP_CHARACTER_SET);
 
     return true;
 }
@@ -350,8 +390,8 @@ bool character_set_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, siz
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -359,6 +399,9 @@ bool character_set_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, siz
  */
 bool character_set_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_CHARACTER_SET, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
@@ -405,24 +448,31 @@ bool character_set_from_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(module->character_set->size == cJSON_GetArraySize(json), false, TAG,
                         "Expected a character set of size %d", module->character_set->size);
 
-    /* Allocate memory for the new character set. */
-    character_set_property_t *new_character_set = character_set_new(module->character_set->size);
-    ESP_RETURN_ON_FALSE(new_character_set != NULL, false, TAG, "Memory allocation failed");
-
-    /* Free the old character set. */
-    character_set_free(module->character_set);
-
-    /* Update the module with the new character set. */
-    module->character_set = new_character_set;
+    /* Collect the characters, the character set is interned once it is complete. */
+    uint8_t character_set_size = module->character_set->size;
+    uint8_t *characters        = calloc(character_set_size, 4);
+    ESP_RETURN_ON_FALSE(characters != NULL, false, TAG, "Memory allocation failed");
 
     /* Copy the character set from the json object. */
-    for (int i = 0; i < module->character_set->size; i++) {
+    for (int i = 0; i < character_set_size; i++) {
         /* Get new entry from json. */
         character_set_entry = cJSON_GetArrayItem(json, i);
         /* Copy new entry. */
-        strncpy((char *)(&module->character_set->data[i * 4]), character_set_entry->valuestring, 4);
+        strncpy((char *)(&characters[i * 4]), character_set_entry->valuestring, 4);
     }
 
+    /* Get the character set property, modules with the same character set share it. */
+    character_set_property_t *new_character_set = character_set_intern(characters, character_set_size);
+    free(characters);
+    ESP_RETURN_ON_FALSE(new_character_set != NULL, false, TAG, "Memory allocation failed");
+
+    /* Release the old character set. */
+    character_set_free(module->character_set);
+
+    /* Update the module with the new character set. */
+    module->character_set = new_character_set;
+    module_property_hash_update(module, OF_MDL_PROP_CHARACTER_SET);
+
     return true;
 }
 
@@ -499,8 +549,8 @@ bool character_set_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -511,7 +561,7 @@ bool character_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
-    module->character_index = buf[0];
+    of_module_character_index_set(module, buf[0]);
 
     return true;
 }
@@ -521,8 +571,8 @@ bool character_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -530,11 +580,14 @@ bool character_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t
  */
 bool character_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_CHARACTER, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
     *size  = 1; /* Only one byte, the character index. */
-    buf[0] = module->character_index;
+    buf[0] = module_character_index_get(module);
 
     return true;
 }
@@ -556,12 +609,13 @@ bool character_from_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
     cJSON *json = (cJSON *)data;
 
-    uint8_t *character_index = &module->character_index;
+    uint8_t character_index = 0;
 
     ESP_RETURN_ON_FALSE(cJSON_IsString(json), false, TAG, "Expected a character");
 
-    ESP_RETURN_ON_FALSE(module_character_set_index_of_character(module, character_index, json->valuestring) == ESP_OK,
+    ESP_RETURN_ON_FALSE(module_character_set_index_of_character(module, &character_index, json->valuestring) == ESP_OK,
                         false, TAG, "Character %s not in character set", json->valuestring);
+    of_module_character_index_set(module, character_index);
 
     return true;
 }
@@ -583,9 +637,9 @@ bool character_to_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
     cJSON **json = (cJSON **)data;
 
-    const uint8_t *character_index = &module->character_index;
+    const uint8_t character_index = module_character_index_get(module);
 
-    *json = cJSON_CreateString((const char *)&module->character_set->data[4 * (*character_index)]);
+    *json = cJSON_CreateString((const char *)&module->character_set->data[4 * character_index]);
     ESP_RETURN_ON_FALSE(*json != NULL, false, TAG, "Failed to create JSON string");
 
     return true;
@@ -605,8 +659,8 @@ bool character_compare(const void *userdata_a, const void *userdata_b)
 {
     ESP_RETURN_ON_FALSE(compare_handler_args_validate(userdata_a, userdata_b), false, TAG, "Invalid arguments");
 
-    const uint8_t character_index_a = ((const module_t *)userdata_a)->character_index;
-    const uint8_t character_index_b = ((const module_t *)userdata_b)->character_index;
+    const uint8_t character_index_a = module_character_index_get((const module_t *)userdata_a);
+    const uint8_t character_index_b = module_character_index_get((const module_t *)userdata_b);
 
     return character_index_a == character_index_b;
 }
@@ -618,8 +672,8 @@ bool character_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -630,7 +684,7 @@ bool offset_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
-    module->offset = buf[0];
+    of_module_offset_set(module, buf[0]);
 
     return true;
 }
@@ -640,8 +694,8 @@ bool offset_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -649,11 +703,14 @@ bool offset_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
  */
 bool offset_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_OFFSET, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
     *size  = 1;
-    buf[0] = module->offset;
+    buf[0] = module_offset_get(module);
 
     return true;
 }
@@ -679,7 +736,7 @@ bool offset_from_json(void *userdata, uint16_t node_idx, void *data)
 
     ESP_RETURN_ON_FALSE(json->valueint >= 0 && json->valueint <= 255, false, TAG, "Value out of range");
 
-    module->offset = json->valueint;
+    of_module_offset_set(module, json->valueint);
 
     return true;
 }
@@ -701,7 +758,7 @@ bool offset_to_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
     cJSON **json = (cJSON **)data;
 
-    *json = cJSON_CreateNumber(module->offset);
+    *json = cJSON_CreateNumber(module_offset_get(module));
     ESP_RETURN_ON_FALSE(*json != NULL, false, TAG, "Failed to create JSON number");
 
     return true;
@@ -721,8 +778,8 @@ bool offset_compare(const void *userdata_a, const void *userdata_b)
 {
     ESP_RETURN_ON_FALSE(compare_handler_args_validate(userdata_a, userdata_b), false, TAG, "Invalid arguments");
 
-    const uint8_t offset_a = ((const module_t *)userdata_a)->offset;
-    const uint8_t offset_b = ((const module_t *)userdata_b)->offset;
+    const uint8_t offset_a = module_offset_get((const module_t *)userdata_a);
+    const uint8_t offset_b = module_offset_get((const module_t *)userdata_b);
 
     return offset_a == offset_b;
 }
@@ -734,8 +791,8 @@ bool offset_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -746,12 +803,11 @@ bool color_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *siz
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
-    module->color.foreground.red   = buf[0];
-    module->color.foreground.green = buf[1];
-    module->color.foreground.blue  = buf[2];
-    module->color.background.red   = buf[3];
-    module->color.background.green = buf[4];
-    module->color.background.blue  = buf[5];
+    color_property_t color = {
+        .foreground = {.red = buf[0], .green = buf[1], .blue = buf[2]},
+        .background = {.red = buf[3], .green = buf[4], .blue = buf[5]},
+    };
+    of_module_color_set(module, &color);
 
     return true;
 }
@@ -761,8 +817,8 @@ bool color_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *siz
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -770,16 +826,21 @@ bool color_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *siz
  */
 bool color_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_COLOR, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
+    const color_property_t *color = module_color_get(module);
+
     *size  = 6;
-    buf[0] = module->color.foreground.red;
-    buf[1] = module->color.foreground.green;
-    buf[2] = module->color.foreground.blue;
-    buf[3] = module->color.background.red;
-    buf[4] = module->color.background.green;
-    buf[5] = module->color.background.blue;
+    buf[0] = color->foreground.red;
+    buf[1] = color->foreground.green;
+    buf[2] = color->foreground.blue;
+    buf[3] = color->background.red;
+    buf[4] = color->background.green;
+    buf[5] = color->background.blue;
     return true;
 }
 
@@ -811,8 +872,8 @@ bool color_from_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(json_to_color(&background, background_json) == ESP_OK, false, TAG,
                         "Failed to convert background color");
 
-    module->color.foreground = foreground;
-    module->color.background = background;
+    color_property_t color = {.foreground = foreground, .background = background};
+    of_module_color_set(module, &color);
 
     return true;
 }
@@ -834,13 +895,15 @@ bool color_to_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
     cJSON **json = (cJSON **)data;
 
+    const color_property_t *color = module_color_get(module);
+
     char fg_color_str[8] = {0};
     char bg_color_str[8] = {0};
 
     snprintf(fg_color_str, sizeof(fg_color_str), "#%06X",
-             module->color.foreground.red << 16 | module->color.foreground.green << 8 | module->color.foreground.blue);
+             color->foreground.red << 16 | color->foreground.green << 8 | color->foreground.blue);
     snprintf(bg_color_str, sizeof(bg_color_str), "#%06X",
-             module->color.background.red << 16 | module->color.background.green << 8 | module->color.background.blue);
+             color->background.red << 16 | color->background.green << 8 | color->background.blue);
 
     ESP_RETURN_ON_FALSE(cJSON_AddStringToObject(*json, "foreground", fg_color_str), false, TAG,
                         "Failed to create JSON string for foreground color");
@@ -864,8 +927,8 @@ bool color_compare(const void *userdata_a, const void *userdata_b)
 {
     ESP_RETURN_ON_FALSE(compare_handler_args_validate(userdata_a, userdata_b), false, TAG, "Invalid arguments");
 
-    const color_property_t *color_a = &((const module_t *)userdata_a)->color;
-    const color_property_t *color_b = &((const module_t *)userdata_b)->color;
+    const color_property_t *color_a = module_color_get((const module_t *)userdata_a);
+    const color_property_t *color_b = module_color_get((const module_t *)userdata_b);
 
     return memcmp(color_a, color_b, sizeof(color_property_t)) == 0;
 }
@@ -877,8 +940,8 @@ bool color_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -893,6 +956,7 @@ bool motion_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
     module->motion.speed_max           = buf[1];
     module->motion.distance_ramp_start = buf[2];
     module->motion.distance_ramp_stop  = buf[3];
+    module_property_hash_update(module, OF_MDL_PROP_MOTION);
 
     return true;
 }
@@ -902,8 +966,8 @@ bool motion_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -911,6 +975,9 @@ bool motion_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *si
  */
 bool motion_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_MOTION, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
@@ -962,6 +1029,7 @@ bool motion_from_json(void *userdata, uint16_t node_idx, void *data)
     module->motion.speed_max           = speed_max_json->valueint;
     module->motion.distance_ramp_start = ramp_start_json->valueint;
     module->motion.distance_ramp_stop  = ramp_stop_json->valueint;
+    module_property_hash_update(module, OF_MDL_PROP_MOTION);
 
     return true;
 }
@@ -1022,8 +1090,8 @@ bool motion_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -1035,6 +1103,7 @@ bool min_rotation_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
     module->minimum_rotation = buf[0];
+    module_property_hash_update(module, OF_MDL_PROP_MINIMUM_ROTATION);
 
     return true;
 }
@@ -1044,8 +1113,8 @@ bool min_rotation_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -1053,6 +1122,9 @@ bool min_rotation_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
  */
 bool min_rotation_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_MINIMUM_ROTATION, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
@@ -1083,6 +1155,7 @@ bool min_rotation_from_json(void *userdata, uint16_t node_idx, void *data)
     ESP_RETURN_ON_FALSE(json->valueint >= 0 && json->valueint <= 255, false, TAG, "Value out of range");
 
     module->minimum_rotation = json->valueint;
+    module_property_hash_update(module, OF_MDL_PROP_MINIMUM_ROTATION);
 
     return true;
 }
@@ -1138,8 +1211,8 @@ bool min_rotation_compare(const void *userdata_a, const void *userdata_b)
 /**
  * \brief Deserialize a byte array into a property.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The byte array to deserialize.
  * \param[in] size The size of the byte array.
  *
@@ -1152,6 +1225,7 @@ bool ir_threshold_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
 
     module->ir_threshold.lower = (uint16_t)buf[0] << 8 | (uint16_t)buf[1];
     module->ir_threshold.upper = (uint16_t)buf[2] << 8 | (uint16_t)buf[3];
+    module_property_hash_update(module, OF_MDL_PROP_IR_THRESHOLD);
 
     return true;
 }
@@ -1161,8 +1235,8 @@ bool ir_threshold_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
 /**
  * \brief Serialize the property into a byte array.
  *
- * \param[inout] userdata The display containing the module.
- * \param[in] node_idx The node index of the module in the display.
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[out] buf The byte array to serialize.
  * \param[out] size The size of the byte array after serialization.
  *
@@ -1170,6 +1244,9 @@ bool ir_threshold_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size
  */
 bool ir_threshold_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
 {
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_IR_THRESHOLD, buf, size)) {
+        return true;
+    }
     module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
     ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
 
@@ -1213,6 +1290,7 @@ bool ir_threshold_from_json(void *userdata, uint16_t node_idx, void *data)
 
     module->ir_threshold.lower = lower_json->valueint;
     module->ir_threshold.upper = upper_json->valueint;
+    module_property_hash_update(module, OF_MDL_PROP_IR_THRESHOLD);
 
     return true;
 }
@@ -1263,6 +1341,225 @@ bool ir_threshold_compare(const void *userdata_a, const void *userdata_b)
     return memcmp(ir_threshold_a, ir_threshold_b, sizeof(ir_threshold_property_t)) == 0;
 }
 
+//======================================================================================================================
+// BAUD RATE PROPERTY HANDLER
+//======================================================================================================================
+
+/**
+ * \brief Deserialize a byte array into a property.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[in] buf The byte array to deserialize.
+ * \param[in] size The size of the byte array.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool baud_rate_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+
+    module->baud_rate = (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16 | (uint32_t)buf[2] << 8 | (uint32_t)buf[3];
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Serialize the property into a byte array.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[out] buf The byte array to serialize.
+ * \param[out] size The size of the byte array after serialization.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool baud_rate_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+
+    *size  = 4;
+    buf[0] = module->baud_rate >> 24;
+    buf[1] = module->baud_rate >> 16;
+    buf[2] = module->baud_rate >> 8;
+    buf[3] = module->baud_rate & 0xFF;
+    return true;
+}
+
+//======================================================================================================================
+// FIRMWARE PAGE CRC PROPERTY HANDLER
+//======================================================================================================================
+
+/**
+ * \brief Deserialize a byte array into a property.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[in] buf The byte array to deserialize.
+ * \param[in] size The size of the byte array.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool firmware_page_crc_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(*size >= 3 + 4 * OF_FIRMWARE_PAGE_CRC_CNT, false, TAG, "Invalid size");
+
+    uint8_t region = buf[0];
+    uint16_t index = (uint16_t)buf[1] << 8 | buf[2];
+    ESP_RETURN_ON_FALSE(of_module_firmware_page_crc_window_set(module, region, index) == ESP_OK, false, TAG,
+                        "Failed to allocate property");
+
+    for (uint8_t i = 0; i < OF_FIRMWARE_PAGE_CRC_CNT; i++) {
+        const uint8_t *crc = &buf[3 + 4 * i];
+        module->firmware_page_crc->crc[i] =
+            (uint32_t)crc[0] << 24 | (uint32_t)crc[1] << 16 | (uint32_t)crc[2] << 8 | (uint32_t)crc[3];
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Serialize the property into a byte array.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[out] buf The byte array to serialize.
+ * \param[out] size The size of the byte array after serialization.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool firmware_page_crc_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_FIRMWARE_PAGE_CRC, buf, size)) {
+        return true;
+    }
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(module->firmware_page_crc != NULL, false, TAG, "No page window selected");
+
+    *size  = 3;
+    buf[0] = module->firmware_page_crc->region;
+    buf[1] = module->firmware_page_crc->index >> 8;
+    buf[2] = module->firmware_page_crc->index & 0xFF;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Compare the property of two modules.
+ *
+ * \param[in] module_a The first module to compare.
+ * \param[in] module_b The second module to compare.
+ *
+ * \return true if both modules select the same page window, false otherwise.
+ */
+bool firmware_page_crc_compare(const void *userdata_a, const void *userdata_b)
+{
+    ESP_RETURN_ON_FALSE(compare_handler_args_validate(userdata_a, userdata_b), false, TAG, "Invalid arguments");
+
+    const firmware_page_crc_property_t *page_crc_a = ((const module_t *)userdata_a)->firmware_page_crc;
+    const firmware_page_crc_property_t *page_crc_b = ((const module_t *)userdata_b)->firmware_page_crc;
+
+    if (page_crc_a == NULL || page_crc_b == NULL) {
+        return false;
+    }
+
+    return page_crc_a->region == page_crc_b->region && page_crc_a->index == page_crc_b->index;
+}
+
+//======================================================================================================================
+// FIRMWARE BURST PROPERTY HANDLER
+//======================================================================================================================
+
+/**
+ * \brief Deserialize a byte array into a property.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[in] buf The byte array to deserialize.
+ * \param[in] size The size of the byte array.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool firmware_burst_from_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(*size >= 2, false, TAG, "Invalid size");
+
+    uint16_t size_max = (uint16_t)buf[0] << 8 | buf[1];
+    ESP_RETURN_ON_FALSE(of_module_firmware_burst_size_max_set(module, size_max) == ESP_OK, false, TAG,
+                        "Failed to allocate property");
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Serialize the property into a byte array.
+ *
+ * \param[inout] userdata The display chain containing the module.
+ * \param[in] node_idx The node index of the module on the chain.
+ * \param[out] buf The byte array to serialize.
+ * \param[out] size The size of the byte array after serialization.
+ *
+ * \return true if the conversion was successful, false otherwise.
+ */
+bool firmware_burst_to_bin(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    if (display_chain_broadcast_value_get(userdata, OF_MDL_PROP_FIRMWARE_BURST, buf, size)) {
+        return true;
+    }
+    module_t *module = bin_handler_args_validate(userdata, node_idx, buf, size);
+    ESP_RETURN_ON_FALSE(module != NULL, false, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(module->firmware_burst != NULL && module->firmware_burst->data != NULL, false, TAG,
+                        "No firmware burst");
+
+    *size  = OF_FIRMWARE_BURST_HEADER_SIZE + module->firmware_burst->size;
+    buf[0] = module->firmware_burst->index >> 8;
+    buf[1] = module->firmware_burst->index & 0xFF;
+    memcpy(buf + OF_FIRMWARE_BURST_HEADER_SIZE, module->firmware_burst->data, module->firmware_burst->size);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Compare the property of two modules.
+ *
+ * \param[in] module_a The first module to compare.
+ * \param[in] module_b The second module to compare.
+ *
+ * \return true if both modules contain the same burst, false otherwise.
+ */
+bool firmware_burst_compare(const void *userdata_a, const void *userdata_b)
+{
+    ESP_RETURN_ON_FALSE(compare_handler_args_validate(userdata_a, userdata_b), false, TAG, "Invalid arguments");
+
+    const firmware_burst_property_t *burst_a = ((const module_t *)userdata_a)->firmware_burst;
+    const firmware_burst_property_t *burst_b = ((const module_t *)userdata_b)->firmware_burst;
+
+    if (burst_a == NULL || burst_b == NULL || burst_a->data == NULL || burst_b->data == NULL) {
+        return false;
+    }
+
+    if (burst_a->index != burst_b->index || burst_a->size != burst_b->size) {
+        return false;
+    }
+
+    /* The firmware update normally shares one buffer between all modules. */
+    return burst_a->data == burst_b->data || memcmp(burst_a->data, burst_b->data, burst_a->size) == 0;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 void of_property_handlers_init(void)
@@ -1332,6 +1629,30 @@ void of_property_handlers_init(void)
     mdl_prop_list[OF_MDL_PROP_IR_THRESHOLD].handler.get_alt = ir_threshold_to_json;
     mdl_prop_list[OF_MDL_PROP_IR_THRESHOLD].handler.set_alt = ir_threshold_from_json;
     mdl_prop_list[OF_MDL_PROP_IR_THRESHOLD].handler.compare = ir_threshold_compare;
+
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.set     = baud_rate_from_bin;
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.get     = baud_rate_to_bin;
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.get_alt = NULL; /* Not implemented : Negotiated by the master. */
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.set_alt = NULL; /* Not implemented : Negotiated by the master. */
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.compare = NULL; /* Not implemented : Negotiated by the master. */
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.set     = firmware_page_crc_from_bin;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.get     = firmware_page_crc_to_bin;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.get_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.set_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.compare = firmware_page_crc_compare;
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.set     = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.get     = firmware_lz_page_to_bin;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.get_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.set_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.compare = firmware_update_compare;
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.set     = firmware_burst_from_bin;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.get     = firmware_burst_to_bin;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.get_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.set_alt = NULL; /* Not implemented : Used by module OTA. */
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.compare = firmware_burst_compare;
 }
 //======================================================================================================================
 //                                                         PRIVATE FUNCTIONS
@@ -1340,8 +1661,8 @@ void of_property_handlers_init(void)
 /**
  * \brief Validate and extract the module from the binary handler arguments.
  *
- * \param[in] userdata The user data containing the display.
- * \param[in] node_idx The node index of the module.
+ * \param[in] userdata The user data containing the display chain.
+ * \param[in] node_idx The node index of the module on the chain.
  * \param[in] buf The binary buffer.
  * \param[in] size The size of the binary buffer.
  *
@@ -1352,7 +1673,7 @@ static module_t *bin_handler_args_validate(void *userdata, uint16_t node_idx, ui
     if (!userdata || !buf || !size) {
         return NULL;
     }
-    return display_module_get((of_display_t *)userdata, node_idx);
+    return display_chain_module_get((of_display_chain_t *)userdata, node_idx);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -1414,7 +1735,7 @@ static esp_err_t json_to_color(color_t *color, const cJSON *json)
     ESP_RETURN_ON_FALSE(color_str[0] == '#', ESP_ERR_INVALID_ARG, "HANDLER", "Invalid color string format");
 
     uint32_t color_value = 0;
-    ESP_RETURN_ON_FALSE(sscanf(color_str + 1, "%lx", &color_value), ESP_ERR_INVALID_ARG, TAG,
+    ESP_RETURN_ON_FALSE(sscanf(color_str + 1, "%" SCNx32, &color_value), ESP_ERR_INVALID_ARG, TAG,
                         "Failed to convert color string");
 
     color->red   = (color_value >> 16) & 0xFF;
@@ -47,6 +47,10 @@ void app_main(void)
     ESP_GOTO_ON_ERROR(of_display_init(&display), verify_firmware, TAG, "Failed to initialize OpenFlap display");
     ESP_LOGI(TAG, "Display initialized!");
 
+    /* Keep the display model fresh while the chain is idle. */
+    ESP_GOTO_ON_ERROR(of_display_background_refresh_start(&display, OF_DISPLAY_REFRESH_MAX_AGE_MS_DEFAULT),
+                      verify_firmware, TAG, "Failed to start display refresher");
+
     /* Start the web server. */
     webserver_ctx_t webserver_ctx;
     ESP_GOTO_ON_ERROR(webserver_init(&webserver_ctx), verify_firmware, TAG, "Failed to start web server");
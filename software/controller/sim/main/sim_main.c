@@ -0,0 +1,57 @@
+/**
+ * \file sim_main.c
+ * \brief Chain benchmark against the chain simulator.
+ *
+ * Discovers the simulated chains, then writes the character of a growing number of modules and prints the statistics
+ * of every synchronization pass. The chains are started from the OF_MDL_SIM_COL_CMD and OF_MDL_SIM_ROW_CMD
+ * environment variables.
+ */
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "openflap_display.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TAG "SIM"
+
+/** Timeout of a single synchronization, long enough for the longest simulated chains. */
+#define SIM_SYNC_TIMEOUT_MS (60000)
+
+void app_main(void)
+{
+    of_display_t display;
+    ESP_ERROR_CHECK(of_display_init(&display));
+
+    /* Read the characters of all modules to discover the chain length. */
+    ESP_ERROR_CHECK(display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER,
+                                                             PROPERTY_SYNC_METHOD_READ));
+    ESP_ERROR_CHECK(of_display_synchronize(&display, SIM_SYNC_TIMEOUT_MS));
+
+    uint16_t module_count = display_size_get(&display);
+    ESP_LOGI(TAG, "Discovered %d modules", module_count);
+
+    printf("dirty_modules, nodes_written, frames, tx_bytes, rx_bytes, rx_errors, baud_rate, duration_ms\n");
+    for (uint16_t dirty_cnt = 1; dirty_cnt <= module_count; dirty_cnt *= 2) {
+        /* Mark the first modules as dirty, the remaining modules are untouched. */
+        display_lock(&display);
+        for (uint16_t i = 0; i < dirty_cnt; i++) {
+            module_property_indicate_desynchronized(display_module_get(&display, i), OF_MDL_PROP_CHARACTER);
+        }
+        display_property_indicate_desynchronized(&display, OF_MDL_PROP_CHARACTER, PROPERTY_SYNC_METHOD_WRITE);
+        display_unlock(&display);
+        ESP_ERROR_CHECK(of_display_synchronize(&display, SIM_SYNC_TIMEOUT_MS));
+
+        of_mdl_master_sync_stats_t stats;
+        ESP_ERROR_CHECK(of_display_sync_stats_get(&display, &stats));
+        printf("%d, %d, %d, %" PRIu32 ", %" PRIu32 ", %" PRIu32 ", %" PRIu32 ", %" PRIu32 "\n", dirty_cnt,
+               stats.node_cnt, stats.frame_cnt, stats.tx_byte_cnt, stats.rx_byte_cnt, stats.rx_error_cnt,
+               stats.baud_rate, stats.duration_ms);
+    }
+
+    /* The chain simulators stop once their stdin is closed on exit. */
+    ESP_ERROR_CHECK(display_destroy(&display));
+    exit(EXIT_SUCCESS);
+}
@@ -24,6 +24,9 @@ typedef struct of_ctx_tag {
     uint16_t flap_distance;             /**< The distance between the current and target flap. */
     bool store_config;                  /**< Flag to store the configuration. */
     bool reboot;                        /**< Flag to indicate the module must perform a system reboot. */
+    uint32_t baud_rate_pending;         /**< Baud rate to apply once communication has finished, 0 if none. */
+    uint8_t page_crc_region;            /**< Firmware region reported by the firmware page CRC property. */
+    uint16_t page_crc_index;            /**< First page reported by the firmware page CRC property. */
     bool motor_active;                  /**< Flag to indicate if the motor is busy. */
     bool comms_active;                  /**< Flag to indicate if the communication is busy. */
     bool extend_revolution;             /**< Flag to indicate if the motor must make at least on revolution. */
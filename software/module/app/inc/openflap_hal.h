@@ -4,17 +4,22 @@
 
 #pragma once
 
+/* The chain simulator implements this API on the host, without the PY32 peripherals. */
+#ifndef OF_HAL_SIM
 #include "py32f0xx_bsp_clock.h"
 #include "py32f0xx_ll_adc.h"
 #include "py32f0xx_ll_bus.h"
 #include "py32f0xx_ll_comp.h"
+#include "py32f0xx_ll_crc.h"
 #include "py32f0xx_ll_dma.h"
 #include "py32f0xx_ll_flash.h"
 #include "py32f0xx_ll_gpio.h"
+#include "py32f0xx_ll_rcc.h"
 #include "py32f0xx_ll_system.h"
 #include "py32f0xx_ll_tim.h"
 #include "py32f0xx_ll_usart.h"
 #include "py32f0xx_ll_utils.h"
+#endif
 
 #include "hardware_setup.h"
 #include "openflap_config.h"
@@ -24,6 +29,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/** Highest UART baud rate supported by the module. Limited by how fast the main loop drains the UART DMA buffer. */
+#define OF_HAL_UART_BAUD_RATE_MAX (460800)
+
 /** Type for controlling the motor. */
 typedef struct {
     int16_t speed; /**< Motor speed and direction (-1000 to 1000). */
@@ -148,6 +156,44 @@ void of_hal_encoder_values_get(uint16_t *encoder_values);
  */
 void of_hal_uart_tx_pin_update(bool enable_secondary_tx);
 
+/**
+ * @brief Change the baud rate of the chain UART.
+ *
+ * @param[in] baud_rate The new baud rate.
+ */
+void of_hal_uart_baud_rate_set(uint32_t baud_rate);
+
+/**
+ * @brief Get the current baud rate of the chain UART.
+ *
+ * @return The current baud rate.
+ */
+uint32_t of_hal_uart_baud_rate_get(void);
+
+/**
+ * @brief Check the framing error flag of the chain UART.
+ *
+ * The flag is cleared by the next received byte, or when the baud rate changes.
+ *
+ * @return true if a framing error occurred, false otherwise.
+ */
+bool of_hal_uart_framing_error_get(void);
+
+/**
+ * @brief Transmit a break on the chain UART.
+ */
+void of_hal_uart_break_send(void);
+
+/**
+ * @brief Calculate the CRC of a block of memory with the CRC peripheral.
+ *
+ * @param[in] data The data to calculate the CRC of.
+ * @param[in] word_cnt The number of 32-bit words in the data.
+ *
+ * @return The CRC-32 (MPEG-2) of the data, fed as 32-bit words.
+ */
+uint32_t of_hal_crc_calculate(const uint32_t *data, size_t word_cnt);
+
 /**
  * @brief Store the current configuration in the flash memory.
  *
@@ -122,6 +122,25 @@ int main(void)
         /* Run madelink node. */
         mdl_node_tick(&of_ctx.mdl_node_ctx, of_hal_tick_count_get());
 
+        /* Apply a new baud rate once the message that requested it has been fully retransmitted. */
+        if (of_ctx.baud_rate_pending && !mdl_node_is_busy(&of_ctx.mdl_node_ctx) &&
+            uart_driver_tx_idle(&of_ctx.of_hal.uart_driver)) {
+            of_hal_uart_baud_rate_set(of_ctx.baud_rate_pending);
+            of_ctx.baud_rate_pending = 0;
+            printf("Baud rate set to %lu\n", of_hal_uart_baud_rate_get());
+        }
+
+        /* A framing error means this module is out of step with the chain, fall back to the default baud rate and
+         * pass the fallback on to the next module. The break is passed on even when this module already runs at the
+         * default baud rate, e.g. after a reset, the modules behind it may not. */
+        if (of_hal_uart_framing_error_get()) {
+            if (of_hal_uart_baud_rate_get() != OF_BAUD_RATE_DEFAULT) {
+                of_hal_uart_baud_rate_set(OF_BAUD_RATE_DEFAULT);
+                printf("Baud rate reverted to %d\n", OF_BAUD_RATE_DEFAULT);
+            }
+            of_hal_uart_break_send();
+        }
+
         /* Update the sense timer tick count. */
         sens_tick_curr = of_hal_sens_tick_count_get();
         if (sens_tick_curr != sens_tick_prev) {
@@ -5,6 +5,7 @@
 
 #include "openflap_hal.h"
 #include "flash.h"
+#include "openflap_properties.h"
 #include "rbuff.h"
 #include "uart_driver.h"
 
@@ -35,6 +36,7 @@ uint32_t systick_1ms_cnt       = 0;    /**< Counter for SysTick events. */
 uint32_t pwm_timer_tick_cnt    = 0;    /**< Counter for TIM3 update events. */
 uint32_t sens_timer_tick_cnt   = 0;    /**< Counter for TIM1 update events. */
 uart_driver_ctx_t *uart_driver = NULL; /**< Reference to uart driver to be used by interrupt handlers. */
+uint32_t uart_baud_rate        = OF_BAUD_RATE_DEFAULT; /**< Current baud rate of the chain UART. */
 
 /* ADC Input Capture DMA Buffer */
 volatile uint32_t adc_dma_buf[ENCODER_CHANNEL_COUNT] = {0};
@@ -67,6 +69,7 @@ void of_hal_init(of_hal_ctx_t *of_hal_ctx)
     BSP_RCC_HSI_24MConfig();
 
     LL_APB1_GRP2_EnableClock(LL_APB1_GRP2_PERIPH_SYSCFG);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_CRC);
 
     LL_SYSTICK_EnableIT(); /* Enable SysTick interrupt. */
 
@@ -236,6 +239,55 @@ void of_hal_uart_tx_pin_update(bool enable_secondary_tx)
 
 //----------------------------------------------------------------------------------------------------------------------
 
+void of_hal_uart_baud_rate_set(uint32_t baud_rate)
+{
+    LL_RCC_ClocksTypeDef rcc_clocks;
+    LL_RCC_GetSystemClocksFreq(&rcc_clocks);
+
+    LL_USART_Disable(USART1);
+    /* Nothing is received while the USART is disabled, a framing error at the old baud rate can be cleared safely. */
+    LL_USART_ClearFlag_FE(USART1);
+    LL_USART_SetBaudRate(USART1, rcc_clocks.PCLK1_Frequency, baud_rate);
+    LL_USART_Enable(USART1);
+    uart_baud_rate = baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_uart_baud_rate_get(void)
+{
+    return uart_baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_uart_framing_error_get(void)
+{
+    /* The flag is cleared by reading SR and then DR. The RX DMA reads DR for every received byte, so it clears the flag
+     * with the first byte after this check. Reading DR here would take a byte away from the DMA. */
+    return LL_USART_IsActiveFlag_FE(USART1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_uart_break_send(void)
+{
+    LL_USART_RequestBreakSending(USART1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_crc_calculate(const uint32_t *data, size_t word_cnt)
+{
+    LL_CRC_ResetCRCCalculationUnit(CRC);
+    for (size_t i = 0; i < word_cnt; ++i) {
+        LL_CRC_FeedData32(CRC, data[i]);
+    }
+    return LL_CRC_ReadData32(CRC);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 void of_hal_config_store(of_config_t *config)
 {
     flash_write(NVS_START_ADDR, (uint8_t *)config, sizeof(of_config_t));
@@ -545,7 +597,7 @@ static void of_hal_uart1_init(void)
 
     // Configure UART1
     LL_USART_InitTypeDef UART_InitStruct = {0};
-    UART_InitStruct.BaudRate             = 115200;
+    UART_InitStruct.BaudRate             = OF_BAUD_RATE_DEFAULT;
     UART_InitStruct.DataWidth            = LL_USART_DATAWIDTH_8B;
     UART_InitStruct.StopBits             = LL_USART_STOPBITS_1;
     UART_InitStruct.Parity               = LL_USART_PARITY_NONE;
@@ -1,5 +1,6 @@
 #include "property_handlers.h"
 #include "flash.h"
+#include "lzss.h"
 #include "memory_map.h"
 #include "openflap.h"
 
@@ -15,7 +16,73 @@ bool property_firmware_set(void *userdata, uint16_t node_idx, uint8_t *buf, size
     uint32_t addr_base   = (uint32_t)(APP_START_PTR + (NEW_APP * APP_SIZE / 4));
     uint32_t addr_offset = ((uint32_t)buf[0] << 8 | (uint32_t)buf[1]) * FLASH_PAGE_SIZE;
     uint32_t addr        = addr_base + addr_offset;
-    flash_write(addr, (buf + 2), FLASH_PAGE_SIZE);
+    /* Erase only this page, the other pages in the sector may already contain the new firmware. */
+    flash_page_erase(addr, 1);
+    flash_page_program(addr, buf + 2);
+    return true;
+}
+
+bool property_firmware_lz_page_set(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    uint16_t index = (uint16_t)buf[0] << 8 | buf[1];
+    if (*size < 3 || index >= APP_SIZE / FLASH_PAGE_SIZE) {
+        return false;
+    }
+
+    /* Matches reach back into the pages that were already written to the new app region. */
+    const uint8_t *region = (const uint8_t *)APP_N_START_PTR(NEW_APP);
+    uint8_t page[FLASH_PAGE_SIZE];
+    if (!lzss_decompress(buf + 2, *size - 2, page, FLASH_PAGE_SIZE, region, index * FLASH_PAGE_SIZE)) {
+        return false;
+    }
+
+    flash_page_erase((uint32_t)region + index * FLASH_PAGE_SIZE, 1);
+    flash_page_program((uint32_t)region + index * FLASH_PAGE_SIZE, page);
+    return true;
+}
+
+bool property_firmware_burst_set(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    uint16_t index    = (uint16_t)buf[0] << 8 | buf[1];
+    uint16_t page_cnt = 0;
+
+    /* Each page is preceded by its size, a page smaller than a flash page is compressed. Validate before erasing. */
+    for (size_t pos = OF_FIRMWARE_BURST_HEADER_SIZE; pos < *size; pos += 1 + buf[pos]) {
+        if (buf[pos] == 0 || buf[pos] > FLASH_PAGE_SIZE || pos + 1 + buf[pos] > *size) {
+            return false;
+        }
+        page_cnt++;
+    }
+    if (page_cnt == 0 || index + page_cnt > APP_SIZE / FLASH_PAGE_SIZE) {
+        return false;
+    }
+
+    /* Erase all pages of the burst at once, then program them in order. */
+    const uint8_t *region = (const uint8_t *)APP_N_START_PTR(NEW_APP);
+    uint32_t addr         = (uint32_t)region + index * FLASH_PAGE_SIZE;
+    flash_page_erase(addr, page_cnt);
+
+    uint8_t page[FLASH_PAGE_SIZE];
+    for (size_t pos = OF_FIRMWARE_BURST_HEADER_SIZE; pos < *size; pos += 1 + buf[pos], addr += FLASH_PAGE_SIZE) {
+        const uint8_t *data = buf + pos + 1;
+        if (buf[pos] < FLASH_PAGE_SIZE) {
+            /* Matches reach back into the pages that were already programmed, including those of this burst. */
+            if (!lzss_decompress(data, buf[pos], page, FLASH_PAGE_SIZE, region, addr - (uint32_t)region)) {
+                return false;
+            }
+            data = page;
+        }
+        flash_page_program(addr, data);
+    }
+    return true;
+}
+
+bool property_firmware_burst_get(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    /* Advertise the largest burst this module can receive. */
+    *size          = 0;
+    buf[(*size)++] = MDL_PAYLOAD_SIZE_MAX >> 8;
+    buf[(*size)++] = MDL_PAYLOAD_SIZE_MAX & 0xFF;
     return true;
 }
 
@@ -218,6 +285,61 @@ bool ir_threshold_property_get(void *userdata, uint16_t node_idx, uint8_t *buf,
     return true;
 }
 
+bool baud_rate_property_set(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    uint32_t baud_rate = (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16 | (uint32_t)buf[2] << 8 | (uint32_t)buf[3];
+    if (baud_rate < OF_BAUD_RATE_DEFAULT || baud_rate > OF_HAL_UART_BAUD_RATE_MAX) {
+        return false;
+    }
+    /* The baud rate is changed later to allow graceful end of communication. */
+    of_ctx->baud_rate_pending = baud_rate;
+    return true;
+}
+
+bool baud_rate_property_get(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    *size          = 0;
+    buf[(*size)++] = OF_HAL_UART_BAUD_RATE_MAX >> 24;
+    buf[(*size)++] = OF_HAL_UART_BAUD_RATE_MAX >> 16;
+    buf[(*size)++] = (OF_HAL_UART_BAUD_RATE_MAX >> 8) & 0xFF;
+    buf[(*size)++] = OF_HAL_UART_BAUD_RATE_MAX & 0xFF;
+    return true;
+}
+
+bool firmware_page_crc_property_set(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    uint8_t region = buf[0];
+    uint16_t index = (uint16_t)buf[1] << 8 | buf[2];
+    if (region > NEW_APP || index >= APP_SIZE / FLASH_PAGE_SIZE) {
+        return false;
+    }
+    of_ctx->page_crc_region = region;
+    of_ctx->page_crc_index  = index;
+    return true;
+}
+
+bool firmware_page_crc_property_get(void *userdata, uint16_t node_idx, uint8_t *buf, size_t *size)
+{
+    const uint16_t page_cnt = APP_SIZE / FLASH_PAGE_SIZE;
+    const uint32_t *region  = APP_N_START_PTR(of_ctx->page_crc_region);
+
+    *size          = 0;
+    buf[(*size)++] = of_ctx->page_crc_region;
+    buf[(*size)++] = of_ctx->page_crc_index >> 8;
+    buf[(*size)++] = of_ctx->page_crc_index & 0xFF;
+    for (uint16_t i = 0; i < OF_FIRMWARE_PAGE_CRC_CNT; i++) {
+        uint16_t page = of_ctx->page_crc_index + i;
+        /* Pages beyond the end of the region are reported as 0. */
+        uint32_t crc =
+            page < page_cnt ? of_hal_crc_calculate(region + page * FLASH_PAGE_SIZE / 4, FLASH_PAGE_SIZE / 4) : 0;
+        buf[(*size)++] = crc >> 24;
+        buf[(*size)++] = crc >> 16;
+        buf[(*size)++] = crc >> 8;
+        buf[(*size)++] = crc & 0xFF;
+    }
+    return true;
+}
+
 void property_handlers_init(of_ctx_t *ctx)
 {
     of_ctx = ctx;
@@ -254,4 +376,16 @@ void property_handlers_init(of_ctx_t *ctx)
 
     mdl_prop_list[OF_MDL_PROP_IR_THRESHOLD].handler.set = ir_threshold_property_set;
     mdl_prop_list[OF_MDL_PROP_IR_THRESHOLD].handler.get = ir_threshold_property_get;
+
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.set = baud_rate_property_set;
+    mdl_prop_list[OF_MDL_PROP_BAUD_RATE].handler.get = baud_rate_property_get;
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.set = firmware_page_crc_property_set;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_PAGE_CRC].handler.get = firmware_page_crc_property_get;
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.set = property_firmware_lz_page_set;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_LZ_PAGE].handler.get = NULL;
+
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.set = property_firmware_burst_set;
+    mdl_prop_list[OF_MDL_PROP_FIRMWARE_BURST].handler.get = property_firmware_burst_get;
 }
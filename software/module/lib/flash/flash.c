@@ -43,6 +43,30 @@ void flash_write(uint32_t address, uint8_t *data, uint32_t size)
     LL_FLASH_Lock();
 }
 
+void flash_page_erase(uint32_t address, uint32_t page_cnt)
+{
+    uint32_t page_error = 0;
+    FLASH_EraseInitTypeDef erase_init;
+    erase_init.TypeErase   = FLASH_TYPEERASE_PAGEERASE;
+    erase_init.PageAddress = address;
+    erase_init.NbPages     = page_cnt;
+
+    LL_FLASH_Unlock();
+    LL_FLASHEx_Erase(&erase_init, &page_error);
+    LL_FLASH_Lock();
+}
+
+void flash_page_program(uint32_t address, const uint8_t *data)
+{
+    // Copy to a word aligned page, the data may be unaligned
+    flash_page_t data_page;
+    memcpy(&data_page, data, sizeof(flash_page_t));
+
+    LL_FLASH_Unlock();
+    LL_FLASH_Program(FLASH_TYPEPROGRAM_PAGE, address, (uint32_t *)&data_page);
+    LL_FLASH_Lock();
+}
+
 static void flashErase(uint32_t address)
 {
     uint32_t SECTORError = 0;
@@ -10,5 +10,11 @@ typedef struct flash_page_t {
 /** Read from flash memory. */
 void flash_read(uint32_t address, uint8_t *data, uint32_t size);
 
-/** Write to flash memory. */
-void flash_write(uint32_t address, uint8_t *data, uint32_t size);
\ No newline at end of file
+/** Write to flash memory, erases a whole sector when the address is the start of a sector. */
+void flash_write(uint32_t address, uint8_t *data, uint32_t size);
+
+/** Erase a number of consecutive flash pages, starting at a page aligned address. */
+void flash_page_erase(uint32_t address, uint32_t page_cnt);
+
+/** Program a single erased flash page at a page aligned address. */
+void flash_page_program(uint32_t address, const uint8_t *data);
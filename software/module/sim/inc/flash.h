@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host replacement of the flash library, backed by the simulated flash of the chain simulator. */
+
+#define FLASH_PAGE_SIZE   (128)
+#define FLASH_SECTOR_SIZE (4096)
+
+/** Start address and size of the simulated flash, matching the PY32F003 memory map. */
+#define SIM_FLASH_BASE (0x08000000)
+#define SIM_FLASH_SIZE (0x10000)
+
+typedef struct flash_page_t {
+    uint32_t b32[FLASH_PAGE_SIZE / 4];
+} flash_page_t;
+
+/** Map the simulated flash at its real address and fill it with erased bytes. Returns 0 on success. */
+int sim_flash_init(void);
+
+/** Read from flash memory. */
+void flash_read(uint32_t address, uint8_t *data, uint32_t size);
+
+/** Write to flash memory, erases a whole sector when the address is the start of a sector. */
+void flash_write(uint32_t address, uint8_t *data, uint32_t size);
+
+/** Erase a number of consecutive flash pages, starting at a page aligned address. */
+void flash_page_erase(uint32_t address, uint32_t page_cnt);
+
+/** Program a single erased flash page at a page aligned address. */
+void flash_page_program(uint32_t address, const uint8_t *data);
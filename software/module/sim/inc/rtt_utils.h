@@ -0,0 +1,16 @@
+#pragma once
+
+/* The chain simulator has no debug probe, the RTT scope calls compile to nothing. */
+
+static inline void rtt_init(void) {}
+
+static inline void rtt_scope_init(char *scope_format)
+{
+    (void)scope_format;
+}
+
+static inline void rtt_scope_push(void *datapoints, unsigned size)
+{
+    (void)datapoints;
+    (void)size;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file sim_chain.h
+ * Simulated chain of OpenFlap modules.
+ *
+ * Every node runs the module's madelink node and property handlers against a simulated UART. Bytes travel between
+ * nodes in virtual time: a byte leaves a node one frame time (10 bits at the sender's baud rate) after the line became
+ * free and arrives at the next node after an additional forwarding delay. Nodes are ticked once per loop period while
+ * they have work to do, idle stretches are skipped.
+ */
+
+#pragma once
+
+#include "openflap.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of the UART DMA buffers of a node, equal to the buffers of the module firmware. */
+#define SIM_UART_BUF_LEN (64)
+
+/** A byte on a simulated UART line. */
+typedef struct {
+    uint64_t time_ns;   /**< Virtual time at which the byte has been fully received. */
+    uint32_t baud_rate; /**< Baud rate at which the byte was sent. */
+    uint8_t data;       /**< The byte. */
+    bool is_break;      /**< The sender transmitted a break instead of a byte. */
+} sim_byte_t;
+
+/** Growing FIFO of bytes on a simulated UART line. */
+typedef struct {
+    sim_byte_t *buf; /**< Storage of the FIFO. */
+    size_t capacity; /**< Number of bytes that fit in the storage. */
+    size_t head;     /**< Index of the oldest byte. */
+    size_t cnt;      /**< Number of bytes in the FIFO. */
+} sim_fifo_t;
+
+/** A simulated module. */
+typedef struct sim_node_tag {
+    of_ctx_t of_ctx;                                    /**< The OpenFlap context of the module. */
+    uint64_t time_ns;                                   /**< Virtual time of the current main loop pass. */
+    volatile uint8_t uart_rx_dma_buf[SIM_UART_BUF_LEN]; /**< UART RX DMA ring buffer. */
+    uint8_t uart_tx_buffer[SIM_UART_BUF_LEN];           /**< UART TX buffer for ring buffer. */
+    volatile uint8_t uart_tx_dma_buf[SIM_UART_BUF_LEN]; /**< UART TX DMA buffer. */
+    size_t uart_rx_dma_w;                               /**< Write offset of the RX DMA in the ring buffer. */
+    bool uart_tx_dma_busy;                              /**< A TX DMA transfer is on the line. */
+    uint64_t uart_tx_free_ns;                           /**< Virtual time at which the TX line becomes free. */
+    uint32_t uart_baud_rate;                            /**< Current baud rate of the UART. */
+    bool uart_framing_error;                            /**< A framing error occurred since it was last checked. */
+    bool is_column_end;                                 /**< The node is the last node of the chain. */
+    sim_fifo_t rx_fifo;                                 /**< Bytes on their way to this node. */
+    sim_fifo_t *tx_fifo;                                /**< Bytes on their way from this node to the next. */
+    uint64_t forward_delay_ns;                          /**< Delay added to every byte sent by this node. */
+} sim_node_t;
+
+/** A chain of simulated modules. */
+typedef struct {
+    sim_node_t *nodes;      /**< The nodes, in chain order. */
+    uint16_t node_cnt;      /**< Number of nodes. */
+    uint64_t time_ns;       /**< Current virtual time. */
+    uint64_t loop_ns;       /**< Duration of one pass through the main loop of a node. */
+    uint64_t input_free_ns; /**< Virtual time at which the line into the first node becomes free. */
+    sim_fifo_t output;      /**< Bytes sent by the last node. */
+    bool idle;              /**< No node has work to do and no bytes are on their way. */
+} sim_chain_t;
+
+/** The node that is currently being run, used by the simulated hardware abstraction layer. */
+extern sim_node_t *sim_node_current;
+
+/**
+ * @brief Create a chain of nodes, each initialized like the module firmware does at boot.
+ *
+ * @param[out] chain The chain.
+ * @param[in] node_cnt The number of nodes in the chain.
+ * @param[in] loop_ns The duration of one pass through the main loop of a node.
+ * @param[in] forward_delay_ns The delay added to every byte sent by a node.
+ *
+ * @return true on success, false if memory could not be allocated.
+ */
+bool sim_chain_init(sim_chain_t *chain, uint16_t node_cnt, uint64_t loop_ns, uint64_t forward_delay_ns);
+
+/**
+ * @brief Free the nodes of a chain.
+ *
+ * @param[inout] chain The chain.
+ */
+void sim_chain_deinit(sim_chain_t *chain);
+
+/**
+ * @brief Send bytes to the first node, back to back at the baud rate of the first node.
+ *
+ * @param[inout] chain The chain.
+ * @param[in] data The bytes.
+ * @param[in] size The number of bytes.
+ *
+ * @return The virtual time at which the last byte has been received by the first node.
+ */
+uint64_t sim_chain_input_write(sim_chain_t *chain, const uint8_t *data, size_t size);
+
+/**
+ * @brief Send a break to the first node.
+ *
+ * @param[inout] chain The chain.
+ */
+void sim_chain_input_break(sim_chain_t *chain);
+
+/**
+ * @brief Run all nodes until the virtual time has reached a deadline.
+ *
+ * @param[inout] chain The chain.
+ * @param[in] until_ns The deadline in virtual time.
+ */
+void sim_chain_run(sim_chain_t *chain, uint64_t until_ns);
+
+/**
+ * @brief Take the bytes that the last node has sent up to the current virtual time.
+ *
+ * @param[inout] chain The chain.
+ * @param[out] data Buffer for the bytes.
+ * @param[in] size The size of the buffer.
+ * @param[out] last_ns The virtual time at which the last returned byte was sent, may be NULL.
+ *
+ * @return The number of bytes taken.
+ */
+size_t sim_chain_output_read(sim_chain_t *chain, uint8_t *data, size_t size, uint64_t *last_ns);
+
+/**
+ * @brief Get the write pointer of the UART RX DMA of the current node.
+ *
+ * @return Pointer to the current write position in the UART RX DMA buffer.
+ */
+void *sim_uart_dma_w_ptr_get(void);
+
+/**
+ * @brief Put the contents of the UART TX DMA buffer of the current node on the line.
+ *
+ * @param[in] length The number of bytes to send.
+ */
+void sim_uart_tx_dma_start(size_t length);
+
+/**
+ * @brief Put a break on the UART TX line of the current node.
+ */
+void sim_uart_break_send(void);
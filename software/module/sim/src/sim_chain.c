@@ -0,0 +1,313 @@
+/**
+ * @file sim_chain.c
+ * Simulated chain of OpenFlap modules.
+ */
+
+#include "sim_chain.h"
+#include "property_handlers.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//======================================================================================================================
+//                                                  DEFINES AND CONSTS
+//======================================================================================================================
+
+/** Number of bits in a UART frame: start bit, 8 data bits and stop bit. */
+#define SIM_UART_FRAME_BITS (10)
+
+//======================================================================================================================
+//                                                   GLOBAL VARIABLES
+//======================================================================================================================
+
+sim_node_t *sim_node_current = NULL;
+
+//======================================================================================================================
+//                                                  FUNCTION PROTOTYPES
+//======================================================================================================================
+
+static bool sim_fifo_push(sim_fifo_t *fifo, sim_byte_t byte);     /**< Append a byte to a FIFO. */
+static sim_byte_t *sim_fifo_peek(sim_fifo_t *fifo);               /**< Get the oldest byte of a FIFO, or NULL. */
+static void sim_fifo_pop(sim_fifo_t *fifo);                       /**< Remove the oldest byte of a FIFO. */
+static uint64_t sim_frame_ns(uint32_t baud_rate);                 /**< Time it takes to send one byte. */
+static bool sim_node_run(sim_node_t *node, uint64_t now_ns, uint64_t *next_event_ns);
+
+//======================================================================================================================
+//                                                   PUBLIC FUNCTIONS
+//======================================================================================================================
+
+bool sim_chain_init(sim_chain_t *chain, uint16_t node_cnt, uint64_t loop_ns, uint64_t forward_delay_ns)
+{
+    memset(chain, 0, sizeof(*chain));
+    chain->nodes = calloc(node_cnt, sizeof(sim_node_t));
+    if (chain->nodes == NULL) {
+        return false;
+    }
+    chain->node_cnt = node_cnt;
+    chain->loop_ns  = loop_ns;
+    chain->idle     = true;
+
+    for (uint16_t i = 0; i < node_cnt; i++) {
+        sim_node_t *node       = &chain->nodes[i];
+        node->uart_baud_rate   = OF_BAUD_RATE_DEFAULT;
+        node->is_column_end    = (i == node_cnt - 1);
+        node->tx_fifo          = node->is_column_end ? &chain->output : &chain->nodes[i + 1].rx_fifo;
+        node->forward_delay_ns = forward_delay_ns;
+
+        /* Same start-up sequence as the module firmware, without the motor control. */
+        sim_node_current = node;
+        of_ctx_t *of_ctx = &node->of_ctx;
+        of_hal_init(&of_ctx->of_hal);
+        of_hal_config_load(&of_ctx->of_config);
+
+        mdl_node_uart_cb_cfg_t uart_cb = {.read          = (uart_read_cb_t)uart_driver_read,
+                                          .cnt_readable  = (uart_cnt_readable_cb_t)uart_driver_cnt_readable,
+                                          .write         = (uart_write_cb_t)uart_driver_write,
+                                          .cnt_writable  = (uart_cnt_writable_cb_t)uart_driver_cnt_writable,
+                                          .tx_buff_empty = (uart_tx_buff_empty_cb_t)uart_driver_tx_idle,
+                                          .is_busy       = (uart_is_busy_cb_t)uart_driver_is_busy};
+
+        mdl_node_init(&of_ctx->mdl_node_ctx, &uart_cb, &of_ctx->of_hal.uart_driver, mdl_prop_list, OF_MDL_PROP_CNT,
+                      of_ctx);
+
+        of_ctx->flap_position          = 0;
+        of_ctx->flap_setpoint          = 0;
+        of_ctx->motor_control_override = true;
+    }
+    sim_node_current = NULL;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void sim_chain_deinit(sim_chain_t *chain)
+{
+    for (uint16_t i = 0; i < chain->node_cnt; i++) {
+        free(chain->nodes[i].rx_fifo.buf);
+    }
+    free(chain->output.buf);
+    free(chain->nodes);
+    memset(chain, 0, sizeof(*chain));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t sim_chain_input_write(sim_chain_t *chain, const uint8_t *data, size_t size)
+{
+    sim_node_t *first = &chain->nodes[0];
+    for (size_t i = 0; i < size; i++) {
+        uint64_t start_ns    = chain->input_free_ns > chain->time_ns ? chain->input_free_ns : chain->time_ns;
+        chain->input_free_ns = start_ns + sim_frame_ns(first->uart_baud_rate);
+        sim_fifo_push(&first->rx_fifo, (sim_byte_t){.time_ns   = chain->input_free_ns,
+                                                    .baud_rate = first->uart_baud_rate,
+                                                    .data      = data[i]});
+    }
+    chain->idle = false;
+    return chain->input_free_ns;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void sim_chain_input_break(sim_chain_t *chain)
+{
+    sim_node_t *first    = &chain->nodes[0];
+    uint64_t start_ns    = chain->input_free_ns > chain->time_ns ? chain->input_free_ns : chain->time_ns;
+    chain->input_free_ns = start_ns + 2 * sim_frame_ns(first->uart_baud_rate);
+    sim_fifo_push(&first->rx_fifo, (sim_byte_t){.time_ns = chain->input_free_ns, .is_break = true});
+    chain->idle = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void sim_chain_run(sim_chain_t *chain, uint64_t until_ns)
+{
+    while (chain->time_ns < until_ns) {
+        bool active            = false;
+        uint64_t next_event_ns = UINT64_MAX;
+        for (uint16_t i = 0; i < chain->node_cnt; i++) {
+            active |= sim_node_run(&chain->nodes[i], chain->time_ns, &next_event_ns);
+        }
+        sim_node_current = NULL;
+
+        chain->idle = !active && next_event_ns == UINT64_MAX;
+        if (active) {
+            chain->time_ns += chain->loop_ns;
+        } else {
+            /* Nothing to do until the next byte arrives, skip ahead. */
+            chain->time_ns = next_event_ns < until_ns ? next_event_ns : until_ns;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t sim_chain_output_read(sim_chain_t *chain, uint8_t *data, size_t size, uint64_t *last_ns)
+{
+    size_t cnt = 0;
+    sim_byte_t *byte;
+    while (cnt < size && (byte = sim_fifo_peek(&chain->output)) != NULL && byte->time_ns <= chain->time_ns) {
+        if (!byte->is_break) {
+            data[cnt++] = byte->data;
+            if (last_ns != NULL) {
+                *last_ns = byte->time_ns;
+            }
+        }
+        sim_fifo_pop(&chain->output);
+    }
+    return cnt;
+}
+
+//======================================================================================================================
+//                                               SIMULATED UART HARDWARE
+//======================================================================================================================
+
+void *sim_uart_dma_w_ptr_get(void)
+{
+    return (void *)(sim_node_current->uart_rx_dma_buf + sim_node_current->uart_rx_dma_w);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void sim_uart_tx_dma_start(size_t length)
+{
+    sim_node_t *node  = sim_node_current;
+    uint64_t now_ns   = node->uart_tx_free_ns;
+    uint64_t frame_ns = sim_frame_ns(node->uart_baud_rate);
+    for (size_t i = 0; i < length; i++) {
+        now_ns += frame_ns;
+        sim_fifo_push(node->tx_fifo, (sim_byte_t){.time_ns   = now_ns + node->forward_delay_ns,
+                                                  .baud_rate = node->uart_baud_rate,
+                                                  .data      = node->uart_tx_dma_buf[i]});
+    }
+    node->uart_tx_free_ns  = now_ns;
+    node->uart_tx_dma_busy = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void sim_uart_break_send(void)
+{
+    sim_node_t *node      = sim_node_current;
+    node->uart_tx_free_ns = node->uart_tx_free_ns + 2 * sim_frame_ns(node->uart_baud_rate);
+    sim_fifo_push(node->tx_fifo, (sim_byte_t){.time_ns = node->uart_tx_free_ns + node->forward_delay_ns,
+                                              .is_break = true});
+}
+
+//======================================================================================================================
+//                                                   PRIVATE FUNCTIONS
+//======================================================================================================================
+
+static bool sim_fifo_push(sim_fifo_t *fifo, sim_byte_t byte)
+{
+    if (fifo->cnt == fifo->capacity) {
+        size_t capacity = fifo->capacity ? 2 * fifo->capacity : 256;
+        sim_byte_t *buf = malloc(capacity * sizeof(sim_byte_t));
+        if (buf == NULL) {
+            return false;
+        }
+        for (size_t i = 0; i < fifo->cnt; i++) {
+            buf[i] = fifo->buf[(fifo->head + i) % fifo->capacity];
+        }
+        free(fifo->buf);
+        fifo->buf      = buf;
+        fifo->capacity = capacity;
+        fifo->head     = 0;
+    }
+    fifo->buf[(fifo->head + fifo->cnt) % fifo->capacity] = byte;
+    fifo->cnt++;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static sim_byte_t *sim_fifo_peek(sim_fifo_t *fifo)
+{
+    return fifo->cnt ? &fifo->buf[fifo->head] : NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void sim_fifo_pop(sim_fifo_t *fifo)
+{
+    fifo->head = (fifo->head + 1) % fifo->capacity;
+    fifo->cnt--;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static uint64_t sim_frame_ns(uint32_t baud_rate)
+{
+    return (SIM_UART_FRAME_BITS * 1000000000ULL + baud_rate - 1) / baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Run one pass of the main loop of a node, if it has work to do.
+ *
+ * @param[inout] node The node.
+ * @param[in] now_ns The current virtual time.
+ * @param[inout] next_event_ns Lowered to the time of the next pending event of this node.
+ *
+ * @return true if the node has work to do.
+ */
+static bool sim_node_run(sim_node_t *node, uint64_t now_ns, uint64_t *next_event_ns)
+{
+    sim_node_current = node;
+    node->time_ns    = now_ns;
+    of_ctx_t *of_ctx = &node->of_ctx;
+
+    /* The TX line is free again, the driver may start the next transfer. */
+    if (node->uart_tx_dma_busy && node->uart_tx_free_ns <= now_ns) {
+        node->uart_tx_dma_busy = false;
+        uart_driver_tx_dma_transfer_complete(&of_ctx->of_hal.uart_driver);
+    }
+    if (!node->uart_tx_dma_busy && node->uart_tx_free_ns < now_ns) {
+        node->uart_tx_free_ns = now_ns;
+    }
+
+    /* Receive the bytes that have arrived, a byte sent at another baud rate is a framing error. Like the real DMA, the
+     * ring buffer is overwritten when the main loop does not keep up. */
+    sim_byte_t *byte;
+    while ((byte = sim_fifo_peek(&node->rx_fifo)) != NULL && byte->time_ns <= now_ns) {
+        if (byte->is_break || byte->baud_rate != node->uart_baud_rate) {
+            node->uart_framing_error = true;
+        } else {
+            node->uart_rx_dma_buf[node->uart_rx_dma_w] = byte->data;
+            node->uart_rx_dma_w                        = (node->uart_rx_dma_w + 1) % SIM_UART_BUF_LEN;
+        }
+        sim_fifo_pop(&node->rx_fifo);
+    }
+
+    if (byte != NULL && byte->time_ns < *next_event_ns) {
+        *next_event_ns = byte->time_ns;
+    }
+    if (node->uart_tx_dma_busy && node->uart_tx_free_ns < *next_event_ns) {
+        *next_event_ns = node->uart_tx_free_ns;
+    }
+
+    bool active = uart_driver_is_busy(&of_ctx->of_hal.uart_driver) || mdl_node_is_busy(&of_ctx->mdl_node_ctx) ||
+                  of_ctx->baud_rate_pending || node->uart_framing_error;
+    if (!active) {
+        return false;
+    }
+
+    /* The property handlers serve one module at a time. */
+    property_handlers_init(of_ctx);
+    mdl_node_tick(&of_ctx->mdl_node_ctx, of_hal_tick_count_get());
+
+    /* Same baud rate handling as the main loop of the module firmware. */
+    if (of_ctx->baud_rate_pending && !mdl_node_is_busy(&of_ctx->mdl_node_ctx) &&
+        uart_driver_tx_idle(&of_ctx->of_hal.uart_driver)) {
+        of_hal_uart_baud_rate_set(of_ctx->baud_rate_pending);
+        of_ctx->baud_rate_pending = 0;
+    }
+
+    if (of_hal_uart_framing_error_get()) {
+        of_hal_uart_baud_rate_set(OF_BAUD_RATE_DEFAULT);
+        of_hal_uart_break_send();
+    }
+
+    return true;
+}
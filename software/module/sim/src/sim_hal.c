@@ -0,0 +1,258 @@
+/**
+ * @file sim_hal.c
+ * Openflap hardware abstraction layer of the chain simulator.
+ *
+ * Every call acts on the node that is currently being run by the chain simulator. Time is the virtual time of the
+ * chain, the motor and the encoder are not simulated.
+ */
+
+#include "flash.h"
+#include "memory_map.h"
+#include "openflap.h"
+#include "sim_chain.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+//======================================================================================================================
+//                                                  DEFINES AND CONSTS
+//======================================================================================================================
+
+/** Polynomial of the CRC peripheral: CRC-32/MPEG-2. */
+#define CRC32_POLY (0x04C11DB7)
+
+/** The default configuration, loaded into the simulated flash at start-up. */
+extern const of_config_t config;
+
+/* Emit the external definition of the inline function of openflap.h, the host build does not always inline it. */
+extern inline uint16_t flapIndex_wrap_calc(int16_t index);
+
+//======================================================================================================================
+//                                                   PUBLIC FUNCTIONS
+//======================================================================================================================
+
+void of_hal_init(of_hal_ctx_t *of_hal_ctx)
+{
+    sim_node_t *node = sim_node_current;
+    uart_driver_init(&of_hal_ctx->uart_driver, node->uart_rx_dma_buf, SIM_UART_BUF_LEN, node->uart_tx_buffer,
+                     SIM_UART_BUF_LEN, node->uart_tx_dma_buf, SIM_UART_BUF_LEN, sim_uart_dma_w_ptr_get,
+                     sim_uart_tx_dma_start);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_deinit(void)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_tick_count_get(void)
+{
+    return (uint32_t)(sim_node_current->time_ns / 1000000);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_pwm_tick_count_get(void)
+{
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_sens_tick_count_get(void)
+{
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_debug_pin_set(uint8_t pin, bool value)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_debug_pin_toggle(uint8_t pin)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_debug_pin_get(uint8_t pin)
+{
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_led_set(bool value)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_led_toggle()
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_motor_control(int16_t speed, int16_t decay)
+{
+    sim_node_current->of_ctx.of_hal.motor.speed = speed;
+    sim_node_current->of_ctx.of_hal.motor.decay = decay;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_motor_is_running(void)
+{
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_is_column_end(void)
+{
+    return sim_node_current->is_column_end;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_is_12V_ok(void)
+{
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_encoder_values_get(uint16_t *encoder_values)
+{
+    memset(encoder_values, 0, ENCODER_CHANNEL_COUNT * sizeof(uint16_t));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_uart_tx_pin_update(bool enable_secondary_tx)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_uart_baud_rate_set(uint32_t baud_rate)
+{
+    sim_node_current->uart_baud_rate = baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_uart_baud_rate_get(void)
+{
+    return sim_node_current->uart_baud_rate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool of_hal_uart_framing_error_get(void)
+{
+    bool framing_error                   = sim_node_current->uart_framing_error;
+    sim_node_current->uart_framing_error = false;
+    return framing_error;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_uart_break_send(void)
+{
+    sim_uart_break_send();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t of_hal_crc_calculate(const uint32_t *data, size_t word_cnt)
+{
+    /* Software version of the CRC peripheral: words are fed most significant bit first, without reflection. */
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < word_cnt; ++i) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ CRC32_POLY : crc << 1;
+        }
+    }
+    return crc;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_config_store(of_config_t *config)
+{
+    flash_write(NVS_START_ADDR, (uint8_t *)config, sizeof(of_config_t));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_config_load(of_config_t *config)
+{
+    flash_read(NVS_START_ADDR, (uint8_t *)config, sizeof(of_config_t));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void of_hal_ir_timer_idle_set(bool idle)
+{
+}
+
+//======================================================================================================================
+//                                                    SIMULATED FLASH
+//======================================================================================================================
+
+int sim_flash_init(void)
+{
+    /* The property handlers access the firmware regions through their real addresses, so the simulated flash is
+     * mapped at the address of the flash of the module. All nodes share this single flash. */
+    void *flash = mmap((void *)SIM_FLASH_BASE, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (flash != (void *)SIM_FLASH_BASE) {
+        perror("Failed to map the simulated flash");
+        return -1;
+    }
+    memset(flash, 0xFF, SIM_FLASH_SIZE);
+    flash_write(NVS_START_ADDR, (uint8_t *)&config, sizeof(of_config_t));
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void flash_read(uint32_t address, uint8_t *data, uint32_t size)
+{
+    memcpy(data, (void *)(uintptr_t)address, size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void flash_write(uint32_t address, uint8_t *data, uint32_t size)
+{
+    if (!(address % FLASH_SECTOR_SIZE)) {
+        memset((void *)(uintptr_t)address, 0xFF, FLASH_SECTOR_SIZE);
+    }
+    memcpy((void *)(uintptr_t)address, data, size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void flash_page_erase(uint32_t address, uint32_t page_cnt)
+{
+    memset((void *)(uintptr_t)address, 0xFF, page_cnt * FLASH_PAGE_SIZE);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void flash_page_program(uint32_t address, const uint8_t *data)
+{
+    memcpy((void *)(uintptr_t)address, data, FLASH_PAGE_SIZE);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file sim_main.c
+ * Chain simulator: a chain of OpenFlap modules on the standard streams.
+ *
+ * The controller drives the simulator with commands on stdin, all numbers in host byte order:
+ *  - 'W', uint16_t size, bytes: the bytes enter the first node, back to back from the current virtual time.
+ *  - 'B': a break is sent to the first node.
+ *  - 'R', uint16_t size, uint32_t timeout_us: run until the last node has sent size bytes or until the timeout has
+ *    passed after the line into the first node became free.
+ *  - 'D', uint16_t size, uint32_t timeout_us: like 'R', but always run until the timeout.
+ * Every 'R' and 'D' is answered on stdout with the virtual time in ns (uint64_t), the number of bytes (uint16_t) and
+ * the bytes sent by the last node. Virtual time only advances on these commands, so the controller's timeouts and
+ * statistics follow the simulated chain. When the chain becomes idle, the bytes and modeled duration of the exchange
+ * are printed to stderr, these figures only depend on the simulated chain and not on the load of the host.
+ */
+
+#include "flash.h"
+#include "sim_chain.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//======================================================================================================================
+//                                                  DEFINES AND CONSTS
+//======================================================================================================================
+
+#define SIM_CMD_WRITE ('W') /**< Write bytes to the first node. */
+#define SIM_CMD_BREAK ('B') /**< Send a break to the first node. */
+#define SIM_CMD_READ  ('R') /**< Read bytes from the last node, ends as soon as all bytes are read. */
+#define SIM_CMD_WAIT  ('D') /**< Read bytes from the last node, ends at the timeout. */
+
+/** Size of the answer to a read: the virtual time, the number of bytes and the bytes. */
+#define SIM_REPLY_HDR_LEN (sizeof(uint64_t) + sizeof(uint16_t))
+#define SIM_REPLY_LEN     (SIM_REPLY_HDR_LEN + UINT16_MAX)
+
+/** Number of simulated modules supported. */
+#define SIM_NODE_CNT_MAX (2000)
+
+//======================================================================================================================
+//                                                   PRIVATE FUNCTIONS
+//======================================================================================================================
+
+static bool sim_read_all(int fd, void *data, size_t size)
+{
+    uint8_t *buf = data;
+    while (size) {
+        ssize_t cnt = read(fd, buf, size);
+        if (cnt == 0 || (cnt < 0 && errno != EINTR)) {
+            return false;
+        }
+        if (cnt > 0) {
+            buf += cnt;
+            size -= cnt;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool sim_write_all(int fd, const uint8_t *data, size_t size)
+{
+    while (size) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno != EINTR) {
+            return false;
+        }
+        if (written > 0) {
+            data += written;
+            size -= written;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Run the chain for a read or wait command and collect the bytes sent by the last node.
+ *
+ * @param[inout] chain The chain.
+ * @param[out] data Buffer for the bytes.
+ * @param[in] size The number of bytes to read.
+ * @param[in] timeout_ns The timeout, starting when the line into the first node becomes free.
+ * @param[in] wait Keep running until the timeout, even when all bytes have been read.
+ * @param[out] last_ns The virtual time at which the last returned byte was sent.
+ *
+ * @return The number of bytes read.
+ */
+static size_t sim_exchange(sim_chain_t *chain, uint8_t *data, size_t size, uint64_t timeout_ns, bool wait,
+                           uint64_t *last_ns)
+{
+    uint64_t start_ns = chain->input_free_ns > chain->time_ns ? chain->input_free_ns : chain->time_ns;
+    uint64_t until_ns = start_ns + timeout_ns;
+
+    size_t cnt = sim_chain_output_read(chain, data, size, last_ns);
+    while (chain->time_ns < until_ns && (wait || cnt < size)) {
+        /* Stop after every main loop pass to return the bytes as soon as they are sent. */
+        uint64_t step_ns = (chain->idle && !chain->output.cnt) ? until_ns : chain->time_ns + chain->loop_ns;
+        sim_chain_run(chain, step_ns < until_ns ? step_ns : until_ns);
+        cnt += sim_chain_output_read(chain, data + cnt, size - cnt, last_ns);
+    }
+    return cnt;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void sim_usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-n nodes] [-d forward_delay_us] [-l loop_us]\n"
+            "  -n  Number of modules in the chain, 1 to %d (default 1).\n"
+            "  -d  Delay added to every byte forwarded by a module, in microseconds (default 0).\n"
+            "  -l  Duration of one pass through the main loop of a module, in microseconds (default 10).\n",
+            name, SIM_NODE_CNT_MAX);
+}
+
+//======================================================================================================================
+//                                                         MAIN
+//======================================================================================================================
+
+int main(int argc, char **argv)
+{
+    long node_cnt         = 1;
+    long forward_delay_us = 0;
+    long loop_us          = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:l:")) != -1) {
+        switch (opt) {
+            case 'n':
+                node_cnt = strtol(optarg, NULL, 0);
+                break;
+            case 'd':
+                forward_delay_us = strtol(optarg, NULL, 0);
+                break;
+            case 'l':
+                loop_us = strtol(optarg, NULL, 0);
+                break;
+            default:
+                sim_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (node_cnt < 1 || node_cnt > SIM_NODE_CNT_MAX || forward_delay_us < 0 || loop_us < 1) {
+        sim_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* stdout carries the chain data, everything the module firmware prints goes to stderr. */
+    int chain_out_fd = dup(STDOUT_FILENO);
+    if (chain_out_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        perror("Failed to redirect stdout");
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (sim_flash_init() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    sim_chain_t chain;
+    if (!sim_chain_init(&chain, node_cnt, loop_us * 1000ULL, forward_delay_us * 1000ULL)) {
+        fprintf(stderr, "Failed to create a chain of %ld modules\n", node_cnt);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Simulating %ld modules, forward delay %ld us, loop %ld us\n", node_cnt, forward_delay_us,
+            loop_us);
+
+    /* Statistics of the exchange in progress. */
+    size_t rx_byte_cnt = 0, tx_byte_cnt = 0;
+    uint64_t first_in_ns = 0, last_out_ns = 0;
+
+    static uint8_t buf[SIM_REPLY_LEN];
+    uint8_t cmd;
+
+    /* Commands are handled until the controller closes stdin. */
+    while (sim_read_all(STDIN_FILENO, &cmd, sizeof(cmd))) {
+        uint16_t size       = 0;
+        uint32_t timeout_us = 0;
+        if (cmd == SIM_CMD_BREAK) {
+            sim_chain_input_break(&chain);
+            continue;
+        }
+        if ((cmd == SIM_CMD_WRITE || cmd == SIM_CMD_READ || cmd == SIM_CMD_WAIT) &&
+            !sim_read_all(STDIN_FILENO, &size, sizeof(size))) {
+            break;
+        }
+
+        if (cmd == SIM_CMD_WRITE) {
+            if (!sim_read_all(STDIN_FILENO, buf, size)) {
+                break;
+            }
+            if (chain.idle && !chain.output.cnt) {
+                first_in_ns = chain.time_ns;
+                rx_byte_cnt = tx_byte_cnt = 0;
+            }
+            sim_chain_input_write(&chain, buf, size);
+            rx_byte_cnt += size;
+        } else if (cmd == SIM_CMD_READ || cmd == SIM_CMD_WAIT) {
+            if (!sim_read_all(STDIN_FILENO, &timeout_us, sizeof(timeout_us))) {
+                break;
+            }
+            uint16_t cnt = sim_exchange(&chain, buf + SIM_REPLY_HDR_LEN, size, timeout_us * 1000ULL,
+                                        cmd == SIM_CMD_WAIT, &last_out_ns);
+            memcpy(buf, &chain.time_ns, sizeof(chain.time_ns));
+            memcpy(buf + sizeof(chain.time_ns), &cnt, sizeof(cnt));
+            if (!sim_write_all(chain_out_fd, buf, SIM_REPLY_HDR_LEN + cnt)) {
+                break;
+            }
+            tx_byte_cnt += cnt;
+
+            if (chain.idle && !chain.output.cnt && rx_byte_cnt) {
+                fprintf(stderr, "Exchange: %zu bytes in, %zu bytes out, %.3f ms\n", rx_byte_cnt, tx_byte_cnt,
+                        tx_byte_cnt ? (last_out_ns - first_in_ns) / 1e6 : 0.0);
+                rx_byte_cnt = tx_byte_cnt = 0;
+            }
+        } else {
+            fprintf(stderr, "Unknown command 0x%02x\n", cmd);
+            break;
+        }
+    }
+
+    sim_chain_deinit(&chain);
+    return EXIT_SUCCESS;
+}